@@ -0,0 +1,840 @@
+/***********************************************************************
+ * Header:
+ *    BITMAP SET
+ * Summary:
+ *    A set of small integers kept as bits
+ *
+ *    This will contain the class definition of:
+ *        bitmap_set           : A set of integers in compressed bitmaps
+ *        bitmap_set::iterator : An iterator through bitmap_set
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>     // for size_t and std::ptrdiff_t
+#include <cstdint>     // for uint16_t, uint32_t and uint64_t
+#include <algorithm>   // for std::lower_bound, std::set_union and std::set_intersection
+#include <functional>  // for std::less
+#include <iterator>    // for std::forward_iterator_tag and std::back_inserter
+#include <type_traits> // for std::is_integral and std::is_signed
+#include <utility>     // for std::pair and std::swap
+#include <vector>      // for std::vector
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>    // for __popcnt64 and _BitScanForward64
+#endif
+
+class TestBitmapSet; // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * BITMAP SET
+ * A set of integers of up to 32 bits, stored the way Roaring bitmaps
+ * are. The top 16 bits of an element pick a chunk and the bottom 16
+ * are kept in it, one of two ways:
+ *    array  : the low halves sorted, 2 bytes each, while there are at
+ *             most 4096 of them
+ *    bitmap : one bit for each of the 65536 low halves, 8 KB, once
+ *             there are more
+ * Either way a chunk costs at most 2 bytes an element, where a BNode
+ * costs 40 and more. Dense runs cost one bit each.
+ *
+ * Membership is a bit test or a binary search of at most 4096 shorts,
+ * after a binary search of the chunks. size() is kept as we go; after
+ * a union or intersection it is added back up a word at a time with
+ * popcount. Those two combine a pair of bitmaps a word at a time with
+ * plain loops the compiler turns into SIMD.
+ *
+ * Elements come out of the iterator in order, by value: there is no
+ * T stored to point at. Inserting or erasing invalidates every iterator
+ ***********************************************/
+template <typename T>
+class bitmap_set
+{
+   static_assert(std::is_integral<T>::value && sizeof(T) <= 4,
+                 "bitmap_set holds integers of 32 bits or less");
+
+   friend class ::TestBitmapSet; // give unit tests access to the privates
+
+public:
+   using key_compare = std::less<T>;
+
+   //
+   // Construct
+   //
+
+   bitmap_set() : chunks(), numElements(0)
+   {
+   }
+   bitmap_set(const std::initializer_list <T> & il) : chunks(), numElements(0)
+   {
+      insert(il.begin(), il.end());
+   }
+   template <class Iterator>
+   bitmap_set(Iterator first, Iterator last) : chunks(), numElements(0)
+   {
+      insert(first, last);
+   }
+   bitmap_set(const bitmap_set & rhs)     = default;
+   bitmap_set(bitmap_set && rhs) noexcept : chunks(std::move(rhs.chunks)),
+      numElements(rhs.numElements)
+   {
+      rhs.numElements = 0;
+   }
+
+   //
+   // Assign
+   //
+
+   bitmap_set & operator = (const bitmap_set & rhs) = default;
+   bitmap_set & operator = (bitmap_set && rhs) noexcept
+   {
+      clear();
+      swap(rhs);
+      return *this;
+   }
+   bitmap_set & operator = (const std::initializer_list <T> & il)
+   {
+      clear();
+      insert(il.begin(), il.end());
+      return *this;
+   }
+   void swap(bitmap_set & rhs) noexcept
+   {
+      chunks.swap(rhs.chunks);
+      std::swap(numElements, rhs.numElements);
+   }
+
+   //
+   // Iterator
+   //
+
+   class iterator;
+   using const_iterator = iterator;   // elements are never changed in place
+   iterator begin() const noexcept { return firstIn(0);                   }
+   iterator end()   const noexcept { return iterator(this, chunks.size(), 0); }
+
+   //
+   // Access
+   //
+
+   iterator find(const T & t) const;
+   iterator lower_bound(const T & t) const;
+   iterator upper_bound(const T & t) const;
+   std::pair<iterator, iterator> equal_range(const T & t) const
+   {
+      return std::pair<iterator, iterator>(lower_bound(t), upper_bound(t));
+   }
+   size_t count(const T & t)    const { return contains(t) ? 1 : 0; }
+   bool   contains(const T & t) const;
+
+   // the smallest and largest elements: not for an empty set
+   T front() const;
+   T back()  const;
+
+   //
+   // Insert
+   //
+
+   std::pair<iterator, bool> insert(const T & t);
+   void insert(const std::initializer_list <T> & il)
+   {
+      insert(il.begin(), il.end());
+   }
+   template <class Iterator>
+   void insert(Iterator first, Iterator last)
+   {
+      for (; first != last; ++first)
+      {
+         insert(*first);
+      }
+   }
+
+   //
+   // Remove
+   //
+
+   size_t erase(const T & t);
+   void clear() noexcept
+   {
+      chunks.clear();
+      numElements = 0;
+   }
+
+   //
+   // Status
+   //
+
+   bool   empty() const noexcept { return numElements == 0; }
+   size_t size()  const noexcept { return numElements;      }
+   key_compare key_comp() const  { return key_compare();    }
+
+   // bytes of memory the set is holding on to, headers and all
+   size_t bytes() const noexcept;
+
+   //
+   // Set algebra, in place
+   //
+
+   void merge (const bitmap_set & rhs);
+   void retain(const bitmap_set & rhs);
+
+private:
+
+   // a chunk holds at most this many low halves as an array
+   static constexpr size_t numArrayMax = 4096;
+   // and 65536 bits as a bitmap
+   static constexpr size_t numWords = 65536 / 64;
+
+   // the elements whose top 16 bits are key, as one of the two kinds
+   struct Chunk
+   {
+      explicit Chunk(uint16_t key) : key(key), num(0), array(), bits()
+      {
+      }
+      bool isBitmap() const noexcept { return !bits.empty(); }
+
+      uint16_t key;                  // the top 16 bits of every element here
+      uint32_t num;                  // how many elements: up to 65536
+      std::vector <uint16_t> array;  // sorted low halves, when not a bitmap
+      std::vector <uint64_t> bits;   // one bit per low half, when a bitmap
+   };
+
+   // elements are kept as unsigned 32 bits that sort the same way:
+   // a signed element has its sign bit flipped
+   static uint32_t toKey(T t) noexcept
+   {
+      return std::is_signed<T>::value ?
+         static_cast<uint32_t>(static_cast<int32_t>(t)) ^ 0x80000000u :
+         static_cast<uint32_t>(t);
+   }
+   static T fromKey(uint32_t key) noexcept
+   {
+      return std::is_signed<T>::value ?
+         static_cast<T>(static_cast<int32_t>(key ^ 0x80000000u)) :
+         static_cast<T>(key);
+   }
+
+   // where the chunk for key would be
+   size_t chunkFor(uint16_t key) const;
+
+   // the first element at or after low in a chunk: 65536 when none
+   static uint32_t nextIn(const Chunk & chunk, uint32_t low);
+
+   iterator firstIn(size_t iChunk) const;
+
+   static bool insertIn(Chunk & chunk, uint16_t low);
+   static bool eraseIn(Chunk & chunk, uint16_t low);
+   static void toBitmap(Chunk & chunk);
+   static void toArray(Chunk & chunk);
+   static void fit(Chunk & chunk);
+
+   static void mergeChunk (Chunk & chunk, const Chunk & rhs);
+   static void retainChunk(Chunk & chunk, const Chunk & rhs);
+
+   static size_t countBits(uint64_t word) noexcept;
+   static size_t lowestBit(uint64_t word) noexcept;
+
+   std::vector <Chunk> chunks;   // sorted by key, none of them empty
+   size_t numElements;           // number of elements
+};
+
+/**************************************************
+ * BITMAP SET ITERATOR
+ * Which chunk we are in and where in it: an index into an array, or
+ * the low half itself in a bitmap
+ *************************************************/
+template <typename T>
+class bitmap_set <T> :: iterator
+{
+   friend class ::TestBitmapSet; // give unit tests access to the privates
+   friend class custom::bitmap_set <T>;
+
+public:
+   using iterator_category = std::forward_iterator_tag;
+   using value_type        = T;
+   using difference_type   = std::ptrdiff_t;
+   using pointer           = void;
+   using reference         = T;
+
+   iterator() : pSet(nullptr), iChunk(0), position(0)
+   {
+   }
+
+   bool operator == (const iterator & rhs) const
+   {
+      return iChunk == rhs.iChunk && position == rhs.position;
+   }
+   bool operator != (const iterator & rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   T operator * () const
+   {
+      const Chunk & chunk = pSet->chunks[iChunk];
+      uint32_t low = chunk.isBitmap() ? position : chunk.array[position];
+      return fromKey(((uint32_t)chunk.key << 16) | low);
+   }
+
+   iterator & operator ++ ()
+   {
+      const Chunk & chunk = pSet->chunks[iChunk];
+      if (chunk.isBitmap())
+      {
+         position = (position + 1 < 65536) ? nextIn(chunk, position + 1) : 65536;
+         if (position < 65536)
+            return *this;
+      }
+      else if (++position < chunk.array.size())
+      {
+         return *this;
+      }
+      *this = pSet->firstIn(iChunk + 1);
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator itReturn(*this);
+      ++*this;
+      return itReturn;
+   }
+
+private:
+   iterator(const bitmap_set * pSet, size_t iChunk, uint32_t position) :
+      pSet(pSet), iChunk(iChunk), position(position)
+   {
+   }
+
+   const bitmap_set * pSet;
+   size_t iChunk;         // which chunk, or chunks.size() for end()
+   uint32_t position;     // index into an array, or the low half in a bitmap
+};
+
+/*********************************************
+ * BITMAP SET :: COUNT BITS and LOWEST BIT
+ * The population count and the index of the lowest set bit of a word
+ * that is not zero, with the instruction when the compiler has one
+ ********************************************/
+template <typename T>
+size_t bitmap_set <T> :: countBits(uint64_t word) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+   return (size_t)__builtin_popcountll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   return (size_t)__popcnt64(word);
+#else
+   size_t num = 0;
+   for (; word; word &= word - 1)
+      num++;
+   return num;
+#endif
+}
+
+template <typename T>
+size_t bitmap_set <T> :: lowestBit(uint64_t word) noexcept
+{
+   assert(word != 0);
+#if defined(__GNUC__) || defined(__clang__)
+   return (size_t)__builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   unsigned long index;
+   _BitScanForward64(&index, word);
+   return (size_t)index;
+#else
+   size_t index = 0;
+   for (; !(word & 1); word >>= 1)
+      index++;
+   return index;
+#endif
+}
+
+/*********************************************
+ * BITMAP SET :: CHUNK FOR
+ * The index of the chunk holding key, or of the one after where it
+ * would go
+ ********************************************/
+template <typename T>
+size_t bitmap_set <T> :: chunkFor(uint16_t key) const
+{
+   auto it = std::lower_bound(chunks.begin(), chunks.end(), key,
+                              [](const Chunk & chunk, uint16_t key)
+                              {
+                                 return chunk.key < key;
+                              });
+   return it - chunks.begin();
+}
+
+/*********************************************
+ * BITMAP SET :: NEXT IN
+ * The first low half at or after low in a chunk, or 65536. For an
+ * array this is where in the array, for a bitmap the low half itself
+ ********************************************/
+template <typename T>
+uint32_t bitmap_set <T> :: nextIn(const Chunk & chunk, uint32_t low)
+{
+   if (!chunk.isBitmap())
+   {
+      auto it = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+      return it == chunk.array.end() ? 65536 : (uint32_t)(it - chunk.array.begin());
+   }
+
+   size_t iWord = low / 64;
+   uint64_t word = chunk.bits[iWord] & (~(uint64_t)0 << (low % 64));
+   while (word == 0)
+   {
+      if (++iWord == numWords)
+         return 65536;
+      word = chunk.bits[iWord];
+   }
+   return (uint32_t)(iWord * 64 + lowestBit(word));
+}
+
+/*********************************************
+ * BITMAP SET :: FIRST IN
+ * The first element in chunk iChunk or later
+ ********************************************/
+template <typename T>
+typename bitmap_set <T> :: iterator bitmap_set <T> :: firstIn(size_t iChunk) const
+{
+   if (iChunk >= chunks.size())
+      return end();
+   return iterator(this, iChunk, chunks[iChunk].isBitmap() ? nextIn(chunks[iChunk], 0) : 0);
+}
+
+/*********************************************
+ * BITMAP SET :: CONTAINS
+ * Is t in the set? A bit test or a short binary search
+ ********************************************/
+template <typename T>
+bool bitmap_set <T> :: contains(const T & t) const
+{
+   uint32_t key = toKey(t);
+   size_t iChunk = chunkFor((uint16_t)(key >> 16));
+   if (iChunk == chunks.size() || chunks[iChunk].key != (key >> 16))
+      return false;
+
+   const Chunk & chunk = chunks[iChunk];
+   uint16_t low = (uint16_t)key;
+   if (chunk.isBitmap())
+      return (chunk.bits[low / 64] >> (low % 64)) & 1;
+   return std::binary_search(chunk.array.begin(), chunk.array.end(), low);
+}
+
+/*********************************************
+ * BITMAP SET :: LOWER BOUND
+ * The first element not less than t
+ ********************************************/
+template <typename T>
+typename bitmap_set <T> :: iterator bitmap_set <T> :: lower_bound(const T & t) const
+{
+   uint32_t key = toKey(t);
+   size_t iChunk = chunkFor((uint16_t)(key >> 16));
+   if (iChunk == chunks.size() || chunks[iChunk].key != (key >> 16))
+      return firstIn(iChunk);
+
+   uint32_t position = nextIn(chunks[iChunk], key & 0xffff);
+   return position < 65536 ? iterator(this, iChunk, position) : firstIn(iChunk + 1);
+}
+
+/*********************************************
+ * BITMAP SET :: UPPER BOUND
+ * The first element greater than t
+ ********************************************/
+template <typename T>
+typename bitmap_set <T> :: iterator bitmap_set <T> :: upper_bound(const T & t) const
+{
+   iterator it = lower_bound(t);
+   if (it != end() && *it == t)
+      ++it;
+   return it;
+}
+
+/*********************************************
+ * BITMAP SET :: FIND
+ * The element equal to t, or end()
+ ********************************************/
+template <typename T>
+typename bitmap_set <T> :: iterator bitmap_set <T> :: find(const T & t) const
+{
+   iterator it = lower_bound(t);
+   return (it != end() && *it == t) ? it : end();
+}
+
+/*********************************************
+ * BITMAP SET :: FRONT and BACK
+ * The smallest and the largest elements
+ ********************************************/
+template <typename T>
+T bitmap_set <T> :: front() const
+{
+   assert(!chunks.empty());
+   return *begin();
+}
+
+template <typename T>
+T bitmap_set <T> :: back() const
+{
+   assert(!chunks.empty());
+   const Chunk & chunk = chunks.back();
+   uint32_t low;
+   if (chunk.isBitmap())
+   {
+      size_t iWord = numWords - 1;
+      while (chunk.bits[iWord] == 0)
+         iWord--;
+      size_t iBit = 63;
+      while (!((chunk.bits[iWord] >> iBit) & 1))
+         iBit--;
+      low = (uint32_t)(iWord * 64 + iBit);
+   }
+   else
+   {
+      low = chunk.array.back();
+   }
+   return fromKey(((uint32_t)chunk.key << 16) | low);
+}
+
+/*********************************************
+ * BITMAP SET :: INSERT
+ * Add t unless it is already there, starting a chunk if it needs one
+ ********************************************/
+template <typename T>
+std::pair<typename bitmap_set <T> :: iterator, bool> bitmap_set <T> :: insert(const T & t)
+{
+   uint32_t key = toKey(t);
+   uint16_t high = (uint16_t)(key >> 16);
+   size_t iChunk = chunkFor(high);
+   if (iChunk == chunks.size() || chunks[iChunk].key != high)
+   {
+      chunks.insert(chunks.begin() + iChunk, Chunk(high));
+   }
+
+   bool inserted = insertIn(chunks[iChunk], (uint16_t)key);
+   if (inserted)
+   {
+      numElements++;
+   }
+   uint32_t position = nextIn(chunks[iChunk], key & 0xffff);
+   return std::pair<iterator, bool>(iterator(this, iChunk, position), inserted);
+}
+
+/*********************************************
+ * BITMAP SET :: ERASE
+ * Remove t if it is there, and its chunk if that leaves it empty
+ ********************************************/
+template <typename T>
+size_t bitmap_set <T> :: erase(const T & t)
+{
+   uint32_t key = toKey(t);
+   uint16_t high = (uint16_t)(key >> 16);
+   size_t iChunk = chunkFor(high);
+   if (iChunk == chunks.size() || chunks[iChunk].key != high ||
+       !eraseIn(chunks[iChunk], (uint16_t)key))
+   {
+      return 0;
+   }
+
+   numElements--;
+   if (chunks[iChunk].num == 0)
+   {
+      chunks.erase(chunks.begin() + iChunk);
+   }
+   return 1;
+}
+
+/*********************************************
+ * BITMAP SET :: INSERT IN
+ * Add low to a chunk, turning a full array into a bitmap
+ ********************************************/
+template <typename T>
+bool bitmap_set <T> :: insertIn(Chunk & chunk, uint16_t low)
+{
+   if (!chunk.isBitmap())
+   {
+      auto it = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+      if (it != chunk.array.end() && *it == low)
+         return false;
+      if (chunk.array.size() < numArrayMax)
+      {
+         chunk.array.insert(it, low);
+         chunk.num++;
+         return true;
+      }
+      toBitmap(chunk);
+   }
+
+   uint64_t & word = chunk.bits[low / 64];
+   uint64_t bit = (uint64_t)1 << (low % 64);
+   if (word & bit)
+      return false;
+   word |= bit;
+   chunk.num++;
+   return true;
+}
+
+/*********************************************
+ * BITMAP SET :: ERASE IN
+ * Remove low from a chunk, turning a bitmap that has thinned out
+ * back into an array
+ ********************************************/
+template <typename T>
+bool bitmap_set <T> :: eraseIn(Chunk & chunk, uint16_t low)
+{
+   if (!chunk.isBitmap())
+   {
+      auto it = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+      if (it == chunk.array.end() || *it != low)
+         return false;
+      chunk.array.erase(it);
+      chunk.num--;
+      return true;
+   }
+
+   uint64_t & word = chunk.bits[low / 64];
+   uint64_t bit = (uint64_t)1 << (low % 64);
+   if (!(word & bit))
+      return false;
+   word &= ~bit;
+   chunk.num--;
+   fit(chunk);
+   return true;
+}
+
+/*********************************************
+ * BITMAP SET :: TO BITMAP and TO ARRAY
+ * Change how a chunk is kept, handing back the memory of the old way
+ ********************************************/
+template <typename T>
+void bitmap_set <T> :: toBitmap(Chunk & chunk)
+{
+   chunk.bits.assign(numWords, 0);
+   for (uint16_t low : chunk.array)
+      chunk.bits[low / 64] |= (uint64_t)1 << (low % 64);
+   std::vector <uint16_t> ().swap(chunk.array);
+}
+
+template <typename T>
+void bitmap_set <T> :: toArray(Chunk & chunk)
+{
+   chunk.array.reserve(chunk.num);
+   for (size_t iWord = 0; iWord < numWords; iWord++)
+   {
+      for (uint64_t word = chunk.bits[iWord]; word; word &= word - 1)
+         chunk.array.push_back((uint16_t)(iWord * 64 + lowestBit(word)));
+   }
+   std::vector <uint64_t> ().swap(chunk.bits);
+}
+
+// a bitmap small enough to be an array becomes one
+template <typename T>
+void bitmap_set <T> :: fit(Chunk & chunk)
+{
+   if (chunk.isBitmap() && chunk.num <= numArrayMax)
+      toArray(chunk);
+}
+
+/*********************************************
+ * BITMAP SET :: MERGE CHUNK
+ * Every low half in either chunk, into chunk. Two bitmaps are ORed a
+ * word at a time and counted with popcount
+ ********************************************/
+template <typename T>
+void bitmap_set <T> :: mergeChunk(Chunk & chunk, const Chunk & rhs)
+{
+   if (!chunk.isBitmap() && !rhs.isBitmap())
+   {
+      std::vector <uint16_t> array;
+      array.reserve(chunk.array.size() + rhs.array.size());
+      std::set_union(chunk.array.begin(), chunk.array.end(),
+                     rhs.array.begin(), rhs.array.end(), std::back_inserter(array));
+      chunk.array.swap(array);
+      chunk.num = (uint32_t)chunk.array.size();
+      if (chunk.num > numArrayMax)
+         toBitmap(chunk);
+      return;
+   }
+
+   if (!chunk.isBitmap())
+      toBitmap(chunk);
+   if (rhs.isBitmap())
+   {
+      uint64_t * pBits = chunk.bits.data();
+      const uint64_t * pBitsRHS = rhs.bits.data();
+      for (size_t i = 0; i < numWords; i++)
+         pBits[i] |= pBitsRHS[i];
+   }
+   else
+   {
+      for (uint16_t low : rhs.array)
+         chunk.bits[low / 64] |= (uint64_t)1 << (low % 64);
+   }
+
+   size_t num = 0;
+   for (size_t i = 0; i < numWords; i++)
+      num += countBits(chunk.bits[i]);
+   chunk.num = (uint32_t)num;
+}
+
+/*********************************************
+ * BITMAP SET :: RETAIN CHUNK
+ * Only the low halves in both chunks, into chunk. Two bitmaps are
+ * ANDed a word at a time; an array against a bitmap keeps the array
+ * elements whose bits are set
+ ********************************************/
+template <typename T>
+void bitmap_set <T> :: retainChunk(Chunk & chunk, const Chunk & rhs)
+{
+   if (chunk.isBitmap() && rhs.isBitmap())
+   {
+      uint64_t * pBits = chunk.bits.data();
+      const uint64_t * pBitsRHS = rhs.bits.data();
+      for (size_t i = 0; i < numWords; i++)
+         pBits[i] &= pBitsRHS[i];
+      size_t num = 0;
+      for (size_t i = 0; i < numWords; i++)
+         num += countBits(pBits[i]);
+      chunk.num = (uint32_t)num;
+      fit(chunk);
+      return;
+   }
+
+   std::vector <uint16_t> array;
+   if (chunk.isBitmap() || rhs.isBitmap())
+   {
+      const Chunk & chunkArray  = chunk.isBitmap() ? rhs : chunk;
+      const Chunk & chunkBitmap = chunk.isBitmap() ? chunk : rhs;
+      array.reserve(chunkArray.array.size());
+      for (uint16_t low : chunkArray.array)
+         if ((chunkBitmap.bits[low / 64] >> (low % 64)) & 1)
+            array.push_back(low);
+      std::vector <uint64_t> ().swap(chunk.bits);
+   }
+   else
+   {
+      std::set_intersection(chunk.array.begin(), chunk.array.end(),
+                            rhs.array.begin(), rhs.array.end(), std::back_inserter(array));
+   }
+   chunk.array.swap(array);
+   chunk.num = (uint32_t)chunk.array.size();
+}
+
+/*********************************************
+ * BITMAP SET :: MERGE
+ * Add every element of rhs. One walk over both lists of chunks
+ ********************************************/
+template <typename T>
+void bitmap_set <T> :: merge(const bitmap_set & rhs)
+{
+   std::vector <Chunk> chunksNew;
+   chunksNew.reserve(chunks.size() + rhs.chunks.size());
+   size_t i = 0;
+   size_t iRHS = 0;
+   while (i < chunks.size() || iRHS < rhs.chunks.size())
+   {
+      if (iRHS == rhs.chunks.size() ||
+          (i < chunks.size() && chunks[i].key < rhs.chunks[iRHS].key))
+      {
+         chunksNew.push_back(std::move(chunks[i++]));
+      }
+      else if (i == chunks.size() || rhs.chunks[iRHS].key < chunks[i].key)
+      {
+         chunksNew.push_back(rhs.chunks[iRHS++]);
+      }
+      else
+      {
+         mergeChunk(chunks[i], rhs.chunks[iRHS++]);
+         chunksNew.push_back(std::move(chunks[i++]));
+      }
+   }
+
+   chunks.swap(chunksNew);
+   numElements = 0;
+   for (const Chunk & chunk : chunks)
+      numElements += chunk.num;
+}
+
+/*********************************************
+ * BITMAP SET :: RETAIN
+ * Keep only the elements also in rhs. Chunks rhs does not have go
+ * without being looked at
+ ********************************************/
+template <typename T>
+void bitmap_set <T> :: retain(const bitmap_set & rhs)
+{
+   std::vector <Chunk> chunksNew;
+   size_t iRHS = 0;
+   for (Chunk & chunk : chunks)
+   {
+      while (iRHS < rhs.chunks.size() && rhs.chunks[iRHS].key < chunk.key)
+         iRHS++;
+      if (iRHS == rhs.chunks.size())
+         break;
+      if (rhs.chunks[iRHS].key != chunk.key)
+         continue;
+
+      retainChunk(chunk, rhs.chunks[iRHS]);
+      if (chunk.num != 0)
+         chunksNew.push_back(std::move(chunk));
+   }
+
+   chunks.swap(chunksNew);
+   numElements = 0;
+   for (const Chunk & chunk : chunks)
+      numElements += chunk.num;
+}
+
+/*********************************************
+ * BITMAP SET :: BYTES
+ * The memory this set holds: itself, its list of chunks, and what
+ * each chunk has allocated
+ ********************************************/
+template <typename T>
+size_t bitmap_set <T> :: bytes() const noexcept
+{
+   size_t num = sizeof(*this) + chunks.capacity() * sizeof(Chunk);
+   for (const Chunk & chunk : chunks)
+      num += chunk.array.capacity() * sizeof(uint16_t) + chunk.bits.capacity() * sizeof(uint64_t);
+   return num;
+}
+
+/***********************************************
+ * BITMAP SET : UNION and INTERSECTION
+ ***********************************************/
+template <typename T>
+bitmap_set <T> set_union(const bitmap_set <T> & lhs, const bitmap_set <T> & rhs)
+{
+   bitmap_set <T> s(lhs);
+   s.merge(rhs);
+   return s;
+}
+
+template <typename T>
+bitmap_set <T> set_intersection(const bitmap_set <T> & lhs, const bitmap_set <T> & rhs)
+{
+   bitmap_set <T> s(lhs.size() <= rhs.size() ? lhs : rhs);
+   s.retain(lhs.size() <= rhs.size() ? rhs : lhs);
+   return s;
+}
+
+/***********************************************
+ * BITMAP SET : EQUIVALENCE
+ * Same elements
+ ***********************************************/
+template <typename T>
+bool operator == (const bitmap_set <T> & lhs, const bitmap_set <T> & rhs)
+{
+   return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T>
+inline bool operator != (const bitmap_set <T> & lhs, const bitmap_set <T> & rhs)
+{
+   return !(lhs == rhs);
+}
+
+} // namespace custom
@@ -0,0 +1,274 @@
+/***********************************************************************
+ * Header:
+ *    BLOOM FILTER
+ * Summary:
+ *    A blocked Bloom filter: is an element certainly not in a set?
+ *
+ *    This will contain the class definition of:
+ *        BloomFilterStats     : How well a filter has been doing
+ *        BloomFilter          : Split-block Bloom filter over elements
+ *        DefaultFilterHash    : The hash a set gives its filter
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cassert>
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint32_t and uint64_t
+#include <functional>  // for std::hash and std::less
+#include <vector>      // for std::vector
+
+class TestSet;         // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * BLOOM FILTER STATS
+ * How a filter has been doing since it was last built
+ ***********************************************/
+struct BloomFilterStats
+{
+   size_t numQueries;         // lookups that asked the filter
+   size_t numRejected;        // answered without going to the tree
+   size_t numFalsePositives;  // let through but not in the set
+   size_t numStale;           // erased since the build, bits still set
+   size_t numBits;            // size of the filter
+
+   // of the lookups for elements not in the set, the share that got
+   // past the filter anyway
+   double falsePositiveRate() const
+   {
+      size_t numAbsent = numRejected + numFalsePositives;
+      return numAbsent == 0 ? 0.0 : (double)numFalsePositives / (double)numAbsent;
+   }
+};
+
+/************************************************
+ * BLOOM FILTER
+ * Answers "certainly not there" or "maybe there" about an element
+ * from one cache line. The bits are split into 64-byte blocks: an
+ * element hashes to one block and sets one bit in each of its eight
+ * words, so a lookup is one miss at most and no branches.
+ *
+ * Bits are never cleared. An element erased from the set keeps its
+ * bits until rebuild(), which makes it a false positive, never a false
+ * negative.
+ *
+ * Two elements equivalent under the set's Compare must have the same
+ * Hash, or a lookup for one is turned away when the set holds the other.
+ *
+ * Lookups are only counted once keepStats() asks for it, and then with
+ * relaxed atomics, so a const set can still be read from many threads.
+ *
+ * Hash is part of the type, like the hash of HashIndex, so the call
+ * is made directly and can be inlined
+ ***********************************************/
+template <typename T, typename Hash>
+class BloomFilter
+{
+   friend class ::TestSet; // give unit tests access to the privates
+
+public:
+   using Stats = BloomFilterStats;
+   static constexpr bool enabled = true;
+
+   BloomFilter(size_t numExpected, size_t bitsPerElement, const Hash & hash) :
+      blocks(numBlocksFor(numExpected, bitsPerElement)), hash(hash), numEntries(0),
+      isCounting(false), numQueries(), numRejected(), numFalsePositives()
+   {
+   }
+
+   // false means t was never inserted
+   bool mayContain(const T & t) const
+   {
+      uint64_t h = mix(hash(t));
+      const Block & block = blocks[pick(h)];
+      uint64_t missing = 0;
+      for (int i = 0; i < numWords; i++)
+         missing |= ~block.words[i] & bit(h, i);
+      if (isCounting)
+      {
+         numQueries.add();
+         if (missing)
+            numRejected.add();
+      }
+      return missing == 0;
+   }
+
+   // a lookup the filter let through turned out not to be in the set
+   void falsePositive() const noexcept
+   {
+      if (isCounting)
+         numFalsePositives.add();
+   }
+
+   void insert(const T & t)
+   {
+      uint64_t h = mix(hash(t));
+      Block & block = blocks[pick(h)];
+      for (int i = 0; i < numWords; i++)
+         block.words[i] |= bit(h, i);
+      numEntries++;
+   }
+
+   // forget every element but keep the size, the hash, and the stats
+   void clear() noexcept
+   {
+      for (Block & block : blocks)
+         block = Block();
+      numEntries = 0;
+   }
+
+   // count lookups from now on, or stop. Off to start with
+   void keepStats(bool keep) noexcept
+   {
+      isCounting = keep;
+   }
+   void resetStats() noexcept
+   {
+      numQueries.reset();
+      numRejected.reset();
+      numFalsePositives.reset();
+   }
+
+   // elements inserted since the last clear(), erased or not
+   size_t size()  const noexcept { return numEntries;                   }
+   size_t bytes() const noexcept { return blocks.size() * sizeof(Block); }
+   Stats  getStats(size_t numElements) const noexcept
+   {
+      Stats s;
+      s.numQueries        = numQueries.get();
+      s.numRejected       = numRejected.get();
+      s.numFalsePositives = numFalsePositives.get();
+      s.numStale = numEntries - numElements;
+      s.numBits  = bytes() * 8;
+      return s;
+   }
+
+private:
+
+   // a count bumped by readers of a const set on any thread. Nothing
+   // is ordered by it, so relaxed is enough
+   class Counter
+   {
+   public:
+      Counter() noexcept : n(0) {}
+      Counter(const Counter & rhs) noexcept : n(rhs.get()) {}
+      Counter & operator = (const Counter & rhs) noexcept
+      {
+         n.store(rhs.get(), std::memory_order_relaxed);
+         return *this;
+      }
+      void   add()   noexcept       { n.fetch_add(1, std::memory_order_relaxed); }
+      void   reset() noexcept       { n.store(0, std::memory_order_relaxed);     }
+      size_t get()   const noexcept { return n.load(std::memory_order_relaxed);  }
+   private:
+      std::atomic <size_t> n;
+   };
+
+   // eight words of 64 bits: one cache line, one bit from each word
+   static constexpr int numWords = 8;
+   struct alignas(64) Block
+   {
+      uint64_t words[numWords] = {};
+   };
+
+   static size_t numBlocksFor(size_t numExpected, size_t bitsPerElement)
+   {
+      size_t numBits = numExpected * bitsPerElement;
+      size_t numBlocks = (numBits + sizeof(Block) * 8 - 1) / (sizeof(Block) * 8);
+      return numBlocks == 0 ? 1 : numBlocks;
+   }
+
+   // the top half of the hash picks the block, scaled rather than
+   // masked so the count of blocks need not be a power of two
+   size_t pick(uint64_t h) const noexcept
+   {
+      return (size_t)(((h >> 32) * (uint64_t)blocks.size()) >> 32);
+   }
+
+   // the bottom half times a different odd number per word picks the bit
+   static uint64_t bit(uint64_t h, int i) noexcept
+   {
+      static constexpr uint32_t salts[numWords] =
+      {
+         0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+         0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+      };
+      uint32_t k = (uint32_t)h * salts[i];
+      return 1ull << (k >> 26);
+   }
+
+   // both halves are used, so every bit of the hash has to count: the
+   // standard hash of an integer is the integer
+   static uint64_t mix(size_t h) noexcept
+   {
+      uint64_t x = h;
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdull;
+      x ^= x >> 33;
+      x *= 0xc4ceb9fe1a85ec53ull;
+      x ^= x >> 33;
+      return x;
+   }
+
+   std::vector <Block> blocks;                  // the bits, one line each
+   Hash hash;                                   // hash of an element
+   size_t numEntries;                           // inserts since the clear
+   bool isCounting;                             // keep the stats below?
+   mutable Counter numQueries;                  // lookups count even when const
+   mutable Counter numRejected;
+   mutable Counter numFalsePositives;
+};
+
+/************************************************
+ * BLOOM FILTER : no filter
+ * Hash of void, for elements there is no hash for, means a filter
+ * can never be attached
+ ***********************************************/
+template <typename T>
+class BloomFilter <T, void>
+{
+public:
+   using Stats = BloomFilterStats;
+   static constexpr bool enabled = false;
+
+   bool mayContain(const T &) const                         { return true;    }
+   void falsePositive() const noexcept                      {                 }
+   void insert(const T &)                                   {                 }
+   void clear() noexcept                                    {                 }
+   void keepStats(bool) noexcept                            {                 }
+   void resetStats() noexcept                               {                 }
+   size_t size()  const noexcept                            { return 0;       }
+   size_t bytes() const noexcept                            { return 0;       }
+   Stats getStats(size_t) const noexcept                    { return Stats { 0, 0, 0, 0, 0 }; }
+};
+
+/************************************************
+ * DEFAULT FILTER HASH
+ * std::hash agrees with operator==, and so with the ordering of
+ * std::less. Any other Compare may call elements equivalent that
+ * std::hash tells apart, as a case-blind order of strings, so it gets
+ * void and a set has to be told which hash to use
+ ***********************************************/
+template <typename T, typename Compare>
+struct DefaultFilterHash
+{
+   using type = void;
+};
+template <typename T>
+struct DefaultFilterHash <T, std::less<T>>
+{
+   using type = std::hash<T>;
+};
+template <typename T>
+struct DefaultFilterHash <T, std::less<>>
+{
+   using type = std::hash<T>;
+};
+
+} // namespace custom
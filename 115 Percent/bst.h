@@ -13,6 +13,7 @@
  *    This will contain the class definition of:
  *        BST                 : A class that represents a binary search tree
  *        BST::iterator       : An iterator through BST
+ *        BST::BNode          : A node in the BST, allocated from a pool
  * Author
  *    <your names here>
  ************************************************************************/
@@ -26,10 +27,15 @@
 #endif // !DEBUG
 
 #include <cassert>
-#include <utility>
-#include <memory>     // for std::allocator
+#include <cstddef>    // for size_t and std::ptrdiff_t
+#include <memory>     // for std::allocator and std::allocator_traits
+#include <new>        // for placement new
+#include <type_traits>// for std::is_same
 #include <functional> // for std::less
-#include <utility>    // for std::pair
+#include <limits>     // for std::numeric_limits
+#include <utility>    // for std::pair and std::in_place
+#include <iterator>   // for std::iterator_traits and std::distance
+#include "pool.h"     // for custom::pool
 
 class TestBST; // forward declaration for unit tests
 class TestSet;
@@ -38,33 +44,144 @@ class TestMap;
 namespace custom
 {
 
-   template <typename TT>
+   template <typename TT, typename CC, typename AA, bool RR, typename GG, bool HH, typename II, typename FF>
    class set;
    template <typename KK, typename VV>
    class map;
 
 /*****************************************************************
- * BINARY SEARCH TREE
- * Create a Binary Search Tree
+ * SORTED UNIQUE
+ * Tag promising that a range is already sorted with no duplicates,
+ * so the tree can be built from it directly
+ *****************************************************************/
+struct sorted_unique_t { explicit sorted_unique_t() = default; };
+inline constexpr sorted_unique_t sorted_unique{};
+
+/*****************************************************************
+ * SUBTREE SIZE
+ * What a ranked tree adds to every node: the number of nodes in the
+ * subtree it heads. Unranked trees get the empty version, which the
+ * node takes up no room for
+ *****************************************************************/
+template <bool Ranked>
+struct SubtreeSize
+{
+   size_t numSubtree = 1;
+};
+
+template <>
+struct SubtreeSize <false>
+{
+};
+
+/*****************************************************************
+ * SUBTREE AGGREGATE
+ * What a tree with a Monoid adds to every node: the Monoid's summary
+ * of the subtree it heads. A Monoid is a policy such as sum_of below:
+ *    value_type                the summary
+ *    identity()                summary of nothing
+ *    value(t)                  summary of the element t alone
+ *    combine(lhs, rhs)         summary of lhs followed by rhs
+ * combine() must be associative and must not throw. It need not be
+ * commutative: elements are always combined in order
+ *****************************************************************/
+template <typename Monoid>
+struct SubtreeAggregate
+{
+   typename Monoid::value_type aggregate;
+};
+
+template <>
+struct SubtreeAggregate <void>
+{
+};
+
+/*****************************************************************
+ * IN ORDER LINKS
+ * What a Threaded tree adds to every node: the nodes just before and
+ * after it in order, so the iterator steps along a list instead of
+ * climbing the tree. Other trees get the empty version
+ *****************************************************************/
+template <bool Threaded, typename Node>
+struct InOrderLinks
+{
+   Node * pPrev = nullptr;
+   Node * pNext = nullptr;
+};
+
+template <typename Node>
+struct InOrderLinks <false, Node>
+{
+};
+
+/*****************************************************************
+ * SUM OF, MIN OF, MAX OF
+ * Ready made Monoids for a tree of numbers
  *****************************************************************/
 template <typename T>
+struct sum_of
+{
+   using value_type = T;
+   static value_type identity()                                   { return T();       }
+   static value_type value(const T & t)                           { return t;         }
+   static value_type combine(const value_type & lhs, const value_type & rhs) { return lhs + rhs; }
+};
+
+template <typename T>
+struct min_of
+{
+   using value_type = T;
+   static value_type identity()                                   { return std::numeric_limits<T>::max(); }
+   static value_type value(const T & t)                           { return t;         }
+   static value_type combine(const value_type & lhs, const value_type & rhs) { return rhs < lhs ? rhs : lhs; }
+};
+
+template <typename T>
+struct max_of
+{
+   using value_type = T;
+   static value_type identity()                                   { return std::numeric_limits<T>::lowest(); }
+   static value_type value(const T & t)                           { return t;         }
+   static value_type combine(const value_type & lhs, const value_type & rhs) { return lhs < rhs ? rhs : lhs; }
+};
+
+/*****************************************************************
+ * BINARY SEARCH TREE
+ * Create a Binary Search Tree ordered by Compare. Nodes are allocated
+ * through Allocator, rebound to the node type. A Ranked tree keeps
+ * subtree sizes in its nodes so it can find elements by position.
+ * A tree with a Monoid keeps subtree aggregates so it can summarize
+ * a range of keys without visiting every element in it. A Threaded
+ * tree links its nodes in order so iterating never climbs the tree
+ *****************************************************************/
+template <typename T,
+          typename Compare = std::less<T>,
+          typename Allocator = std::allocator<T>,
+          bool Ranked = false,
+          typename Monoid = void,
+          bool Threaded = false>
 class BST
 {
    friend class ::TestBST; // give unit tests access to the privates
    friend class ::TestSet;
    friend class ::TestMap;
 
-   template <class TT>
+   template <class TT, class CC, class AA, bool RR, class GG, bool HH, class II, class FF>
    friend class custom::set;
 
    template <class KK, class VV>
    friend class custom::map;
 public:
+   using key_compare    = Compare;
+   using allocator_type = Allocator;
+
    //
    // Construct
    //
 
    BST();
+   explicit BST(const Compare & compare, const Allocator & alloc = Allocator());
+   explicit BST(const Allocator & alloc);
    BST(const BST &  rhs);
    BST(      BST && rhs);
    BST(const std::initializer_list<T>& il);
@@ -85,14 +202,58 @@ public:
    //
 
    class iterator;
-   iterator   begin() const noexcept;
-   iterator   end()   const noexcept { return iterator(nullptr); }
+   using const_iterator = iterator;   // elements are never changed in place
+   iterator   begin()  const noexcept { return iterator(pFirst);  }
+   iterator   end()    const noexcept { return iterator(nullptr); }
+
+   // walk backwards with --: the iterator falls off the front to rend()
+   iterator   rbegin() const noexcept { return iterator(pLast);   }
+   iterator   rend()   const noexcept { return iterator(nullptr); }
 
    //
    // Access
    //
 
-   iterator find(const T& t);
+   iterator find(const T& t)          const { return iterator(findNode(t));   }
+   iterator lower_bound(const T& t)   const { return iterator(lowerBound(t)); }
+   iterator upper_bound(const T& t)   const { return iterator(upperBound(t)); }
+   size_t   count(const T& t)         const { return countOf(t);              }
+   bool     contains(const T& t)      const { return findNode(t) != nullptr;  }
+   std::pair<iterator, iterator> equal_range(const T& t) const { return equalRange(t); }
+
+   // the smallest and largest elements: the tree must not be empty
+   const T & front() const { assert(pFirst); return pFirst->data; }
+   const T & back()  const { assert(pLast);  return pLast->data;  }
+
+   // with a transparent Compare, look up by anything it can compare to T
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   iterator find(const K& k)          const { return iterator(findNode(k));   }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   iterator lower_bound(const K& k)   const { return iterator(lowerBound(k)); }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   iterator upper_bound(const K& k)   const { return iterator(upperBound(k)); }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   size_t   count(const K& k)         const { return countOf(k);              }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   bool     contains(const K& k)      const { return findNode(k) != nullptr;  }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   std::pair<iterator, iterator> equal_range(const K& k) const { return equalRange(k); }
+
+   //
+   // Rank: only for Ranked trees, each in O(log n)
+   //
+
+   iterator       nth(size_t k)                           const;
+   size_t         rank(const T & t)                       const;
+   size_t         index(iterator it)                      const;
+   std::ptrdiff_t distance(iterator first, iterator last) const;
+
+   //
+   // Aggregate: only for trees with a Monoid, in O(log n)
+   //
+
+   template <class GG = Monoid>
+   typename GG::value_type aggregate(const T & lo, const T & hi) const;
 
    // 
    // Insert
@@ -100,32 +261,157 @@ public:
 
    std::pair<iterator, bool> insert(const T&  t, bool keepUnique = false);
    std::pair<iterator, bool> insert(      T&& t, bool keepUnique = false);
+   std::pair<iterator, bool> insert(iterator hint, const T&  t, bool keepUnique = false);
+   std::pair<iterator, bool> insert(iterator hint,       T&& t, bool keepUnique = false);
+   template <class ... Args>
+   std::pair<iterator, bool> emplace(bool keepUnique, Args && ... args);
+   template <class Iterator>
+   void insert(Iterator first, Iterator last, bool keepUnique = false);
+   template <class Iterator>
+   void assign(sorted_unique_t, Iterator first, Iterator last);
+   template <class ... Args>
+   std::pair<iterator, bool> emplace_hint(iterator hint, bool keepUnique, Args && ... args);
 
    //
    // Remove
    // 
 
    iterator erase(iterator& it);
+   iterator erase(iterator first, iterator last);
+   void   pop_front() noexcept;
+   void   pop_back()  noexcept;
    void   clear() noexcept;
 
+   // clear() keeps the memory of its nodes for the next inserts. Once
+   // the tree is empty, and so is every tree it shares a pool with,
+   // this gives it back
+   void   trim() noexcept
+   {
+      if (pPool)
+      {
+         pPool->trim();
+      }
+   }
+
+   //
+   // Split and join
+   //
+
+   std::pair<BST, BST> split(const T & t) { return splitTree(t, true /*isCounted*/); }
+   static BST join(BST && left, BST && right);
+   static BST join(BST && left, const T &  t, BST && right);
+   static BST join(BST && left,       T && t, BST && right);
+
    // 
    // Status
    //
 
    bool   empty() const noexcept { return size() == 0; }
    size_t size()  const noexcept { return numElements;   }
+   allocator_type get_allocator() const noexcept { return allocator_type(alloc); }
+   key_compare    key_comp()      const          { return compare;                }
    
 private:
 
    class BNode;
 
-   void deleteNode(BNode*& pDelete, bool toRight);
-   void deleteBinaryTree(BNode*& pDelete) noexcept;
+   using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<BNode>;
+   using NodeTraits    = std::allocator_traits<NodeAllocator>;
+
+   // the default allocator leaves nodes to the tree's own pool
+   static constexpr bool usesPool = std::is_same<Allocator, std::allocator<T>>::value;
+
+   // the pool to take nodes from, made on first use
+   pool <BNode> & nodePool()
+   {
+      if (!pPool)
+      {
+         pPool = pool <BNode> :: create();
+      }
+      return *pPool;
+   }
+   void releasePool() noexcept
+   {
+      if (pPool)
+      {
+         pPool->release();
+         pPool = nullptr;
+      }
+   }
+
+   template <class K>
+   BNode * findNode(const K & k) const;
+   template <class K>
+   BNode * lowerBound(const K & k) const;
+   template <class K>
+   BNode * upperBound(const K & k) const;
+   template <class K>
+   BNode * lowerBoundFrom(BNode * pFrom, const K & k) const;
+   template <class K>
+   std::pair<iterator, iterator> equalRange(const K & k) const;
+   template <class K>
+   size_t countOf(const K & k) const;
+
+   template <class K>
+   BNode * findParent(const K & k, bool & goLeft, BNode * & pCandidate) const;
+   template <class K>
+   BNode * findParent(BNode * pHint, const K & k, bool & goLeft, BNode * & pCandidate) const;
+   void linkNode(BNode * pParent, bool goLeft, BNode * pNew) noexcept;
+   void unlinkNode(BNode * pDelete) noexcept;
+   std::pair<iterator, bool> placeNode(BNode * pNew, bool keepUnique, bool useHint, BNode * pHint);
+
+   template <class ... Args>
+   BNode * createNode(Args && ... args);
+   void destroyNode(BNode * pNode) noexcept;
+
+   void replaceNode(BNode* pOld, BNode* pReplace);
+   void rotateLeft(BNode* pNode);
+   void rotateRight(BNode* pNode);
+   static void updateToRoot(BNode * pNode) noexcept;
+   void balanceErase(BNode* pNode, BNode* pParent);
+   template <class K>
+   void splitNodes(BNode * pNode, int height, const K & k,
+                   BNode * & pLeft, int & heightLeft, BNode * & pRight, int & heightRight);
+   static BNode * joinNodes(BNode * pLeft, int heightLeft, BNode * pKey,
+                            BNode * pRight, int heightRight, int & height) noexcept;
+   std::pair<BST, BST> splitTree(const T & t, bool isCounted);
+   static BST joinTrees(BST && left, BNode * pKey, BST && right) noexcept;
+   static int blackHeight(const BNode * pNode) noexcept;
+   static size_t countNodes(const BNode * pNode) noexcept;
+
+   // does splitting at *it cut the tree right before it? Not when an
+   // equal element comes first
+   bool cutsBefore(iterator it) const
+   {
+      if (it == end() || it.pNode == pFirst)
+      {
+         return true;
+      }
+      iterator itPrev = it;
+      --itPrev;
+      return compare(*itPrev, *it);
+   }
+   void resetEnds() noexcept;
+   static BNode * threadNodes(BNode * pNode, BNode * pPrev) noexcept;
+   static void linkInOrder(BNode * pPrev, BNode * pNext) noexcept;
+
+   // ranges up to this long are cheaper to erase one node at a time
+   // than to cut out with two splits and a join
+   static constexpr size_t eraseOneByOne = 256;
+
+   template <class Iterator>
+   BNode * buildSorted(Iterator & it, size_t num, size_t depth, size_t depthRed);
+   size_t deleteBinaryTree(BNode*& pDelete) noexcept;
    void copyBinaryTree(const BNode* pSrc, BNode *& pDest);
 
 
    BNode * root;              // root node of the binary search tree
-   size_t numElements;        // number of elements currently in the tree
+   BNode * pFirst;            // left-most node, nullptr when empty
+   BNode * pLast;             // right-most node, nullptr when empty
+   size_t numElements;        // number of elements
+   Compare compare;           // strict weak ordering of the elements
+   NodeAllocator alloc;       // where the nodes come from
+   pool <BNode> * pPool;      // or here, with the default allocator
 };
 
 
@@ -134,8 +420,9 @@ private:
  * A single node in a binary tree. Note that the node does not know
  * anything about the properties of the tree so no validation can be done.
  *****************************************************************/
-template <typename T>
-class BST <T> :: BNode
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+class BST <T, C, A, R, G, H> :: BNode : public SubtreeSize <R>, public SubtreeAggregate <G>,
+                                        public InOrderLinks <H, typename BST <T, C, A, R, G, H> :: BNode>
 {
 public:
    // 
@@ -143,13 +430,36 @@ public:
    //
    BNode(): pLeft(nullptr), pRight(nullptr), pParent(nullptr), data(), isRed(true)
    {
+      update();
    }
    BNode(const T &  t) : pLeft(nullptr), pRight(nullptr), pParent(nullptr), data(t), isRed(true)
    {
+      update();
    }
    BNode(T && t) : pLeft(nullptr), pRight(nullptr), pParent(nullptr), data(std::move(t)), isRed(true)
    {  
+      update();
+   }
+   template <class ... Args>
+   BNode(std::in_place_t, Args && ... args) : data(std::forward<Args>(args)...),
+                                               pLeft(nullptr), pRight(nullptr), pParent(nullptr), isRed(true)
+   {
+      update();
+   }
 
+   //
+   // Allocate: the tree places its nodes in its own pool. A node made
+   // with new, as by hand, comes from the heap, and either kind goes
+   // back to the right place with delete
+   //
+   static void * operator new(size_t size)
+   {
+      assert(size == sizeof(BNode));
+      return pool <BNode> :: allocateUnpooled();
+   }
+   static void operator delete(void * p) noexcept
+   {
+      pool <BNode> :: deallocate(p);
    }
 
    //
@@ -157,10 +467,6 @@ public:
    //
    void addLeft (BNode * pNode);
    void addRight(BNode * pNode);
-   void addLeft (const T &  t);
-   void addRight(const T &  t);
-   void addLeft(       T && t);
-   void addRight(      T && t);
 
 
 
@@ -171,8 +477,35 @@ public:
    bool isRightChild(BNode * pNode) const { return pRight == pNode; }
    bool isLeftChild( BNode * pNode) const { return pLeft == pNode; }
 
-   // balance the tree
-   void balance();
+   // subtree sizes, which only a Ranked tree keeps, and subtree
+   // aggregates, which only a tree with a Monoid keeps
+   static size_t sizeOf(const BNode * pNode) noexcept
+   {
+      return pNode ? pNode->numSubtree : 0;
+   }
+   template <class GG = G>
+   static typename GG::value_type aggregateOf(const BNode * pNode)
+   {
+      return pNode ? pNode->aggregate : GG::identity();
+   }
+
+   // our children changed, so recompute whatever we keep about our subtree
+   void update()
+   {
+      if constexpr (R)
+      {
+         this->numSubtree = 1 + sizeOf(pLeft) + sizeOf(pRight);
+      }
+      if constexpr (!std::is_void<G>::value)
+      {
+         this->aggregate = G::combine(G::combine(aggregateOf(pLeft), G::value(data)),
+                                      aggregateOf(pRight));
+      }
+   }
+
+   // balance the tree. True when a red root had to be made black,
+   // so the black height of the whole tree grew by one
+   bool balance();
 
 #ifdef DEBUG
    //
@@ -198,8 +531,8 @@ public:
  * BINARY SEARCH TREE ITERATOR
  * Forward and reverse iterator through a BST
  *********************************************************/
-template <typename T>
-class BST <T> :: iterator
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+class BST <T, C, A, R, G, H> :: iterator
 {
    friend class ::TestBST; // give unit tests access to the privates
    friend class ::TestSet;
@@ -207,6 +540,9 @@ class BST <T> :: iterator
 
    template <class KK, class VV>
    friend class custom::map;
+   template <class TT, class CC, class AA, bool RR, class GG, bool HH, class II, class FF>
+   friend class custom::set;
+   friend class BST <T, C, A, R, G, H>;
 public:
    // constructors and assignment
    iterator(BNode * p = nullptr)          
@@ -256,7 +592,7 @@ public:
    }
 
    // must give friend status to remove so it can call getNode() from it
-   friend BST <T> :: iterator BST <T> :: erase(iterator & it);
+   friend BST <T, C, A, R, G, H> :: iterator BST <T, C, A, R, G, H> :: erase(iterator & it);
 
 private:
    
@@ -277,8 +613,31 @@ private:
  /*********************************************
   * BST :: DEFAULT CONSTRUCTOR
   ********************************************/
-template <typename T>
-BST <T> ::BST() : root(nullptr), numElements(0)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> ::BST() : root(nullptr), pFirst(nullptr), pLast(nullptr),
+   numElements(0), compare(), alloc(), pPool(nullptr)
+{
+
+}
+
+/*********************************************
+ * BST :: COMPARE CONSTRUCTOR
+ * An empty tree ordered by compare
+ ********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> ::BST(const C & compare, const A & alloc) :
+   root(nullptr), pFirst(nullptr), pLast(nullptr), numElements(0), compare(compare), alloc(alloc), pPool(nullptr)
+{
+
+}
+
+/*********************************************
+ * BST :: ALLOCATOR CONSTRUCTOR
+ * An empty tree whose nodes will come from alloc
+ ********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> ::BST(const A & alloc) : root(nullptr), pFirst(nullptr), pLast(nullptr),
+   numElements(0), compare(), alloc(alloc), pPool(nullptr)
 {
 
 }
@@ -287,8 +646,9 @@ BST <T> ::BST() : root(nullptr), numElements(0)
  * BST :: COPY CONSTRUCTOR
  * Copy one tree to another
  ********************************************/
-template <typename T>
-BST <T> :: BST ( const BST<T>& rhs) : root(nullptr), numElements(0)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> :: BST ( const BST <T, C, A, R, G, H>& rhs) : root(nullptr), pFirst(nullptr), pLast(nullptr), numElements(0),
+   compare(rhs.compare), alloc(NodeTraits::select_on_container_copy_construction(rhs.alloc)), pPool(nullptr)
 {
    *this = rhs;
 }
@@ -297,11 +657,15 @@ BST <T> :: BST ( const BST<T>& rhs) : root(nullptr), numElements(0)
  * BST :: MOVE CONSTRUCTOR
  * Move one tree to another
  ********************************************/
-template <typename T>
-BST <T> :: BST(BST <T> && rhs) : root(nullptr), numElements(0)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> :: BST(BST <T, C, A, R, G, H> && rhs) : root(nullptr), pFirst(nullptr), pLast(nullptr), numElements(0),
+   compare(rhs.compare), alloc(std::move(rhs.alloc)), pPool(rhs.pPool)
 {
+   rhs.pPool = nullptr;
    root = rhs.root;
    rhs.root = nullptr;
+   std::swap(pFirst, rhs.pFirst);
+   std::swap(pLast, rhs.pLast);
 
    numElements = rhs.numElements;
    rhs.numElements = 0;
@@ -311,10 +675,11 @@ BST <T> :: BST(BST <T> && rhs) : root(nullptr), numElements(0)
 /*********************************************
  * BST :: DESTRUCTOR
  ********************************************/
-template <typename T>
-BST <T> :: ~BST()
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> :: ~BST()
 {
    clear();
+   releasePool();
 }
 
 
@@ -322,10 +687,29 @@ BST <T> :: ~BST()
  * BST :: ASSIGNMENT OPERATOR
  * Copy one tree to another
  ********************************************/
-template <typename T>
-BST <T> & BST <T> :: operator = (const BST <T> & rhs)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> & BST <T, C, A, R, G, H> :: operator = (const BST <T, C, A, R, G, H> & rhs)
 {
-   copyBinaryTree(rhs.root, this->root) ;
+   // nodes must go back to the allocator they came from
+   if (NodeTraits::propagate_on_container_copy_assignment::value && alloc != rhs.alloc)
+   {
+      clear();
+      alloc = rhs.alloc;
+   }
+
+   compare = rhs.compare;
+   try
+   {
+      copyBinaryTree(rhs.root, this->root);
+   }
+   catch (...)
+   {
+      resetEnds();
+      threadNodes(root, nullptr);
+      throw;
+   }
+   resetEnds();
+   threadNodes(root, nullptr);
    assert(nullptr == this->root || this->root->pParent == nullptr);
    
    this->numElements = rhs.numElements;
@@ -338,12 +722,13 @@ BST <T> & BST <T> :: operator = (const BST <T> & rhs)
  * BST :: ASSIGNMENT OPERATOR with INITIALIZATION LIST
  * Copy nodes onto a BTree
  ********************************************/
-template <typename T>
-BST <T> & BST <T> :: operator = (const std::initializer_list<T>& il)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> & BST <T, C, A, R, G, H> :: operator = (const std::initializer_list<T>& il)
 {
    
    deleteBinaryTree(root);
    numElements = 0;
+   resetEnds();
    
    for (auto&& element : il)
    {
@@ -358,13 +743,29 @@ BST <T> & BST <T> :: operator = (const std::initializer_list<T>& il)
  * BST :: ASSIGN-MOVE OPERATOR
  * Move one tree to another
  ********************************************/
-template <typename T>
-BST <T> & BST <T> :: operator = (BST <T> && rhs)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> & BST <T, C, A, R, G, H> :: operator = (BST <T, C, A, R, G, H> && rhs)
 {
-   
+   // a different arena cannot adopt our nodes, so copy them across
+   if (!NodeTraits::propagate_on_container_move_assignment::value && alloc != rhs.alloc)
+   {
+      *this = rhs;
+      rhs.clear();
+      return *this;
+   }
+
    clear();
 
-   swap(rhs);
+   if (NodeTraits::propagate_on_container_move_assignment::value)
+   {
+      alloc = std::move(rhs.alloc);
+   }
+   std::swap(rhs.root, root);
+   std::swap(rhs.pFirst, pFirst);
+   std::swap(rhs.pLast, pLast);
+   std::swap(rhs.numElements, numElements);
+   std::swap(rhs.compare, compare);
+   std::swap(rhs.pPool, pPool);
    
    return *this;
 }
@@ -373,203 +774,591 @@ BST <T> & BST <T> :: operator = (BST <T> && rhs)
  * BST :: SWAP
  * Swap two trees
  ********************************************/
-template <typename T>
-void BST <T> :: swap (BST <T>& rhs)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: swap (BST <T, C, A, R, G, H>& rhs)
 {
+   assert(NodeTraits::propagate_on_container_swap::value || alloc == rhs.alloc);
+
    std::swap(rhs.root, root);
+   std::swap(rhs.pFirst, pFirst);
+   std::swap(rhs.pLast, pLast);
    std::swap(rhs.numElements, numElements);
+   std::swap(rhs.compare, compare);
+   std::swap(rhs.pPool, pPool);
+   if (NodeTraits::propagate_on_container_swap::value)
+   {
+      std::swap(rhs.alloc, alloc);
+   }
 }
 
 /*****************************************************
  * BST :: INSERT
  * Insert a node at a given location in the tree
  ****************************************************/
-template <typename T>
-std::pair<typename BST <T> :: iterator, bool> BST <T> :: insert(const T & t, bool keepUnique)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+std::pair<typename BST <T, C, A, R, G, H> :: iterator, bool> BST <T, C, A, R, G, H> :: insert(const T & t, bool keepUnique)
 {
-   std::pair<iterator, bool> pairReturn(end(), false);
+   bool goLeft = false;
+   BNode * pCandidate = nullptr;
+   BNode * pParent = findParent(t, goLeft, pCandidate);
+
+   if (keepUnique && pCandidate != nullptr && !compare(pCandidate->data, t))
+   {
+      return std::pair<iterator, bool>(iterator(pCandidate), false);
+   }
 
+   BNode * pNew = nullptr;
    try
    {
-      if (root == nullptr)
-      {
-         assert(numElements == 0);
-         root = new BNode(t);
-         root->isRed = false;
-         numElements = 1;
-         pairReturn.first = iterator(root);
-         pairReturn.second = true;
-         return pairReturn;
-      }
+      pNew = createNode(t);
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   linkNode(pParent, goLeft, pNew);
+   return std::pair<iterator, bool>(iterator(pNew), true);
+}
 
+/*****************************************************
+ * BST :: INSERT MOVE
+ * Same as insert but t is moved into the new node. Nothing is
+ * taken from t when it turns out to be a duplicate
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+std::pair<typename BST <T, C, A, R, G, H> ::iterator, bool> BST <T, C, A, R, G, H> ::insert(T && t, bool keepUnique)
+{
+   bool goLeft = false;
+   BNode * pCandidate = nullptr;
+   BNode * pParent = findParent(t, goLeft, pCandidate);
 
-      BNode* node = root;
-      bool done = false;
+   if (keepUnique && pCandidate != nullptr && !compare(pCandidate->data, t))
+   {
+      return std::pair<iterator, bool>(iterator(pCandidate), false);
+   }
 
-      while(!done)
-      {
-         if (keepUnique && t == node->data)
-         {
-            pairReturn.first = iterator(node);
-            pairReturn.second = false;
-            return pairReturn;
-         }
+   BNode * pNew = nullptr;
+   try
+   {
+      pNew = createNode(std::move(t));
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   linkNode(pParent, goLeft, pNew);
+   return std::pair<iterator, bool>(iterator(pNew), true);
+}
 
-         if (t < node->data)
-         {
-            if (node->pLeft)
-            {
-               node = node->pLeft;
-            }
-            else
-            {
-               node->addLeft(t);
-               done = true;
-               pairReturn.first = iterator(node->pLeft);
-               pairReturn.second = true;
-            }
-         }
-         else
-         {
-            if (node->pRight)
-            {
-               node = node->pRight;
-            }
-            else
-            {
-               node->addRight(t);
-               done = true;
-               pairReturn.first = iterator(node->pRight);
-               pairReturn.second = true;
-            }
-         }
-      }
+/*****************************************************
+ * BST :: INSERT WITH HINT
+ * Insert t right before hint. When hint is in the right place, or
+ * is the node just before t, this costs a couple of comparisons
+ * instead of a descent from the root. Otherwise it is a plain insert
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+std::pair<typename BST <T, C, A, R, G, H> :: iterator, bool> BST <T, C, A, R, G, H> :: insert(iterator hint, const T & t, bool keepUnique)
+{
+   bool goLeft = false;
+   BNode * pCandidate = nullptr;
+   BNode * pParent = findParent(hint.pNode, t, goLeft, pCandidate);
 
-      assert(root != nullptr);
-      numElements++;
-      
+   if (keepUnique && pCandidate != nullptr && !compare(pCandidate->data, t))
+   {
+      return std::pair<iterator, bool>(iterator(pCandidate), false);
+   }
 
-      while (root->pParent != nullptr)
-      {
-         root = root->pParent;
-      }
-      assert(root->pParent == nullptr);
+   BNode * pNew = nullptr;
+   try
+   {
+      pNew = createNode(t);
    }
    catch (...)
    {
       throw "ERROR: Unable to allocate a node";
    }
-   return pairReturn;
+   linkNode(pParent, goLeft, pNew);
+   return std::pair<iterator, bool>(iterator(pNew), true);
+}
 
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+std::pair<typename BST <T, C, A, R, G, H> :: iterator, bool> BST <T, C, A, R, G, H> :: insert(iterator hint, T && t, bool keepUnique)
+{
+   bool goLeft = false;
+   BNode * pCandidate = nullptr;
+   BNode * pParent = findParent(hint.pNode, t, goLeft, pCandidate);
 
+   if (keepUnique && pCandidate != nullptr && !compare(pCandidate->data, t))
+   {
+      return std::pair<iterator, bool>(iterator(pCandidate), false);
+   }
 
+   BNode * pNew = nullptr;
+   try
+   {
+      pNew = createNode(std::move(t));
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   linkNode(pParent, goLeft, pNew);
+   return std::pair<iterator, bool>(iterator(pNew), true);
 }
 
-template <typename T>
-std::pair<typename BST <T> ::iterator, bool> BST <T> ::insert(T && t, bool keepUnique)
+/*****************************************************
+ * BST :: EMPLACE
+ * Build the element in a new node straight from args. We need the
+ * element to know where it goes, so a duplicate is built and then
+ * thrown away
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class ... Args>
+std::pair<typename BST <T, C, A, R, G, H> :: iterator, bool> BST <T, C, A, R, G, H> :: emplace(bool keepUnique, Args && ... args)
 {
-   std::pair<iterator, bool> pairReturn(end(), false);
+   BNode * pNew = nullptr;
    try
    {
-      if (root == nullptr)
+      pNew = createNode(std::in_place, std::forward<Args>(args)...);
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   return placeNode(pNew, keepUnique, false /*useHint*/, nullptr);
+}
+
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class ... Args>
+std::pair<typename BST <T, C, A, R, G, H> :: iterator, bool> BST <T, C, A, R, G, H> :: emplace_hint(iterator hint, bool keepUnique, Args && ... args)
+{
+   BNode * pNew = nullptr;
+   try
+   {
+      pNew = createNode(std::in_place, std::forward<Args>(args)...);
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   return placeNode(pNew, keepUnique, true /*useHint*/, hint.pNode);
+}
+
+/*****************************************************
+ * BST :: PLACE NODE
+ * Find where an already built node goes and link it in. A duplicate
+ * is destroyed, as is the node when the comparison throws
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+std::pair<typename BST <T, C, A, R, G, H> :: iterator, bool> BST <T, C, A, R, G, H> :: placeNode(BNode * pNew, bool keepUnique, bool useHint, BNode * pHint)
+{
+   bool goLeft = false;
+   BNode * pCandidate = nullptr;
+   BNode * pParent = nullptr;
+   try
+   {
+      pParent = useHint ? findParent(pHint, pNew->data, goLeft, pCandidate)
+                        : findParent(pNew->data, goLeft, pCandidate);
+      if (keepUnique && pCandidate != nullptr && !compare(pCandidate->data, pNew->data))
       {
-         assert(numElements == 0);
-         root = new BNode(std::move(t));
-         root->isRed = false;
-         numElements = 1;
-         pairReturn.first = iterator(root);
-         pairReturn.second = true;
-         return pairReturn;
+         destroyNode(pNew);
+         return std::pair<iterator, bool>(iterator(pCandidate), false);
       }
+   }
+   catch (...)
+   {
+      destroyNode(pNew);
+      throw;
+   }
 
+   linkNode(pParent, goLeft, pNew);
+   return std::pair<iterator, bool>(iterator(pNew), true);
+}
 
-      BNode* node = root;
-      bool done = false;
-      while (!done)
-      {
-         if (keepUnique && t == node->data)
-         {
-            pairReturn.first = iterator(node);
-            pairReturn.second = false;
-            return pairReturn;
-         }
+/*****************************************************
+ * BST :: INSERT RANGE
+ * Insert everything in [first, last). When the tree is empty and the
+ * range turns out to be strictly increasing, build the tree straight
+ * from it in O(n). Checking costs one comparison per element and stops
+ * at the first one out of order
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class Iterator>
+void BST <T, C, A, R, G, H> :: insert(Iterator first, Iterator last, bool keepUnique)
+{
+   using category = typename std::iterator_traits<Iterator>::iterator_category;
 
-         if (t < node->data)
+   if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value)
+   {
+      if (root == nullptr)
+      {
+         size_t num = 0;
+         Iterator itPrev = first;
+         Iterator it = first;
+         for (; it != last; itPrev = it, ++it, ++num)
          {
-            if (node->pLeft)
-            {
-               node = node->pLeft;
-            }
-            else
+            if (num != 0 && !compare(*itPrev, *it))
             {
-               node->addLeft(t);
-               done = true;
-               pairReturn.first = iterator(node->pLeft);
-               pairReturn.second = true;
+               break;
             }
          }
-         else
+         if (it == last)
          {
-            if (node->pRight)
-            {
-               node = node->pRight;
-            }
-            else
-            {
-               node->addRight(t);
-               done = true;
-               pairReturn.first = iterator(node->pRight);
-               pairReturn.second = true;
-            }
+            assign(sorted_unique, first, last);
+            return;
          }
       }
+   }
 
-      assert(root != nullptr);
-      numElements++;
+   for (; first != last; ++first)
+   {
+      insert(*first, keepUnique);
+   }
+}
+
+/*****************************************************
+ * BST :: ASSIGN SORTED UNIQUE
+ * Replace the contents with [first, last), which the caller promises
+ * is strictly increasing. With a forward range the tree is built as a
+ * perfectly balanced red-black tree in O(n): each node is created once,
+ * in order, and only the bottom level when it is partly filled is red.
+ * An input range can only be walked once, so it is inserted one by one
+ * at end(), which costs one comparison per element
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class Iterator>
+void BST <T, C, A, R, G, H> :: assign(sorted_unique_t, Iterator first, Iterator last)
+{
+   using category = typename std::iterator_traits<Iterator>::iterator_category;
 
+   clear();
+
+   if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value)
+   {
+      size_t num = std::distance(first, last);
 
-      while (root->pParent != nullptr)
+      // nodes at this depth fill the last level only partly, so they
+      // are red and every path sees the same number of black nodes
+      size_t depthRed = 0;
+      while (((size_t)2 << depthRed) <= num + 1)
       {
-         root = root->pParent;
+         depthRed++;
       }
-      assert(root->pParent == nullptr);
+
+      root = buildSorted(first, num, 0, depthRed);
+      numElements = num;
+      resetEnds();
+      threadNodes(root, nullptr);
+   }
+   else
+   {
+      for (; first != last; ++first)
+      {
+         insert(end(), *first, false);
+      }
+   }
+}
+
+/*****************************************************
+ * BST :: BUILD SORTED
+ * Build a balanced subtree out of the next num elements of it, left
+ * subtree first so the elements are consumed in order. Anything built
+ * so far is freed if a node cannot be created
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class Iterator>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: buildSorted(Iterator & it, size_t num, size_t depth, size_t depthRed)
+{
+   if (num == 0)
+   {
+      return nullptr;
+   }
+
+   size_t numLeft = (num - 1) / 2;
+   BNode * pLeft = buildSorted(it, numLeft, depth + 1, depthRed);
+
+   BNode * pNode = nullptr;
+   try
+   {
+      pNode = createNode(*it);
+      ++it;
+      pNode->pRight = buildSorted(it, num - 1 - numLeft, depth + 1, depthRed);
    }
    catch (...)
    {
+      deleteBinaryTree(pLeft);
+      if (pNode)
+      {
+         destroyNode(pNode);
+      }
       throw "ERROR: Unable to allocate a node";
    }
-   return pairReturn;
+
+   pNode->pLeft = pLeft;
+   pNode->isRed = (depth == depthRed);
+   if (pLeft)
+   {
+      pLeft->pParent = pNode;
+   }
+   if (pNode->pRight)
+   {
+      pNode->pRight->pParent = pNode;
+   }
+   pNode->update();
+   return pNode;
+}
+
+/*****************************************************
+ * BST :: FIND PARENT
+ * Descend with one comparison per level to the node a new k would
+ * hang from, nullptr if the tree is empty. pCandidate is the last
+ * node we went right from: the only one that could be equivalent to k
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: findParent(const K & k, bool & goLeft, BNode * & pCandidate) const
+{
+   BNode * pParent = nullptr;
+   pCandidate = nullptr;
+   goLeft = false;
+   for (BNode * p = root; p != nullptr; p = (goLeft ? p->pLeft : p->pRight))
+   {
+      pParent = p;
+      goLeft = compare(k, p->data);
+      if (!goLeft)
+      {
+         pCandidate = p;
+      }
+   }
+   return pParent;
+}
+
+/*****************************************************
+ * BST :: FIND PARENT WITH HINT
+ * Same as above, but first see whether k fits right before pHint
+ * (nullptr meaning end()) or right after it. Either way it costs a
+ * comparison with the hint and one with its neighbor. When k fits
+ * strictly between two neighbors there is no equivalent node, so
+ * pCandidate is nullptr. Anything else falls back to a full descent
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: findParent(BNode * pHint, const K & k, bool & goLeft, BNode * & pCandidate) const
+{
+   pCandidate = nullptr;
+
+   if (pHint == nullptr)
+   {
+      // before end(): k must come after the largest element
+      BNode * pMax = pLast;
+      if (pMax == nullptr || compare(pMax->data, k))
+      {
+         goLeft = false;
+         return pMax;
+      }
+   }
+   else if (compare(k, pHint->data))
+   {
+      // before the hint: k must come after its predecessor
+      BNode * pPrev = (--iterator(pHint)).pNode;
+      if (pPrev == nullptr || compare(pPrev->data, k))
+      {
+         // either the hint has no left child or the predecessor,
+         // the largest node of that left subtree, has no right child
+         goLeft = (pHint->pLeft == nullptr);
+         return goLeft ? pHint : pPrev;
+      }
+   }
+   else if (compare(pHint->data, k))
+   {
+      // after the hint, as when the hint is the last node inserted
+      BNode * pNext = (++iterator(pHint)).pNode;
+      if (pNext == nullptr || compare(k, pNext->data))
+      {
+         goLeft = (pHint->pRight != nullptr);
+         return goLeft ? pNext : pHint;
+      }
+   }
+
+   return findParent(k, goLeft, pCandidate);
+}
+
+/*****************************************************
+ * BST :: LINK NODE
+ * Hang a new node off pParent, rebalance, and find the new root.
+ * A new node hung left of the left-most node becomes the left-most,
+ * and likewise on the right
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: linkNode(BNode * pParent, bool goLeft, BNode * pNew) noexcept
+{
+   numElements++;
+
+   if (pParent == nullptr)
+   {
+      assert(root == nullptr);
+      root = pFirst = pLast = pNew;
+      root->isRed = false;
+      return;
+   }
+
+   if (goLeft)
+   {
+      pParent->addLeft(pNew);
+      if (pParent == pFirst)
+      {
+         pFirst = pNew;
+      }
+      if constexpr (H)
+      {
+         linkInOrder(pParent->pPrev, pNew);
+         linkInOrder(pNew, pParent);
+      }
+   }
+   else
+   {
+      pParent->addRight(pNew);
+      if (pParent == pLast)
+      {
+         pLast = pNew;
+      }
+      if constexpr (H)
+      {
+         linkInOrder(pNew, pParent->pNext);
+         linkInOrder(pParent, pNew);
+      }
+   }
+   updateToRoot(pParent);
+   pNew->balance();
+
+   while (root->pParent != nullptr)
+   {
+      root = root->pParent;
+   }
+   assert(root->pParent == nullptr);
 }
 
 /*************************************************
  * BST :: ERASE
  * Remove a given node as specified by the iterator
  ************************************************/
-template <typename T>
-typename BST <T> ::iterator BST <T> :: erase(iterator & it)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+typename BST <T, C, A, R, G, H> ::iterator BST <T, C, A, R, G, H> :: erase(iterator & it)
 {  
    if (it == end())
    {
       return end();
    }
 
-
    iterator itNext = it;
+   ++itNext;
+
    BNode* pDelete = it.pNode;
+   unlinkNode(pDelete);
+
+   numElements--;
+   destroyNode(pDelete);
+   return itNext;
+}
+
+/*************************************************
+ * BST :: ERASE RANGE
+ * Remove [first, last) and return last. A long range is cut out with
+ * two splits, the rest is joined back together, and the cut out nodes
+ * are freed in one pass: O(log n + k) for k elements, with no
+ * successor walks and no rebalancing per node.
+ *
+ * A split cuts at a key, not at a node. With duplicates, an element
+ * equal to *first may come before first, and the split would take it
+ * too. So the range is only cut out when the element before each end
+ * is less than it; otherwise it goes one node at a time
+ ************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+typename BST <T, C, A, R, G, H> ::iterator BST <T, C, A, R, G, H> :: erase(iterator first, iterator last)
+{
+   iterator it = first;
+   for (size_t i = 0; i < eraseOneByOne && it != last; i++)
+   {
+      ++it;
+   }
+   if (it == last || !cutsBefore(first) || !cutsBefore(last))
+   {
+      while (first != last)
+      {
+         first = erase(first);
+      }
+      return last;
+   }
+
+   // the nodes are only relinked, so first and last stay put. The
+   // pieces are not counted: what is left is what was there less what
+   // was cut out
+   size_t num = numElements;
+   std::pair<BST, BST> before = splitTree(*first, false /*isCounted*/);
+   BST middle(std::move(before.second));
+   BST after(compare, get_allocator());
+   if (last != end())
+   {
+      std::pair<BST, BST> rest = middle.splitTree(*last, false /*isCounted*/);
+      middle = std::move(rest.first);
+      after  = std::move(rest.second);
+   }
 
+   *this = join(std::move(before.first), std::move(after));
 
+   // like erasing one at a time, the freed nodes stay in the pool
+   size_t numErased = middle.deleteBinaryTree(middle.root);
+   middle.numElements = 0;
+   middle.resetEnds();
+   numElements = num - numErased;
+   return last;
+}
+
+/*************************************************
+ * BST :: UNLINK NODE
+ * Take a node out of the tree and rebalance, without destroying it.
+ * The left-most node has no left child, so its successor is its
+ * parent or the bottom of its short right spine: O(1) in a red-black
+ * tree. Likewise for the right-most node
+ ************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: unlinkNode(BNode * pDelete) noexcept
+{
+   if (pDelete == pFirst)
+   {
+      pFirst = (++iterator(pDelete)).pNode;
+   }
+   if (pDelete == pLast)
+   {
+      pLast = (--iterator(pDelete)).pNode;
+   }
+   if constexpr (H)
+   {
+      linkInOrder(pDelete->pPrev, pDelete->pNext);
+      pDelete->pPrev = pDelete->pNext = nullptr;
+   }
+
+   BNode* pChild = nullptr;       // node that moves into the vacated spot
+   BNode* pChildParent = nullptr; // its parent, since pChild may be nullptr
+   bool wasRed = pDelete->isRed;  // color of the node physically removed
+
+   // Case 1: no left child, so the right child (if any) takes our place
    if (pDelete->pLeft == nullptr)
    {
-      ++itNext;
-      deleteNode(pDelete, true);
+      pChild = pDelete->pRight;
+      pChildParent = pDelete->pParent;
+      replaceNode(pDelete, pChild);
    }
 
+   // Case 2: no right child, so the left child takes our place
    else if (pDelete->pRight == nullptr)
    {
-      ++itNext;
-      deleteNode(pDelete, false);
+      pChild = pDelete->pLeft;
+      pChildParent = pDelete->pParent;
+      replaceNode(pDelete, pChild);
    }
 
+   // Case 3: two children, so the in-order successor takes our place
    else
    {
       BNode* pIOS = pDelete->pRight;
@@ -577,141 +1366,870 @@ typename BST <T> ::iterator BST <T> :: erase(iterator & it)
       {
          pIOS = pIOS->pLeft;
       }
+      assert(pIOS != nullptr && pIOS->pLeft == nullptr);
+      wasRed = pIOS->isRed;
+      pChild = pIOS->pRight;
+
+      if (pIOS->pParent == pDelete)
+      {
+         pChildParent = pIOS;
+      }
+      else
+      {
+         pChildParent = pIOS->pParent;
+         replaceNode(pIOS, pChild);
+         pIOS->addRight(pDelete->pRight);
+      }
+
+      replaceNode(pDelete, pIOS);
+      pIOS->addLeft(pDelete->pLeft);
+      pIOS->isRed = pDelete->isRed;
+   }
+
+   updateToRoot(pChildParent);
+
+   // removing a black node shortens every path through it by one
+   if (!wasRed)
+   {
+      balanceErase(pChild, pChildParent);
+   }
+}
+
+/*****************************************************
+ * BST :: NTH
+ * The element with k elements before it, end() if there is none.
+ * The subtree sizes tell us which way it is at each level
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+typename BST <T, C, A, R, G, H> :: iterator BST <T, C, A, R, G, H> :: nth(size_t k) const
+{
+   static_assert(R, "nth() needs a Ranked tree");
+
+   BNode * p = root;
+   while (p != nullptr)
+   {
+      size_t numLeft = BNode::sizeOf(p->pLeft);
+      if (k < numLeft)
+      {
+         p = p->pLeft;
+      }
+      else if (k == numLeft)
+      {
+         return iterator(p);
+      }
+      else
+      {
+         k -= numLeft + 1;
+         p = p->pRight;
+      }
+   }
+   return end();
+}
+
+/*****************************************************
+ * BST :: RANK
+ * The number of elements less than t. Each time the descent goes
+ * right, the node and its left subtree are all less than t
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+size_t BST <T, C, A, R, G, H> :: rank(const T & t) const
+{
+   static_assert(R, "rank() needs a Ranked tree");
+
+   size_t num = 0;
+   BNode * p = root;
+   while (p != nullptr)
+   {
+      if (compare(p->data, t))
+      {
+         num += BNode::sizeOf(p->pLeft) + 1;
+         p = p->pRight;
+      }
+      else
+      {
+         p = p->pLeft;
+      }
+   }
+   return num;
+}
+
+/*****************************************************
+ * BST :: INDEX
+ * The number of elements before it, size() for end(). Climbing to
+ * the root, everything left of the path comes before it
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+size_t BST <T, C, A, R, G, H> :: index(iterator it) const
+{
+   static_assert(R, "index() needs a Ranked tree");
 
-      assert(pIOS->pLeft == nullptr);
-      pIOS->pLeft = pDelete->pLeft;
+   BNode * p = it.pNode;
+   if (p == nullptr)
+   {
+      return size();
+   }
 
-      if (pDelete->pLeft)
+   size_t num = BNode::sizeOf(p->pLeft);
+   for (; p->pParent != nullptr; p = p->pParent)
+   {
+      if (p->pParent->isRightChild(p))
       {
-         pDelete->pLeft->pParent = pIOS;
+         num += BNode::sizeOf(p->pParent->pLeft) + 1;
       }
+   }
+   return num;
+}
 
+/*****************************************************
+ * BST :: DISTANCE
+ * How many increments it takes to get from first to last
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+std::ptrdiff_t BST <T, C, A, R, G, H> :: distance(iterator first, iterator last) const
+{
+   static_assert(R, "distance() needs a Ranked tree");
+   return (std::ptrdiff_t)index(last) - (std::ptrdiff_t)index(first);
+}
 
+/*****************************************************
+ * BST :: AGGREGATE
+ * Combine every element in [lo, hi), in order. Go down to the first
+ * node in the range: the whole range is in its subtree. Below it,
+ * the path to lo picks up the nodes and right subtrees not less than
+ * lo, and the path to hi the nodes and left subtrees less than hi
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class GG>
+typename GG::value_type BST <T, C, A, R, G, H> :: aggregate(const T & lo, const T & hi) const
+{
+   static_assert(!std::is_void<G>::value, "aggregate() needs a tree with a Monoid");
 
-      if (pDelete->pRight != pIOS)
+   BNode * pTop = root;
+   while (pTop != nullptr)
+   {
+      if (compare(pTop->data, lo))
       {
-         if (pIOS->pRight)
-         {
-            pIOS->pRight->pParent = pIOS->pParent;
-         }
-         pIOS->pParent->pLeft = pIOS -> pRight;
+         pTop = pTop->pRight;
+      }
+      else if (!compare(pTop->data, hi))
+      {
+         pTop = pTop->pLeft;
+      }
+      else
+      {
+         break;
+      }
+   }
+   if (pTop == nullptr)
+   {
+      return G::identity();
+   }
 
+   // from lo up to pTop. Each node found comes before the ones already seen
+   typename G::value_type lower = G::identity();
+   for (BNode * p = pTop->pLeft; p != nullptr; )
+   {
+      if (compare(p->data, lo))
+      {
+         p = p->pRight;
+      }
+      else
+      {
+         lower = G::combine(G::combine(G::value(p->data), BNode::aggregateOf(p->pRight)), lower);
+         p = p->pLeft;
+      }
+   }
 
-         assert(pDelete->pRight != nullptr);
-         pIOS->pRight = pDelete->pRight;
-         pDelete->pRight->pParent = pIOS;
+   // from pTop up to hi. Each node found comes after the ones already seen
+   typename G::value_type upper = G::identity();
+   for (BNode * p = pTop->pRight; p != nullptr; )
+   {
+      if (compare(p->data, hi))
+      {
+         upper = G::combine(upper, G::combine(BNode::aggregateOf(p->pLeft), G::value(p->data)));
+         p = p->pRight;
       }
+      else
+      {
+         p = p->pLeft;
+      }
+   }
 
+   return G::combine(G::combine(lower, G::value(pTop->data)), upper);
+}
 
+/*****************************************************
+ * BST :: SPLIT
+ * Move every element into two new trees: those less than t on the
+ * left, the rest on the right. This tree is left empty. Walking down
+ * the search path, each node goes to one side along with the subtree
+ * hanging off the other way, and is joined back in on the way up.
+ * Those joins cost O(log n) in all.
+ *
+ * The halves know their sizes. With subtree sizes that is free;
+ * without, the left half is counted, which is O(n). Whoever does not
+ * need the sizes, as erase() which knows how many it took out, passes
+ * isCounted false and the halves say they are empty
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+std::pair<BST <T, C, A, R, G, H>, BST <T, C, A, R, G, H>> BST <T, C, A, R, G, H> :: splitTree(const T & t, bool isCounted)
+{
+   std::pair<BST, BST> halves(BST(compare, get_allocator()), BST(compare, get_allocator()));
 
-      pIOS->pParent = pDelete->pParent;
+   BNode * pLeft = nullptr;
+   BNode * pRight = nullptr;
+   int heightLeft = 0;
+   int heightRight = 0;
+   splitNodes(root, blackHeight(root), t, pLeft, heightLeft, pRight, heightRight);
 
-      if (pDelete->pParent && pDelete->pParent->pLeft == pDelete)
+   halves.first.root  = pLeft;
+   halves.second.root = pRight;
+   if (pPool)
+   {
+      // the halves share the pool this tree hands on, which takes its
+      // lock from now on so they can go to different threads
+      halves.first.pPool = halves.second.pPool = pPool;
+      pPool->acquire();
+      pPool->acquire();
+   }
+   halves.first.resetEnds();
+   halves.second.resetEnds();
+   if constexpr (H)
+   {
+      // the nodes keep their order, so only the link across the cut goes
+      if (halves.first.pLast)
       {
-         pDelete->pParent->pLeft = pIOS;
+         halves.first.pLast->pNext = nullptr;
       }
-      if (pDelete->pParent && pDelete->pParent->pRight == pDelete)
+      if (halves.second.pFirst)
       {
-         pDelete->pParent->pRight = pIOS;
+         halves.second.pFirst->pPrev = nullptr;
       }
+   }
+   if constexpr (R)
+   {
+      halves.first.numElements  = BNode::sizeOf(pLeft);
+      halves.second.numElements = BNode::sizeOf(pRight);
+   }
+   else if (isCounted)
+   {
+      halves.first.numElements  = countNodes(pLeft);
+      halves.second.numElements = numElements - halves.first.numElements;
+   }
+   root = pFirst = pLast = nullptr;
+   numElements = 0;
+   return halves;
+}
+
+/*****************************************************
+ * BST :: JOIN
+ * Concatenate two trees where everything in left is less than
+ * everything in right. The largest node of left is taken out and
+ * used as the key between them. Both trees are left empty
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> BST <T, C, A, R, G, H> :: join(BST && left, BST && right)
+{
+   if (left.root == nullptr)
+   {
+      BST tree(std::move(right));
+      return tree;
+   }
+   if (right.root == nullptr)
+   {
+      BST tree(std::move(left));
+      return tree;
+   }
+
+   BNode * pMax = left.pLast;
+   left.unlinkNode(pMax);
+   left.numElements--;
+
+   return joinTrees(std::move(left), pMax, std::move(right));
+}
+
+/*****************************************************
+ * BST :: JOIN WITH KEY
+ * Concatenate left, t, and right, where t is greater than everything
+ * in left and less than everything in right
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> BST <T, C, A, R, G, H> :: join(BST && left, const T & t, BST && right)
+{
+   BNode * pKey = nullptr;
+   try
+   {
+      pKey = left.createNode(t);
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   return joinTrees(std::move(left), pKey, std::move(right));
+}
+
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> BST <T, C, A, R, G, H> :: join(BST && left, T && t, BST && right)
+{
+   BNode * pKey = nullptr;
+   try
+   {
+      pKey = left.createNode(std::move(t));
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   return joinTrees(std::move(left), pKey, std::move(right));
+}
+
+/*****************************************************
+ * BST :: JOIN TREES
+ * Concatenate left, the lone node pKey, and right into a new tree.
+ * The nodes are relinked, so both trees must share an allocator
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+BST <T, C, A, R, G, H> BST <T, C, A, R, G, H> :: joinTrees(BST && left, BNode * pKey, BST && right) noexcept
+{
+   if constexpr (!usesPool)
+   {
+      assert(left.alloc == right.alloc);
+   }
+
+   BST tree(left.compare, left.get_allocator());
+   // the tree carries on with one of the pools. Nodes from the other
+   // still go back to it, and it lasts until they have. Its owner may
+   // still be around to free into it too, so it is shared now
+   pool <BNode> * & pPoolOther = left.pPool ? right.pPool : left.pPool;
+   std::swap(tree.pPool, left.pPool ? left.pPool : right.pPool);
+   if (pPoolOther)
+   {
+      pPoolOther->share();
+   }
+   int height = 0;
+   tree.root = joinNodes(left.root, blackHeight(left.root), pKey,
+                         right.root, blackHeight(right.root), height);
+   tree.pFirst = left.root  ? left.pFirst : pKey;
+   tree.pLast  = right.root ? right.pLast : pKey;
+   if constexpr (H)
+   {
+      linkInOrder(left.pLast, pKey);
+      linkInOrder(pKey, right.pFirst);
+   }
+   tree.numElements = left.numElements + 1 + right.numElements;
+
+   left.root = left.pFirst = left.pLast = nullptr;
+   right.root = right.pFirst = right.pLast = nullptr;
+   left.numElements = right.numElements = 0;
+   return tree;
+}
+
+/*****************************************************
+ * BST :: SPLIT NODES
+ * Split the subtree pNode, black with the given black height or
+ * nullptr, into the nodes less than k and the rest. The roots that
+ * come back are black and their black heights are reported
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+void BST <T, C, A, R, G, H> :: splitNodes(BNode * pNode, int height, const K & k,
+                                 BNode * & pLeft, int & heightLeft, BNode * & pRight, int & heightRight)
+{
+   if (pNode == nullptr)
+   {
+      pLeft = pRight = nullptr;
+      heightLeft = heightRight = 0;
+      return;
+   }
 
-      if (root == pDelete)
+   // cut the children loose. A red child made black is one taller
+   BNode * pChildren[2] = { pNode->pLeft, pNode->pRight };
+   int heights[2] = { 0, 0 };
+   for (int i = 0; i < 2; i++)
+   {
+      if (pChildren[i] != nullptr)
       {
-         root = pIOS;
+         pChildren[i]->pParent = nullptr;
+         heights[i] = pChildren[i]->isRed ? height : height - 1;
+         pChildren[i]->isRed = false;
       }
+   }
+   pNode->pLeft = pNode->pRight = nullptr;
 
-      itNext = iterator(pIOS);
+   if (compare(pNode->data, k))
+   {
+      // pNode and its left subtree are on the left
+      BNode * pMiddle = nullptr;
+      int heightMiddle = 0;
+      splitNodes(pChildren[1], heights[1], k, pMiddle, heightMiddle, pRight, heightRight);
+      pLeft = joinNodes(pChildren[0], heights[0], pNode, pMiddle, heightMiddle, heightLeft);
    }
+   else
+   {
+      // pNode and its right subtree are on the right
+      BNode * pMiddle = nullptr;
+      int heightMiddle = 0;
+      splitNodes(pChildren[0], heights[0], k, pLeft, heightLeft, pMiddle, heightMiddle);
+      pRight = joinNodes(pMiddle, heightMiddle, pNode, pChildren[1], heights[1], heightRight);
+   }
+}
 
+/*****************************************************
+ * BST :: JOIN NODES
+ * Join the subtrees pLeft and pRight, both black or nullptr, around
+ * the lone node pKey. Go down the facing spine of the taller one to a
+ * black node as tall as the shorter one, put pKey there in red with
+ * those two as its children, and rebalance as after an insert. That
+ * costs O(|heightLeft - heightRight| + 1). Returns the new black root
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: joinNodes(BNode * pLeft, int heightLeft, BNode * pKey,
+                                                                 BNode * pRight, int heightRight, int & height) noexcept
+{
+   pKey->pLeft = pKey->pRight = pKey->pParent = nullptr;
 
-   numElements--;
-   delete pDelete;
-   return itNext;
+   if (heightLeft == heightRight)
+   {
+      pKey->addLeft(pLeft);
+      pKey->addRight(pRight);
+      pKey->update();
+      pKey->isRed = false;
+      height = heightLeft + 1;
+      return pKey;
+   }
+
+   BNode * pParent = nullptr;
+   if (heightLeft > heightRight)
+   {
+      BNode * p = pLeft;
+      int heightP = heightLeft;
+      while (p != nullptr && (p->isRed || heightP > heightRight))
+      {
+         heightP -= p->isRed ? 0 : 1;
+         pParent = p;
+         p = p->pRight;
+      }
+      pKey->addLeft(p);
+      pKey->addRight(pRight);
+      pParent->addRight(pKey);
+   }
+   else
+   {
+      BNode * p = pRight;
+      int heightP = heightRight;
+      while (p != nullptr && (p->isRed || heightP > heightLeft))
+      {
+         heightP -= p->isRed ? 0 : 1;
+         pParent = p;
+         p = p->pLeft;
+      }
+      pKey->addRight(p);
+      pKey->addLeft(pLeft);
+      pParent->addLeft(pKey);
+   }
+
+   pKey->isRed = true;
+   updateToRoot(pKey);
+   bool grew = pKey->balance();
+   height = (heightLeft > heightRight ? heightLeft : heightRight) + (grew ? 1 : 0);
+
+   BNode * pRoot = pKey;
+   while (pRoot->pParent != nullptr)
+   {
+      pRoot = pRoot->pParent;
+   }
+   return pRoot;
+}
+
+/*****************************************************
+ * BST :: BLACK HEIGHT
+ * The number of black nodes on the way down to a leaf, which is
+ * the same whichever way we go
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+int BST <T, C, A, R, G, H> :: blackHeight(const BNode * pNode) noexcept
+{
+   int height = 0;
+   for (; pNode != nullptr; pNode = pNode->pLeft)
+   {
+      if (!pNode->isRed)
+      {
+         height++;
+      }
+   }
+   return height;
+}
+
+/*****************************************************
+ * BST :: COUNT NODES
+ * The number of nodes in a subtree
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+size_t BST <T, C, A, R, G, H> :: countNodes(const BNode * pNode) noexcept
+{
+   size_t num = 0;
+   for (; pNode != nullptr; pNode = pNode->pRight)
+   {
+      num += 1 + countNodes(pNode->pLeft);
+   }
+   return num;
 }
 
 /*****************************************************
  * BST :: CLEAR
  * Removes all the BNodes from a tree
  ****************************************************/
-template <typename T>
-void BST <T> ::clear() noexcept
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> ::clear() noexcept
 {
 
    if (root)
    {
-      deleteBinaryTree(root);
+      deleteBinaryTree(root);
+   }
+   pFirst = pLast = nullptr;
+   numElements = 0;
+
+}
+
+/*****************************************************
+ * BST :: POP FRONT
+ * Remove the smallest element. Finding it is free, and so is finding
+ * the one that takes its place, so all this costs is the rebalance:
+ * amortized O(1)
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: pop_front() noexcept
+{
+   assert(pFirst != nullptr);
+   BNode * pDelete = pFirst;
+   unlinkNode(pDelete);
+   numElements--;
+   destroyNode(pDelete);
+}
+
+/*****************************************************
+ * BST :: POP BACK
+ * Remove the largest element, the mirror image of pop_front()
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: pop_back() noexcept
+{
+   assert(pLast != nullptr);
+   BNode * pDelete = pLast;
+   unlinkNode(pDelete);
+   numElements--;
+   destroyNode(pDelete);
+}
+
+/*****************************************************
+ * BST :: RESET ENDS
+ * Find the left-most and right-most nodes again after the tree was
+ * put together some other way than one node at a time
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: resetEnds() noexcept
+{
+   pFirst = pLast = root;
+   while (pFirst != nullptr && pFirst->pLeft != nullptr)
+   {
+      pFirst = pFirst->pLeft;
+   }
+   while (pLast != nullptr && pLast->pRight != nullptr)
+   {
+      pLast = pLast->pRight;
+   }
+}
+
+/*****************************************************
+ * BST :: THREAD NODES
+ * Link a subtree's nodes in order, the first one after pPrev, and
+ * return the last. A no-op unless the tree is Threaded
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: threadNodes(BNode * pNode, BNode * pPrev) noexcept
+{
+   if constexpr (H)
+   {
+      if (pNode == nullptr)
+      {
+         if (pPrev)
+         {
+            pPrev->pNext = nullptr;
+         }
+         return pPrev;
+      }
+      for (; pNode != nullptr; pNode = pNode->pRight)
+      {
+         pPrev = threadNodes(pNode->pLeft, pPrev);
+         linkInOrder(pPrev, pNode);
+         pPrev = pNode;
+      }
+      pPrev->pNext = nullptr;
+   }
+   return pPrev;
+}
+
+/*****************************************************
+ * BST :: LINK IN ORDER
+ * Make pPrev and pNext neighbors, either of which may be nullptr
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: linkInOrder(BNode * pPrev, BNode * pNext) noexcept
+{
+   if constexpr (H)
+   {
+      if (pPrev)
+      {
+         pPrev->pNext = pNext;
+      }
+      if (pNext)
+      {
+         pNext->pPrev = pPrev;
+      }
+   }
+}
+
+
+/****************************************************
+ * BST :: FIND NODE
+ * Return the node equivalent to a given key, nullptr if none.
+ * The descent makes one comparison per level, remembering the last
+ * node that was not greater than the key. Equality is only checked
+ * once, against that node, at the bottom
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: findNode(const K & k) const
+{
+   BNode* pCandidate = nullptr;
+   BNode* p = root;
+   while (p != nullptr)
+   {
+      if (compare(k, p->data))
+      {
+         p = p->pLeft;
+      }
+      else
+      {
+         pCandidate = p;
+         p = p->pRight;
+      }
+   }
+   
+   if (pCandidate != nullptr && !compare(pCandidate->data, k))
+   {
+      return pCandidate;
+   }
+   return nullptr;
+}
+
+/****************************************************
+ * BST :: LOWER BOUND
+ * Return the first node not less than a given key, nullptr if none
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: lowerBound(const K & k) const
+{
+   BNode* pBound = nullptr;
+   BNode* p = root;
+   while (p != nullptr)
+   {
+      if (compare(p->data, k))
+      {
+         p = p->pRight;
+      }
+      else
+      {
+         pBound = p;
+         p = p->pLeft;
+      }
+   }
+
+   return pBound;
+}
+
+
+
+/****************************************************
+ * BST :: LOWER BOUND FROM
+ * Same as lowerBound, for a caller walking keys in increasing order
+ * who knows every node before pFrom is less than k (pFrom nullptr
+ * meaning end()). Rather than start over from the root, climb from
+ * pFrom only until the subtree reaches past k, then go back down.
+ * That costs O(log d) for a bound d nodes further on
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: lowerBoundFrom(BNode * pFrom, const K & k) const
+{
+   if (pFrom == nullptr || !compare(pFrom->data, k))
+   {
+      return pFrom;
+   }
+
+   // climb. A left child's parent is the first node past its subtree
+   BNode* pBound = nullptr;
+   BNode* p = pFrom;
+   while (p->pParent != nullptr)
+   {
+      if (p->pParent->pLeft == p && !compare(p->pParent->data, k))
+      {
+         pBound = p->pParent;
+         break;
+      }
+      p = p->pParent;
+   }
+
+   // descend
+   while (p != nullptr)
+   {
+      if (compare(p->data, k))
+      {
+         p = p->pRight;
+      }
+      else
+      {
+         pBound = p;
+         p = p->pLeft;
+      }
+   }
+
+   return pBound;
+}
+
+/****************************************************
+ * BST :: UPPER BOUND
+ * Return the first node greater than a given key, nullptr if none
+ ****************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: upperBound(const K & k) const
+{
+   BNode* pBound = nullptr;
+   BNode* p = root;
+   while (p != nullptr)
+   {
+      if (compare(k, p->data))
+      {
+         pBound = p;
+         p = p->pLeft;
+      }
+      else
+      {
+         p = p->pRight;
+      }
    }
-   numElements = 0;
 
+   return pBound;
 }
 
-/*****************************************************
- * BST :: BEGIN
- * Return the first node (left-most) in a binary search tree
+/****************************************************
+ * BST :: EQUAL RANGE
+ * Return [lower bound, upper bound) for a given key in one descent.
+ * Both bounds share the path down to the first node equivalent to
+ * the key. From there the lower bound is in its left subtree and the
+ * upper bound in its right subtree
  ****************************************************/
-template <typename T>
-typename BST <T> :: iterator custom :: BST <T> :: begin() const noexcept
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+std::pair<typename BST <T, C, A, R, G, H> :: iterator, typename BST <T, C, A, R, G, H> :: iterator>
+BST <T, C, A, R, G, H> :: equalRange(const K & k) const
 {
-   
-   
-   if (root == nullptr)
-   {
-      return end();
-   }
-   
+   BNode* pLower = nullptr;
+   BNode* pUpper = nullptr;
    BNode* p = root;
-   while (p->pLeft)
+   while (p != nullptr)
    {
-      p = p->pLeft;
+      if (compare(p->data, k))
+      {
+         p = p->pRight;
+      }
+      else if (compare(k, p->data))
+      {
+         pLower = pUpper = p;
+         p = p->pLeft;
+      }
+      else
+      {
+         pLower = p;
+         for (BNode* pLeft = p->pLeft; pLeft != nullptr; )
+         {
+            if (compare(pLeft->data, k))
+            {
+               pLeft = pLeft->pRight;
+            }
+            else
+            {
+               pLower = pLeft;
+               pLeft = pLeft->pLeft;
+            }
+         }
+         for (BNode* pRight = p->pRight; pRight != nullptr; )
+         {
+            if (compare(k, pRight->data))
+            {
+               pUpper = pRight;
+               pRight = pRight->pLeft;
+            }
+            else
+            {
+               pRight = pRight->pRight;
+            }
+         }
+         break;
+      }
    }
-   
-   
-   
-   return iterator(p);
-}
 
+   return std::pair<iterator, iterator>(iterator(pLower), iterator(pUpper));
+}
 
-/****************************************************
- * BST :: FIND
- * Return the node corresponding to a given value
+/*****************************************************
+ * BST :: COUNT OF
+ * How many elements are equivalent to the key. Without keepUnique a
+ * key can repeat, so this walks equal_range(). With subtree sizes the
+ * ends of the range are ranked instead: O(log n) however many there are
  ****************************************************/
-template <typename T>
-typename BST <T> :: iterator BST<T> :: find(const T & t)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class K>
+size_t BST <T, C, A, R, G, H> :: countOf(const K & k) const
 {
-   
-   for (BNode* p = root; p != nullptr; p = (t < p->data ? p->pLeft: p->pRight) )
+   std::pair<iterator, iterator> range = equalRange(k);
+   if constexpr (R)
+   {
+      return index(range.second) - index(range.first);
+   }
+   else
    {
-      if (p->data == t)
+      size_t num = 0;
+      for (iterator it = range.first; it != range.second; ++it)
       {
-         return iterator(p);
+         num++;
       }
+      return num;
    }
-   
-   
-   return end();
 }
 
-
-
-template<typename T>
-void BST<T>::deleteBinaryTree(BNode*  &pDelete ) noexcept
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+size_t BST <T, C, A, R, G, H>::deleteBinaryTree(BNode*  &pDelete ) noexcept
 {
 
    if (pDelete == nullptr)
    {
-      return;
+      return 0;
    }
-   deleteBinaryTree(pDelete->pLeft);
-   deleteBinaryTree(pDelete->pRight);
+   size_t num = 1 + deleteBinaryTree(pDelete->pLeft);
+   num += deleteBinaryTree(pDelete->pRight);
 
-   delete pDelete;
+   destroyNode(pDelete);
    pDelete = nullptr;
-
+   return num;
 }
 
 
-template <typename T>
-void BST <T> ::copyBinaryTree(const BNode* pSrc, BNode *& pDest)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> ::copyBinaryTree(const BNode* pSrc, BNode *& pDest)
 {
    if (nullptr == pSrc)
    {
@@ -726,7 +2244,7 @@ void BST <T> ::copyBinaryTree(const BNode* pSrc, BNode *& pDest)
    {
       if (pDest == nullptr)
       {
-         pDest = new BST::BNode(pSrc->data);
+         pDest = createNode(pSrc->data);
       }
       else
       {
@@ -753,167 +2271,298 @@ void BST <T> ::copyBinaryTree(const BNode* pSrc, BNode *& pDest)
    {
       pDest->pRight->pParent = pDest;
    }
+   pDest->update();
 
 
 }
 
 
 
-template <typename T>
-void BST < T> ::deleteNode(BNode*& pDelete, bool toRight)
+/******************************************************
+ * BST :: CREATE NODE
+ * Allocate and construct a node from the tree's allocator, or with
+ * the default allocator, from the tree's own pool
+ ******************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+template <class ... Args>
+typename BST <T, C, A, R, G, H> :: BNode * BST <T, C, A, R, G, H> :: createNode(Args && ... args)
 {
-   BNode* pNext = (toRight ? pDelete->pRight : pDelete->pLeft);
-
-   if (pDelete != root)
+   if constexpr (usesPool)
    {
-      if (pDelete->pParent->pLeft == pDelete)
+      void * p = nodePool().allocate();
+      try
       {
-         pDelete->pParent->pLeft = nullptr;
-         pDelete->pParent->addLeft(pNext);
+         return ::new (p) BNode(std::forward<Args>(args)...);
       }
-      else
+      catch (...)
       {
-         pDelete->pParent->pRight = nullptr;
-         pDelete->pParent->addRight(pNext);
+         pool <BNode> :: deallocate(p);
+         throw;
       }
-
    }
    else
    {
-      root = pNext;
-      pNext->pParent = nullptr;
+      BNode * pNode = NodeTraits::allocate(alloc, 1);
+      try
+      {
+         NodeTraits::construct(alloc, pNode, std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+         NodeTraits::deallocate(alloc, pNode, 1);
+         throw;
+      }
+      return pNode;
    }
-
 }
 
-
 /******************************************************
- ******************************************************
- ******************************************************
- *********************** B NODE ***********************
- ******************************************************
- ******************************************************
+ * BST :: DESTROY NODE
+ * Destroy a node and hand its memory back to the allocator
  ******************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: destroyNode(BNode * pNode) noexcept
+{
+   if constexpr (usesPool)
+   {
+      // back to whichever pool it came from
+      delete pNode;
+   }
+   else
+   {
+      NodeTraits::destroy(alloc, pNode);
+      NodeTraits::deallocate(alloc, pNode, 1);
+   }
+}
 
- 
 /******************************************************
- * BINARY NODE :: ADD LEFT
- * Add a node to the left of the current node
+ * BST :: REPLACE NODE
+ * Hook pReplace into the spot in the tree held by pOld.
+ * pOld's own children are left untouched
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: addLeft (BNode * pNode)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: replaceNode(BNode* pOld, BNode* pReplace)
 {
-   pLeft = pNode;
-   if (pNode)
+   if (pOld->pParent == nullptr)
    {
-      pNode->pParent = this;
+      root = pReplace;
+      if (pReplace)
+      {
+         pReplace->pParent = nullptr;
+      }
    }
+   else if (pOld->pParent->isLeftChild(pOld))
+   {
+      pOld->pParent->addLeft(pReplace);
+   }
+   else
+   {
+      pOld->pParent->addRight(pReplace);
+   }
+}
 
+/******************************************************
+ * BST :: ROTATE LEFT
+ * Our right child takes our place and we become its left child
+ *         P                R
+ *       +-+-+            +-+-+
+ *      a     R    =>     P    c
+ *          +-+-+       +-+-+
+ *         b     c     a     b
+ ******************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: rotateLeft(BNode* pNode)
+{
+   BNode* pRight = pNode->pRight;
+   assert(pRight != nullptr);
+
+   pNode->addRight(pRight->pLeft);
+   replaceNode(pNode, pRight);
+   pRight->addLeft(pNode);
+   pNode->update();
+   pRight->update();
+}
 
-
+/******************************************************
+ * BST :: ROTATE RIGHT
+ * Our left child takes our place and we become its right child
+ *           P            L
+ *         +-+-+        +-+-+
+ *        L     c  =>  a     P
+ *      +-+-+              +-+-+
+ *     a     b            b     c
+ ******************************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: rotateRight(BNode* pNode)
+{
+   BNode* pLeft = pNode->pLeft;
+   assert(pLeft != nullptr);
+
+   pNode->addLeft(pLeft->pRight);
+   replaceNode(pNode, pLeft);
+   pLeft->addRight(pNode);
+   pNode->update();
+   pLeft->update();
 }
 
 /******************************************************
- * BINARY NODE :: ADD RIGHT
- * Add a node to the right of the current node
+ * BST :: UPDATE TO ROOT
+ * Something below pNode was added, removed, or moved, so the subtree
+ * sizes and aggregates from pNode up to the root are stale. Nothing
+ * to do for a tree that keeps neither
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: addRight (BNode * pNode)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: updateToRoot(BNode * pNode) noexcept
 {
-   pRight = pNode;
-   if (pNode)
+   if constexpr (R || !std::is_void<G>::value)
    {
-      pNode->pParent = this;
+      for (; pNode != nullptr; pNode = pNode->pParent)
+      {
+         pNode->update();
+      }
    }
 }
 
 /******************************************************
- * BINARY NODE :: ADD LEFT
- * Add a node to the left of the current node
+ * BST :: BALANCE ERASE
+ * A black node was removed from above pNode, so every path through
+ * pNode is one black node short. pNode may be nullptr, which is why
+ * the parent is passed along separately. This is the erase
+ * counterpart to BNode::balance()
  ******************************************************/
-template <typename T>
-void BST<T> :: BNode :: addLeft (const T & t)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: balanceErase(BNode* pNode, BNode* pParent)
 {
-   assert(pLeft == nullptr);
-
-   try
-   {
-      BNode* pNode = new BNode(t);
-      addLeft(pNode);
-      pNode->balance();
-   }
-   catch (...)
+   while (pNode != root && (pNode == nullptr || pNode->isRed == false))
    {
-      throw "ERROR: Unable to allocate a node";
-   }
+      assert(pParent != nullptr);
 
+      if (pParent->pLeft == pNode)
+      {
+         BNode* pSibling = pParent->pRight;
+         assert(pSibling != nullptr);
 
+         // Case 1: red sibling. Rotate it above the parent so we get a black one
+         if (pSibling->isRed)
+         {
+            pSibling->isRed = false;
+            pParent->isRed = true;
+            rotateLeft(pParent);
+            pSibling = pParent->pRight;
+         }
 
-}
+         // Case 2: black sibling with black children. Push the shortage up
+         if ((pSibling->pLeft  == nullptr || !pSibling->pLeft->isRed) &&
+             (pSibling->pRight == nullptr || !pSibling->pRight->isRed))
+         {
+            pSibling->isRed = true;
+            pNode = pParent;
+            pParent = pNode->pParent;
+            continue;
+         }
 
-/******************************************************
- * BINARY NODE :: ADD LEFT
- * Add a node to the left of the current node
- ******************************************************/
-template <typename T>
-void BST<T> ::BNode::addLeft(T && t)
-{
+         // Case 3: sibling's near child is red. Rotate it to the far side
+         if (pSibling->pRight == nullptr || !pSibling->pRight->isRed)
+         {
+            pSibling->pLeft->isRed = false;
+            pSibling->isRed = true;
+            rotateRight(pSibling);
+            pSibling = pParent->pRight;
+         }
 
-   assert(pLeft == nullptr);
+         // Case 4: sibling's far child is red. One rotation fixes everything
+         pSibling->isRed = pParent->isRed;
+         pParent->isRed = false;
+         pSibling->pRight->isRed = false;
+         rotateLeft(pParent);
+         pNode = root;
+      }
+      else
+      {
+         BNode* pSibling = pParent->pLeft;
+         assert(pSibling != nullptr);
 
-   try
-   {
-      BNode* pNode = new BNode(std::move(t));
-      addLeft(pNode);
-      pNode->balance();
+         // Case 1: red sibling
+         if (pSibling->isRed)
+         {
+            pSibling->isRed = false;
+            pParent->isRed = true;
+            rotateRight(pParent);
+            pSibling = pParent->pLeft;
+         }
+
+         // Case 2: black sibling with black children
+         if ((pSibling->pLeft  == nullptr || !pSibling->pLeft->isRed) &&
+             (pSibling->pRight == nullptr || !pSibling->pRight->isRed))
+         {
+            pSibling->isRed = true;
+            pNode = pParent;
+            pParent = pNode->pParent;
+            continue;
+         }
+
+         // Case 3: sibling's near child is red
+         if (pSibling->pLeft == nullptr || !pSibling->pLeft->isRed)
+         {
+            pSibling->pRight->isRed = false;
+            pSibling->isRed = true;
+            rotateLeft(pSibling);
+            pSibling = pParent->pLeft;
+         }
+
+         // Case 4: sibling's far child is red
+         pSibling->isRed = pParent->isRed;
+         pParent->isRed = false;
+         pSibling->pLeft->isRed = false;
+         rotateRight(pParent);
+         pNode = root;
+      }
    }
-   catch (...)
+
+   if (pNode)
    {
-      throw "ERROR: Unable to allocate a node";
+      pNode->isRed = false;
    }
+}
 
 
-}
+/******************************************************
+ ******************************************************
+ ******************************************************
+ *********************** B NODE ***********************
+ ******************************************************
+ ******************************************************
+ ******************************************************/
 
+ 
 /******************************************************
- * BINARY NODE :: ADD RIGHT
- * Add a node to the right of the current node
+ * BINARY NODE :: ADD LEFT
+ * Add a node to the left of the current node
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: addRight (const T & t)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: BNode :: addLeft (BNode * pNode)
 {
-   assert(pRight == nullptr);
-
-   try
-   {
-      BNode* pNode = new BNode(t);
-      addRight(pNode);
-      pNode->balance();
-   }
-   catch (...)
+   pLeft = pNode;
+   if (pNode)
    {
-      throw "ERROR: Unable to allocate a node";
+      pNode->pParent = this;
    }
+
+
+
 }
 
 /******************************************************
  * BINARY NODE :: ADD RIGHT
  * Add a node to the right of the current node
  ******************************************************/
-template <typename T>
-void BST <T> ::BNode::addRight(T && t)
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+void BST <T, C, A, R, G, H> :: BNode :: addRight (BNode * pNode)
 {
-   assert(pRight == nullptr);
-
-   try
-   {
-      BNode* pNode = new BNode(std::move(t));
-      addRight(pNode);
-      pNode->balance();
-   }
-   catch (...)
+   pRight = pNode;
+   if (pNode)
    {
-      throw "ERROR: Unable to allocate a node";
+      pNode->pParent = this;
    }
 }
 
@@ -923,8 +2572,8 @@ void BST <T> ::BNode::addRight(T && t)
  * Find the depth of the black nodes. This is useful for
  * verifying that a given red-black tree is valid
  ****************************************************/
-template <typename T>
-int BST <T> :: BNode :: findDepth() const
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+int BST <T, C, A, R, G, H> :: BNode :: findDepth() const
 {
    // if there are no children, the depth is ourselves
    if (pRight == nullptr && pLeft == nullptr)
@@ -941,8 +2590,8 @@ int BST <T> :: BNode :: findDepth() const
  * BINARY NODE :: VERIFY RED BLACK
  * Do all four red-black rules work here?
  ***************************************************/
-template <typename T>
-bool BST <T> :: BNode :: verifyRedBlack(int depth) const
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+bool BST <T, C, A, R, G, H> :: BNode :: verifyRedBlack(int depth) const
 {
    bool fReturn = true;
    depth -= (isRed == false) ? 1 : 0;
@@ -986,8 +2635,8 @@ bool BST <T> :: BNode :: verifyRedBlack(int depth) const
  * VERIFY B TREE
  * Verify that the tree is correctly formed
  ******************************************************/
-template <typename T>
-std::pair <T, T> BST <T> :: BNode :: verifyBTree() const
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+std::pair <T, T> BST <T, C, A, R, G, H> :: BNode :: verifyBTree() const
 {
    // largest and smallest values
    std::pair <T, T> extremes;
@@ -1030,8 +2679,8 @@ std::pair <T, T> BST <T> :: BNode :: verifyBTree() const
  * COMPUTE SIZE
  * Verify that the BST is as large as we think it is
  ********************************************/
-template <typename T>
-int BST <T> :: BNode :: computeSize() const
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+int BST <T, C, A, R, G, H> :: BNode :: computeSize() const
 {
    return 1 +
       (pLeft  == nullptr ? 0 : pLeft->computeSize()) +
@@ -1043,20 +2692,21 @@ int BST <T> :: BNode :: computeSize() const
  * BINARY NODE :: BALANCE
  * Balance the tree from a given location
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: balance()
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+bool BST <T, C, A, R, G, H> :: BNode :: balance()
 {
    // Case 1: if we are the root, then color ourselves black and call it a day.
    if (pParent == nullptr)
    {
+      bool wasRed = isRed;
       isRed = false;
-      return;
+      return wasRed;
    }
 
    // Case 2: if the parent is black, then there is nothing left to do
    if (pParent->isRed == false)
    {
-      return;
+      return false;
    }
 
    assert(pParent->pParent != nullptr);
@@ -1079,8 +2729,7 @@ void BST <T> :: BNode :: balance()
       pGranny->isRed = true;
       pParent->isRed = false;
       pAunt->isRed = false;
-      pGranny->balance();
-      return;
+      return pGranny->balance();
    }
 
 
@@ -1101,6 +2750,8 @@ void BST <T> :: BNode :: balance()
 
       pParent->addRight(pGranny);
       pGranny->addLeft(pSibling);
+      pGranny->update();
+      pParent->update();
       pHead = pParent;
 
 
@@ -1119,6 +2770,8 @@ void BST <T> :: BNode :: balance()
 
       pParent->addLeft(pGranny);
       pGranny->addRight(pSibling);
+      pGranny->update();
+      pParent->update();
       pHead = pParent;
 
 
@@ -1139,6 +2792,9 @@ void BST <T> :: BNode :: balance()
       pParent->addRight(this->pLeft);
       this->addRight(pGranny);
       this->addLeft(pParent);
+      pGranny->update();
+      pParent->update();
+      this->update();
 
       pHead = this;
       this->isRed = false;
@@ -1157,6 +2813,9 @@ void BST <T> :: BNode :: balance()
       pParent->addLeft(this->pRight);
       this->addLeft(pGranny);
       this->addRight(pParent);
+      pGranny->update();
+      pParent->update();
+      this->update();
 
       pHead = this;
       this->isRed = false;
@@ -1179,6 +2838,7 @@ void BST <T> :: BNode :: balance()
    {
       pGreatG->addLeft(pHead);
    }
+   return false;
 }
 
 /*************************************************
@@ -1193,106 +2853,79 @@ void BST <T> :: BNode :: balance()
  * BST ITERATOR :: INCREMENT PREFIX
  * advance by one
  *************************************************/
-template <typename T>
-typename BST <T> :: iterator & BST <T> :: iterator :: operator ++ ()
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+typename BST <T, C, A, R, G, H> :: iterator & BST <T, C, A, R, G, H> :: iterator :: operator ++ ()
 {
    if (pNode == nullptr)
    {
       return *this;
    }
-   
-
 
-   if (pNode->pRight != nullptr)
+   // a Threaded tree just follows the link
+   if constexpr (H)
    {
-      pNode = pNode -> pRight;
+      pNode = pNode->pNext;
+   }
+   else if (pNode->pRight != nullptr)
+   {
+      // the left-most node of the right subtree
+      pNode = pNode->pRight;
       while (pNode->pLeft)
       {
          pNode = pNode->pLeft;
       }
-      return *this;
-   }
-
-
-   assert(pNode->pRight == nullptr);
-   const BNode* pSave = pNode;
-   
-
-   pNode = pNode->pParent;
-
-   if (pNode == nullptr)
-   {
-      return *this;
    }
-
-
-   if (pSave == pNode->pLeft)
-   {
-      return *this;
-   }
-   
-   while (pNode != nullptr && pSave == pNode->pRight)
+   else
    {
-      pSave = pNode;
+      // climb until we come up from a left child
+      const BNode* pSave = pNode;
       pNode = pNode->pParent;
+      while (pNode != nullptr && pSave == pNode->pRight)
+      {
+         pSave = pNode;
+         pNode = pNode->pParent;
+      }
    }
-
-
-   return *this;  
+   return *this;
 }
 
 /**************************************************
  * BST ITERATOR :: DECREMENT PREFIX
  * advance by one
  *************************************************/
-template <typename T>
-typename BST <T> :: iterator & BST <T> :: iterator :: operator -- ()
+template <typename T, typename C, typename A, bool R, typename G, bool H>
+typename BST <T, C, A, R, G, H> :: iterator & BST <T, C, A, R, G, H> :: iterator :: operator -- ()
 {
    if (pNode == nullptr)
    {
       return *this;
    }
 
-
-
-   if (pNode->pLeft != nullptr)
+   if constexpr (H)
+   {
+      pNode = pNode->pPrev;
+   }
+   else if (pNode->pLeft != nullptr)
    {
+      // the right-most node of the left subtree
       pNode = pNode->pLeft;
-
       while (pNode->pRight)
       {
          pNode = pNode->pRight;
       }
-      return *this;
-   }
-
-
-   assert(pNode->pLeft == nullptr);
-   const BNode* pSave = pNode;
-
-
-   pNode = pNode->pParent;
-
-   if (pNode == nullptr)
-   {
-      return *this;
-   }
-
-
-   if (pSave == pNode->pRight)
-   {
-      return *this;
    }
-
-   while (pNode != nullptr && pSave == pNode->pLeft)
+   else
    {
-      pSave = pNode;
+      // climb until we come up from a right child
+      const BNode* pSave = pNode;
       pNode = pNode->pParent;
+      while (pNode != nullptr && pSave == pNode->pLeft)
+      {
+         pSave = pNode;
+         pNode = pNode->pParent;
+      }
    }
-
-
    return *this;
-
 }
 
 
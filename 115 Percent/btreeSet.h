@@ -0,0 +1,1198 @@
+/***********************************************************************
+ * Header:
+ *    B-TREE SET
+ * Summary:
+ *    A set that keeps many elements in each node
+ *
+ *    This will contain the class definition of:
+ *        btree_set           : A set stored in a B-tree
+ *        btree_set::iterator : An iterator through btree_set
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>   // for std::equal
+#include <cassert>
+#include <cstddef>     // for size_t and std::ptrdiff_t
+#include <functional>  // for std::less
+#include <iterator>    // for std::bidirectional_iterator_tag
+#include <new>         // for placement new
+#include <type_traits> // for std::is_arithmetic and std::is_same
+#include <utility>     // for std::pair, std::move and std::swap
+#include "pool.h"      // for custom::shared_pool
+
+class TestBTreeSet; // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * B-TREE SET
+ * A set with the interface of custom::set, stored in a B-tree: each
+ * node holds as many elements as fit in NodeBytes, kept sorted, and
+ * a node that is not a leaf has one more child than elements. A
+ * search reads a few whole nodes instead of one cache line per level.
+ *
+ * Every node is at least about half full except the root and the
+ * nodes down the right edge of the tree. Inserting past the largest
+ * element, as when loading sorted data, splits off an empty node there
+ * instead of half a node, so the nodes it leaves behind are nearly
+ * full. Only the right edge is ever short that way, and rebalance()
+ * and merge() are fine with it: a short node is only ever merged with
+ * one sibling, and together they still fit in one node.
+ *
+ * Inserting or erasing invalidates every iterator
+ ***********************************************/
+template <typename T,
+          typename Compare = std::less<T>,
+          size_t NodeBytes = 256>
+class btree_set
+{
+   friend class ::TestBTreeSet; // give unit tests access to the privates
+
+   class Node;
+   class Internal;
+
+public:
+   using key_compare = Compare;
+
+   //
+   // Construct
+   //
+
+   btree_set() : root(nullptr), numElements(0), compare()
+   {
+   }
+   explicit btree_set(const Compare & compare) : root(nullptr), numElements(0), compare(compare)
+   {
+   }
+   btree_set(const std::initializer_list <T> & il) : root(nullptr), numElements(0), compare()
+   {
+      insert(il.begin(), il.end());
+   }
+   template <class Iterator>
+   btree_set(Iterator first, Iterator last) : root(nullptr), numElements(0), compare()
+   {
+      insert(first, last);
+   }
+   btree_set(const btree_set & rhs) : root(nullptr), numElements(0), compare(rhs.compare)
+   {
+      root = copyNode(rhs.root, nullptr);
+      numElements = rhs.numElements;
+   }
+   btree_set(btree_set && rhs) noexcept : root(rhs.root), numElements(rhs.numElements),
+      compare(rhs.compare)
+   {
+      rhs.root = nullptr;
+      rhs.numElements = 0;
+   }
+   ~btree_set()
+   {
+      clear();
+   }
+
+   //
+   // Assign
+   //
+
+   btree_set & operator = (const btree_set & rhs)
+   {
+      btree_set copy(rhs);
+      swap(copy);
+      return *this;
+   }
+   btree_set & operator = (btree_set && rhs) noexcept
+   {
+      clear();
+      swap(rhs);
+      return *this;
+   }
+   btree_set & operator = (const std::initializer_list <T> & il)
+   {
+      clear();
+      insert(il.begin(), il.end());
+      return *this;
+   }
+   void swap(btree_set & rhs) noexcept
+   {
+      std::swap(root, rhs.root);
+      std::swap(numElements, rhs.numElements);
+      std::swap(compare, rhs.compare);
+   }
+
+   //
+   // Iterator
+   //
+
+   class iterator;
+   using const_iterator = iterator;   // elements are never changed in place
+   iterator begin()  const noexcept;
+   iterator end()    const noexcept { return iterator(); }
+
+   // walk backwards with --: the iterator falls off the front to rend()
+   iterator rbegin() const noexcept;
+   iterator rend()   const noexcept { return iterator(); }
+
+   //
+   // Access
+   //
+
+   iterator find(const T & t)        const;
+   iterator lower_bound(const T & t) const;
+   iterator upper_bound(const T & t) const;
+   std::pair<iterator, iterator> equal_range(const T & t) const
+   {
+      return std::pair<iterator, iterator>(lower_bound(t), upper_bound(t));
+   }
+   size_t count(const T & t)    const { return contains(t) ? 1 : 0; }
+   bool   contains(const T & t) const { return find(t) != end();    }
+
+   // the smallest and largest elements: not for an empty set
+   const T & front() const { assert(root); return *begin();  }
+   const T & back()  const { assert(root); return *rbegin(); }
+
+   //
+   // Insert
+   //
+
+   std::pair<iterator, bool> insert(const T & t) { return insertUnique(t);            }
+   std::pair<iterator, bool> insert(T && t)      { return insertUnique(std::move(t)); }
+   template <class ... Args>
+   std::pair<iterator, bool> emplace(Args && ... args)
+   {
+      T t(std::forward<Args>(args)...);
+      return insertUnique(std::move(t));
+   }
+   void insert(const std::initializer_list <T> & il)
+   {
+      insert(il.begin(), il.end());
+   }
+   template <class Iterator>
+   void insert(Iterator first, Iterator last)
+   {
+      for (; first != last; ++first)
+      {
+         insertUnique(*first);
+      }
+   }
+
+   //
+   // Remove
+   //
+
+   iterator erase(iterator it);
+   iterator erase(iterator first, iterator last);
+   size_t erase(const T & t)
+   {
+      iterator it = find(t);
+      if (it == end())
+      {
+         return 0;
+      }
+      erase(it);
+      return 1;
+   }
+   void clear() noexcept
+   {
+      deleteNode(root);
+      root = nullptr;
+      numElements = 0;
+   }
+
+   //
+   // Status
+   //
+
+   bool   empty() const noexcept { return numElements == 0; }
+   size_t size()  const noexcept { return numElements;      }
+   key_compare key_comp() const  { return compare;          }
+
+private:
+
+   // as many elements as fit in NodeBytes after the node's bookkeeping,
+   // but at least three so a full node can be split around a middle one
+   static constexpr size_t numHeader = sizeof(void *) + 2 * sizeof(unsigned short) + sizeof(bool);
+   static constexpr size_t numSlots  = (NodeBytes > numHeader + 3 * sizeof(T)) ?
+                                       (NodeBytes - numHeader) / sizeof(T) : 3;
+   static_assert(numSlots < 65535, "NodeBytes is too large for the node bookkeeping");
+
+   // the fewest elements a node other than the root may hold
+   static constexpr size_t minKeys = (numSlots - 1) / 2;
+
+   // arithmetic keys in their natural order are found by counting the
+   // smaller keys in a node: no branches, and a loop the compiler can
+   // turn into SIMD compares. Anything else uses a binary search
+   static constexpr bool searchByCount = std::is_arithmetic<T>::value &&
+      (std::is_same<Compare, std::less<T>>::value || std::is_same<Compare, std::less<>>::value);
+
+   size_t lowerBoundIn(const Node * pNode, const T & t) const;
+   size_t upperBoundIn(const Node * pNode, const T & t) const;
+
+   template <class U>
+   std::pair<iterator, bool> insertUnique(U && t);
+   void split(Node * pNode, bool atEnd);
+   static bool onRightEdge(const Node * pNode) noexcept;
+   void rebalance(Node * pNode);
+   void rotateLeft(Internal * pParent, size_t i);
+   void rotateRight(Internal * pParent, size_t i);
+   void merge(Internal * pParent, size_t i);
+
+   static Node * newNode(bool isLeaf);
+   static void destroyNode(Node * pNode) noexcept;
+   static void deleteNode(Node * pNode) noexcept;
+   static Node * copyNode(const Node * pSrc, Internal * pParent);
+
+   Node * root;           // root node of the B-tree, nullptr when empty
+   size_t numElements;    // number of elements
+   Compare compare;       // strict weak ordering of the elements
+};
+
+/************************************************
+ * B-TREE SET :: NODE
+ * A leaf: up to numSlots elements in order. The elements live in raw
+ * storage so only the first num of them are ever constructed
+ ***********************************************/
+template <typename T, typename C, size_t N>
+class btree_set <T, C, N> :: Node
+{
+public:
+   explicit Node(bool isLeaf) : pParent(nullptr), position(0), num(0), isLeaf(isLeaf)
+   {
+   }
+   ~Node()
+   {
+      for (size_t i = 0; i < num; i++)
+      {
+         key(i).~T();
+      }
+   }
+
+   //
+   // Allocate: nodes come out of a shared slab pool rather than the heap
+   //
+   static void * operator new(size_t size)
+   {
+      assert(size == sizeof(Node));
+      return shared_pool <Node> :: instance().allocate();
+   }
+   static void operator delete(void * p) noexcept
+   {
+      shared_pool <Node> :: instance().deallocate(p);
+   }
+
+   //
+   // Access
+   //
+   T &       key(size_t i)       { return reinterpret_cast<T *>(keys)[i];       }
+   const T & key(size_t i) const { return reinterpret_cast<const T *>(keys)[i]; }
+   Node *       child(size_t i);
+   const Node * child(size_t i) const;
+
+   //
+   // Insert and remove, shifting the elements after i
+   //
+   template <class U>
+   void insertKey(size_t i, U && t);
+   void eraseKey(size_t i);
+
+   Internal * pParent;          // nullptr for the root
+   unsigned short position;     // which child of pParent we are
+   unsigned short num;          // elements in use
+   bool isLeaf;                 // no children?
+   alignas(T) unsigned char keys[numSlots * sizeof(T)];
+};
+
+/************************************************
+ * B-TREE SET :: INTERNAL
+ * A node that is not a leaf: a child before, between, and after its
+ * elements. Child i holds everything between elements i-1 and i
+ ***********************************************/
+template <typename T, typename C, size_t N>
+class btree_set <T, C, N> :: Internal : public btree_set <T, C, N> :: Node
+{
+public:
+   Internal() : Node(false)
+   {
+      for (size_t i = 0; i <= numSlots; i++)
+      {
+         children[i] = nullptr;
+      }
+   }
+
+   static void * operator new(size_t size)
+   {
+      assert(size == sizeof(Internal));
+      return shared_pool <Internal> :: instance().allocate();
+   }
+   static void operator delete(void * p) noexcept
+   {
+      shared_pool <Internal> :: instance().deallocate(p);
+   }
+
+   // hang pChild at i, which it now knows
+   void setChild(size_t i, Node * pChild)
+   {
+      children[i] = pChild;
+      pChild->pParent = this;
+      pChild->position = (unsigned short)i;
+   }
+
+   Node * children[numSlots + 1];
+};
+
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: Node * btree_set <T, C, N> :: Node :: child(size_t i)
+{
+   assert(!isLeaf && i <= num);
+   return static_cast<Internal *>(this)->children[i];
+}
+
+template <typename T, typename C, size_t N>
+const typename btree_set <T, C, N> :: Node * btree_set <T, C, N> :: Node :: child(size_t i) const
+{
+   assert(!isLeaf && i <= num);
+   return static_cast<const Internal *>(this)->children[i];
+}
+
+/*********************************************
+ * B-TREE SET NODE :: INSERT KEY
+ * Put t at i, moving the elements from i on up by one
+ ********************************************/
+template <typename T, typename C, size_t N>
+template <class U>
+void btree_set <T, C, N> :: Node :: insertKey(size_t i, U && t)
+{
+   assert(num < numSlots && i <= num);
+   if (i == num)
+   {
+      new (&key(num)) T(std::forward<U>(t));
+   }
+   else
+   {
+      new (&key(num)) T(std::move(key(num - 1)));
+      for (size_t j = num - 1; j > i; j--)
+      {
+         key(j) = std::move(key(j - 1));
+      }
+      key(i) = std::forward<U>(t);
+   }
+   num++;
+}
+
+/*********************************************
+ * B-TREE SET NODE :: ERASE KEY
+ * Remove the element at i, moving the ones after it down by one
+ ********************************************/
+template <typename T, typename C, size_t N>
+void btree_set <T, C, N> :: Node :: eraseKey(size_t i)
+{
+   assert(i < num);
+   for (size_t j = i + 1; j < num; j++)
+   {
+      key(j - 1) = std::move(key(j));
+   }
+   key(num - 1).~T();
+   num--;
+}
+
+/**********************************************************
+ * B-TREE SET ITERATOR
+ * A node and an element in it. Moving on from the last element of a
+ * leaf climbs back up to the first ancestor with elements left
+ *********************************************************/
+template <typename T, typename C, size_t N>
+class btree_set <T, C, N> :: iterator
+{
+   friend class ::TestBTreeSet; // give unit tests access to the privates
+   friend class btree_set <T, C, N>;
+public:
+   using iterator_category = std::bidirectional_iterator_tag;
+   using value_type        = T;
+   using difference_type   = std::ptrdiff_t;
+   using pointer           = const T *;
+   using reference         = const T &;
+
+   iterator() : pNode(nullptr), position(0)
+   {
+   }
+
+   // compare
+   bool operator == (const iterator & rhs) const
+   {
+      return pNode == rhs.pNode && position == rhs.position;
+   }
+   bool operator != (const iterator & rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   // de-reference. Cannot change because it will invalidate the order
+   const T & operator * () const
+   {
+      return pNode->key(position);
+   }
+
+   // increment and decrement
+   iterator & operator ++ ();
+   iterator   operator ++ (int postfix)
+   {
+      iterator itReturn = *this;
+      ++(*this);
+      return itReturn;
+   }
+   iterator & operator -- ();
+   iterator   operator -- (int postfix)
+   {
+      iterator itReturn = *this;
+      --(*this);
+      return itReturn;
+   }
+
+private:
+   iterator(const Node * pNode, size_t position) : pNode(pNode), position(position)
+   {
+   }
+
+   // past the last element of pNode: climb to the next one, or end()
+   void climbUp()
+   {
+      while (pNode != nullptr && position == pNode->num)
+      {
+         position = pNode->position;
+         pNode = pNode->pParent;
+      }
+      if (pNode == nullptr)
+      {
+         position = 0;
+      }
+   }
+
+   const Node * pNode;
+   size_t position;
+};
+
+/**************************************************
+ * B-TREE SET ITERATOR :: INCREMENT PREFIX
+ * From an element of an internal node, down to the first element of
+ * the child after it. From a leaf, the next element or up
+ *************************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator & btree_set <T, C, N> :: iterator :: operator ++ ()
+{
+   if (pNode == nullptr)
+   {
+      return *this;
+   }
+
+   if (!pNode->isLeaf)
+   {
+      pNode = pNode->child(position + 1);
+      while (!pNode->isLeaf)
+      {
+         pNode = pNode->child(0);
+      }
+      position = 0;
+      return *this;
+   }
+
+   position++;
+   climbUp();
+   return *this;
+}
+
+/**************************************************
+ * B-TREE SET ITERATOR :: DECREMENT PREFIX
+ * The mirror image of increment. Before the first element is end()
+ *************************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator & btree_set <T, C, N> :: iterator :: operator -- ()
+{
+   if (pNode == nullptr)
+   {
+      return *this;
+   }
+
+   if (!pNode->isLeaf)
+   {
+      pNode = pNode->child(position);
+      while (!pNode->isLeaf)
+      {
+         pNode = pNode->child(pNode->num);
+      }
+      position = pNode->num - 1;
+      return *this;
+   }
+
+   if (position > 0)
+   {
+      position--;
+      return *this;
+   }
+
+   // climb until we come up from a child with an element before it
+   do
+   {
+      position = pNode->position;
+      pNode = pNode->pParent;
+   }
+   while (pNode != nullptr && position == 0);
+
+   if (pNode == nullptr)
+   {
+      position = 0;
+   }
+   else
+   {
+      position--;
+   }
+   return *this;
+}
+
+/*********************************************
+ * B-TREE SET :: BEGIN
+ * The first element of the left-most leaf
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator btree_set <T, C, N> :: begin() const noexcept
+{
+   if (root == nullptr)
+   {
+      return end();
+   }
+   const Node * p = root;
+   while (!p->isLeaf)
+   {
+      p = p->child(0);
+   }
+   return iterator(p, 0);
+}
+
+/*********************************************
+ * B-TREE SET :: RBEGIN
+ * The last element of the right-most leaf
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator btree_set <T, C, N> :: rbegin() const noexcept
+{
+   if (root == nullptr)
+   {
+      return rend();
+   }
+   const Node * p = root;
+   while (!p->isLeaf)
+   {
+      p = p->child(p->num);
+   }
+   return iterator(p, p->num - 1);
+}
+
+/*********************************************
+ * B-TREE SET :: LOWER BOUND IN
+ * The first element of a node not less than t, num if none
+ ********************************************/
+template <typename T, typename C, size_t N>
+size_t btree_set <T, C, N> :: lowerBoundIn(const Node * pNode, const T & t) const
+{
+   if constexpr (searchByCount)
+   {
+      size_t i = 0;
+      for (size_t j = 0; j < pNode->num; j++)
+      {
+         i += (pNode->key(j) < t);
+      }
+      return i;
+   }
+   else
+   {
+      size_t lo = 0;
+      size_t hi = pNode->num;
+      while (lo < hi)
+      {
+         size_t mid = (lo + hi) / 2;
+         if (compare(pNode->key(mid), t))
+         {
+            lo = mid + 1;
+         }
+         else
+         {
+            hi = mid;
+         }
+      }
+      return lo;
+   }
+}
+
+/*********************************************
+ * B-TREE SET :: UPPER BOUND IN
+ * The first element of a node greater than t, num if none
+ ********************************************/
+template <typename T, typename C, size_t N>
+size_t btree_set <T, C, N> :: upperBoundIn(const Node * pNode, const T & t) const
+{
+   if constexpr (searchByCount)
+   {
+      size_t i = 0;
+      for (size_t j = 0; j < pNode->num; j++)
+      {
+         i += !(t < pNode->key(j));
+      }
+      return i;
+   }
+   else
+   {
+      size_t lo = 0;
+      size_t hi = pNode->num;
+      while (lo < hi)
+      {
+         size_t mid = (lo + hi) / 2;
+         if (compare(t, pNode->key(mid)))
+         {
+            hi = mid;
+         }
+         else
+         {
+            lo = mid + 1;
+         }
+      }
+      return lo;
+   }
+}
+
+/*********************************************
+ * B-TREE SET :: FIND
+ * The element equivalent to t, end() if none
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator btree_set <T, C, N> :: find(const T & t) const
+{
+   for (const Node * p = root; p != nullptr; )
+   {
+      size_t i = lowerBoundIn(p, t);
+      if (i < p->num && !compare(t, p->key(i)))
+      {
+         return iterator(p, i);
+      }
+      if (p->isLeaf)
+      {
+         break;
+      }
+      p = p->child(i);
+   }
+   return end();
+}
+
+/*********************************************
+ * B-TREE SET :: LOWER BOUND
+ * The first element not less than t, end() if none. Each level down
+ * can only find a smaller candidate than the one above it
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator btree_set <T, C, N> :: lower_bound(const T & t) const
+{
+   iterator itBound;
+   for (const Node * p = root; p != nullptr; )
+   {
+      size_t i = lowerBoundIn(p, t);
+      if (i < p->num)
+      {
+         itBound = iterator(p, i);
+         if (!compare(t, p->key(i)))
+         {
+            break;
+         }
+      }
+      if (p->isLeaf)
+      {
+         break;
+      }
+      p = p->child(i);
+   }
+   return itBound;
+}
+
+/*********************************************
+ * B-TREE SET :: UPPER BOUND
+ * The first element greater than t, end() if none
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator btree_set <T, C, N> :: upper_bound(const T & t) const
+{
+   iterator itBound;
+   for (const Node * p = root; p != nullptr; )
+   {
+      size_t i = upperBoundIn(p, t);
+      if (i < p->num)
+      {
+         itBound = iterator(p, i);
+      }
+      if (p->isLeaf)
+      {
+         break;
+      }
+      p = p->child(i);
+   }
+   return itBound;
+}
+
+/*********************************************
+ * B-TREE SET :: INSERT UNIQUE
+ * Add t to its leaf unless it is already there. A full leaf is split
+ * first, which may split its ancestors, and then t's place is found
+ * again. Splits are rare: one per numSlots / 2 inserts at most
+ ********************************************/
+template <typename T, typename C, size_t N>
+template <class U>
+std::pair<typename btree_set <T, C, N> :: iterator, bool> btree_set <T, C, N> :: insertUnique(U && t)
+{
+   if (root == nullptr)
+   {
+      root = newNode(true /*isLeaf*/);
+   }
+
+   Node * p = root;
+   size_t i = 0;
+   while (true)
+   {
+      i = lowerBoundIn(p, t);
+      if (i < p->num && !compare(t, p->key(i)))
+      {
+         return std::pair<iterator, bool>(iterator(p, i), false);
+      }
+      if (p->isLeaf)
+      {
+         break;
+      }
+      p = p->child(i);
+   }
+
+   if (p->num == numSlots)
+   {
+      split(p, i == p->num && onRightEdge(p));
+      for (p = root; ; p = p->child(i))
+      {
+         i = lowerBoundIn(p, t);
+         if (p->isLeaf)
+         {
+            break;
+         }
+      }
+   }
+
+   p->insertKey(i, std::forward<U>(t));
+   numElements++;
+   return std::pair<iterator, bool>(iterator(p, i), true);
+}
+
+/*********************************************
+ * B-TREE SET :: SPLIT
+ * Split a full node in two, moving the element between the halves up
+ * into the parent, which is split first if it is full too. A node on
+ * the right edge split because something goes past the end of the
+ * tree keeps all but one element and the new node starts out empty, so
+ * ascending inserts fill nodes. The new node is the only one left short
+ ********************************************/
+template <typename T, typename C, size_t N>
+void btree_set <T, C, N> :: split(Node * pNode, bool atEnd)
+{
+   assert(pNode->num == numSlots);
+   assert(!atEnd || onRightEdge(pNode));
+
+   Internal * pParent = pNode->pParent;
+   if (pParent != nullptr && pParent->num == numSlots)
+   {
+      split(pParent, atEnd && pNode->position == pParent->num);
+      pParent = pNode->pParent;
+   }
+
+   // allocate before changing anything
+   Node * pSibling = newNode(pNode->isLeaf);
+   if (pParent == nullptr)
+   {
+      try
+      {
+         pParent = static_cast<Internal *>(newNode(false /*isLeaf*/));
+      }
+      catch (...)
+      {
+         destroyNode(pSibling);
+         throw;
+      }
+      pParent->setChild(0, pNode);
+      root = pParent;
+   }
+
+   size_t mid = atEnd ? numSlots - 1 : numSlots / 2;
+   for (size_t j = mid + 1; j < pNode->num; j++)
+   {
+      pSibling->insertKey(pSibling->num, std::move(pNode->key(j)));
+   }
+   if (!pNode->isLeaf)
+   {
+      for (size_t j = mid + 1; j <= pNode->num; j++)
+      {
+         static_cast<Internal *>(pSibling)->setChild(j - mid - 1, pNode->child(j));
+      }
+   }
+
+   // the middle element goes up between us and our new sibling
+   size_t position = pNode->position;
+   pParent->insertKey(position, std::move(pNode->key(mid)));
+   for (size_t j = pParent->num; j > position + 1; j--)
+   {
+      pParent->setChild(j, pParent->child(j - 1));
+   }
+   pParent->setChild(position + 1, pSibling);
+
+   while (pNode->num > mid)
+   {
+      pNode->eraseKey(pNode->num - 1);
+   }
+}
+
+/*********************************************
+ * B-TREE SET :: ON RIGHT EDGE
+ * Is pNode the last child of the last child ... of the root? Only
+ * these nodes may hold fewer than minKeys
+ ********************************************/
+template <typename T, typename C, size_t N>
+bool btree_set <T, C, N> :: onRightEdge(const Node * pNode) noexcept
+{
+   for (; pNode->pParent != nullptr; pNode = pNode->pParent)
+   {
+      if (pNode->position != pNode->pParent->num)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+/*********************************************
+ * B-TREE SET :: ERASE
+ * Remove the element at it and return the one after it. An element
+ * of an internal node trades places with the first element of the
+ * subtree after it, so the element that leaves is always in a leaf.
+ * When the leaf is left with too few, it takes one from a sibling or
+ * merges with it, which may leave its parent short in turn
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator btree_set <T, C, N> :: erase(iterator it)
+{
+   if (it == end())
+   {
+      return end();
+   }
+
+   Node * p = const_cast<Node *>(it.pNode);
+   size_t i = it.position;
+
+   // the common case: a leaf with elements to spare
+   if (p->isLeaf && (p == root || p->num > minKeys))
+   {
+      p->eraseKey(i);
+      numElements--;
+      if (p->num == 0)
+      {
+         assert(p == root);
+         destroyNode(root);
+         root = nullptr;
+         return end();
+      }
+      iterator itNext(p, i);
+      itNext.climbUp();
+      return itNext;
+   }
+
+   // otherwise the tree changes shape, so remember where we were
+   T erased(std::move(p->key(i)));
+   if (!p->isLeaf)
+   {
+      Node * pLeaf = p->child(i + 1);
+      while (!pLeaf->isLeaf)
+      {
+         pLeaf = pLeaf->child(0);
+      }
+      p->key(i) = std::move(pLeaf->key(0));
+      p = pLeaf;
+      i = 0;
+   }
+   p->eraseKey(i);
+   numElements--;
+   rebalance(p);
+   return lower_bound(erased);
+}
+
+/*********************************************
+ * B-TREE SET :: ERASE RANGE
+ * Remove [first, last). Erasing reshapes the tree and invalidates
+ * last, so count the elements first
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: iterator btree_set <T, C, N> :: erase(iterator first, iterator last)
+{
+   size_t num = 0;
+   for (iterator it = first; it != last; ++it)
+   {
+      num++;
+   }
+   for (; num > 0; num--)
+   {
+      first = erase(first);
+   }
+   return first;
+}
+
+/*********************************************
+ * B-TREE SET :: REBALANCE
+ * pNode may have too few elements. Borrow one through the parent from
+ * a sibling that can spare it, or else merge with a sibling, and go
+ * on up. A root left with no elements gives way to its only child
+ ********************************************/
+template <typename T, typename C, size_t N>
+void btree_set <T, C, N> :: rebalance(Node * pNode)
+{
+   while (pNode != root && pNode->num < minKeys)
+   {
+      // off the right edge, a node is short by the one element just gone
+      assert((size_t)pNode->num + 1 >= minKeys || onRightEdge(pNode));
+      Internal * pParent = pNode->pParent;
+      size_t position = pNode->position;
+      Node * pLeft  = position > 0             ? pParent->child(position - 1) : nullptr;
+      Node * pRight = position < pParent->num ? pParent->child(position + 1) : nullptr;
+
+      if (pLeft && pLeft->num > minKeys)
+      {
+         rotateRight(pParent, position - 1);
+         return;
+      }
+      if (pRight && pRight->num > minKeys)
+      {
+         rotateLeft(pParent, position);
+         return;
+      }
+      merge(pParent, pLeft ? position - 1 : position);
+      pNode = pParent;
+   }
+
+   if (root->num == 0)
+   {
+      Node * pOld = root;
+      if (root->isLeaf)
+      {
+         root = nullptr;
+      }
+      else
+      {
+         root = root->child(0);
+         root->pParent = nullptr;
+         root->position = 0;
+      }
+      destroyNode(pOld);
+   }
+}
+
+/*********************************************
+ * B-TREE SET :: ROTATE LEFT
+ * Move the first element of child i+1 up into the parent, and the
+ * parent's element i down onto the end of child i
+ ********************************************/
+template <typename T, typename C, size_t N>
+void btree_set <T, C, N> :: rotateLeft(Internal * pParent, size_t i)
+{
+   Node * pLeft  = pParent->child(i);
+   Node * pRight = pParent->child(i + 1);
+
+   pLeft->insertKey(pLeft->num, std::move(pParent->key(i)));
+   pParent->key(i) = std::move(pRight->key(0));
+   if (!pRight->isLeaf)
+   {
+      Internal * pLeftInternal  = static_cast<Internal *>(pLeft);
+      Internal * pRightInternal = static_cast<Internal *>(pRight);
+      pLeftInternal->setChild(pLeft->num, pRight->child(0));
+      for (size_t j = 0; j < pRight->num; j++)
+      {
+         pRightInternal->setChild(j, pRight->child(j + 1));
+      }
+   }
+   pRight->eraseKey(0);
+}
+
+/*********************************************
+ * B-TREE SET :: ROTATE RIGHT
+ * Move the last element of child i up into the parent, and the
+ * parent's element i down onto the front of child i+1
+ ********************************************/
+template <typename T, typename C, size_t N>
+void btree_set <T, C, N> :: rotateRight(Internal * pParent, size_t i)
+{
+   Node * pLeft  = pParent->child(i);
+   Node * pRight = pParent->child(i + 1);
+
+   pRight->insertKey(0, std::move(pParent->key(i)));
+   pParent->key(i) = std::move(pLeft->key(pLeft->num - 1));
+   if (!pLeft->isLeaf)
+   {
+      Internal * pRightInternal = static_cast<Internal *>(pRight);
+      for (size_t j = pRight->num; j > 0; j--)
+      {
+         pRightInternal->setChild(j, pRight->child(j - 1));
+      }
+      pRightInternal->setChild(0, pLeft->child(pLeft->num));
+   }
+   pLeft->eraseKey(pLeft->num - 1);
+}
+
+/*********************************************
+ * B-TREE SET :: MERGE
+ * Fold child i+1 and the parent's element i between them into child
+ * i. One child is short and the other has none to spare, so neither
+ * has more than minKeys and everything fits, on the right edge too
+ ********************************************/
+template <typename T, typename C, size_t N>
+void btree_set <T, C, N> :: merge(Internal * pParent, size_t i)
+{
+   Node * pLeft  = pParent->child(i);
+   Node * pRight = pParent->child(i + 1);
+   assert(pLeft->num <= minKeys && pRight->num <= minKeys);
+   assert((size_t)pLeft->num + 1 + pRight->num <= numSlots);
+
+   size_t numLeft = pLeft->num;
+   pLeft->insertKey(pLeft->num, std::move(pParent->key(i)));
+   for (size_t j = 0; j < pRight->num; j++)
+   {
+      pLeft->insertKey(pLeft->num, std::move(pRight->key(j)));
+   }
+   if (!pLeft->isLeaf)
+   {
+      for (size_t j = 0; j <= pRight->num; j++)
+      {
+         static_cast<Internal *>(pLeft)->setChild(numLeft + 1 + j, pRight->child(j));
+      }
+   }
+
+   pParent->eraseKey(i);
+   for (size_t j = i + 1; j <= pParent->num; j++)
+   {
+      pParent->setChild(j, pParent->children[j + 1]);
+   }
+   destroyNode(pRight);
+}
+
+/*********************************************
+ * B-TREE SET :: NEW NODE
+ * A leaf or an internal node, with no elements yet
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: Node * btree_set <T, C, N> :: newNode(bool isLeaf)
+{
+   try
+   {
+      if (isLeaf)
+      {
+         return new Node(true);
+      }
+      return new Internal;
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+}
+
+/*********************************************
+ * B-TREE SET :: DESTROY NODE
+ * Free one node and its elements, but not its children
+ ********************************************/
+template <typename T, typename C, size_t N>
+void btree_set <T, C, N> :: destroyNode(Node * pNode) noexcept
+{
+   if (pNode->isLeaf)
+   {
+      delete pNode;
+   }
+   else
+   {
+      delete static_cast<Internal *>(pNode);
+   }
+}
+
+/*********************************************
+ * B-TREE SET :: DELETE NODE
+ * Free a whole subtree. A copy that failed part way through may have
+ * children missing
+ ********************************************/
+template <typename T, typename C, size_t N>
+void btree_set <T, C, N> :: deleteNode(Node * pNode) noexcept
+{
+   if (pNode == nullptr)
+   {
+      return;
+   }
+   if (!pNode->isLeaf)
+   {
+      for (size_t i = 0; i <= pNode->num; i++)
+      {
+         deleteNode(pNode->child(i));
+      }
+   }
+   destroyNode(pNode);
+}
+
+/*********************************************
+ * B-TREE SET :: COPY NODE
+ * A copy of a whole subtree, hung from pParent. Nothing is left
+ * behind if an element cannot be copied
+ ********************************************/
+template <typename T, typename C, size_t N>
+typename btree_set <T, C, N> :: Node * btree_set <T, C, N> :: copyNode(const Node * pSrc, Internal * pParent)
+{
+   if (pSrc == nullptr)
+   {
+      return nullptr;
+   }
+
+   Node * pDest = newNode(pSrc->isLeaf);
+   pDest->pParent = pParent;
+   pDest->position = pSrc->position;
+   try
+   {
+      for (size_t i = 0; i < pSrc->num; i++)
+      {
+         pDest->insertKey(i, pSrc->key(i));
+      }
+      if (!pSrc->isLeaf)
+      {
+         Internal * pInternal = static_cast<Internal *>(pDest);
+         for (size_t i = 0; i <= pSrc->num; i++)
+         {
+            pInternal->children[i] = copyNode(pSrc->child(i), pInternal);
+         }
+      }
+   }
+   catch (...)
+   {
+      deleteNode(pDest);
+      throw "ERROR: Unable to allocate a node";
+   }
+   return pDest;
+}
+
+/***********************************************
+ * B-TREE SET : EQUIVALENCE
+ * Same size and the same elements in the same order
+ ***********************************************/
+template <typename T, typename C, size_t N>
+bool operator == (const btree_set <T, C, N> & lhs, const btree_set <T, C, N> & rhs)
+{
+   return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, typename C, size_t N>
+inline bool operator != (const btree_set <T, C, N> & lhs, const btree_set <T, C, N> & rhs)
+{
+   return !(lhs == rhs);
+}
+
+} // namespace custom
@@ -0,0 +1,449 @@
+/***********************************************************************
+ * Header:
+ *    COPY-ON-WRITE SET
+ * Summary:
+ *    A set whose copies share one tree until one of them changes
+ *
+ *    This will contain the class definition of:
+ *        cow_set             : A set copied in O(1), detached on a write
+ *        cow_set::iterator   : An iterator that knows which tree it is in
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <atomic>     // for std::atomic
+#include <functional> // for std::less
+#include <memory>     // for std::allocator
+#include "set.h"      // for custom::set
+
+class TestCowSet; // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * COPY-ON-WRITE SET
+ * A set that is cheap to pass by value. Copies share one tree and a
+ * count of how many copies there are. Reading never copies anything;
+ * the first change made through a copy that is not the only one
+ * detaches it with a deep copy of the tree, so a copy that is only
+ * ever read never costs an allocation.
+ *
+ * The tree is detached whole: its nodes point at their parents and
+ * are rebalanced in place, so no part of it can be shared between two
+ * trees. persistent_set shares everything off the changed path instead.
+ *
+ * Iterators come from whichever tree the copy is using when they are
+ * made, and remember which tree that was. erase() takes an iterator
+ * from before a detach and finds its element again in the tree the
+ * copy uses now, so nothing the caller holds goes stale because of a
+ * detach it did not ask for. Such an iterator is good for as long as
+ * some copy still uses the tree it came from
+ ***********************************************/
+template <typename T,
+          typename Compare = std::less<T>,
+          typename Allocator = std::allocator<T>>
+class cow_set
+{
+   friend class ::TestCowSet; // give unit tests access to the privates
+
+public:
+   using set_type       = custom::set <T, Compare, Allocator>;
+   class iterator;
+   using const_iterator = iterator;   // elements are never changed in place
+   using key_compare    = Compare;
+   using allocator_type = Allocator;
+
+   //
+   // Construct
+   //
+
+   cow_set() : pShared(nullptr)
+   {
+   }
+   explicit cow_set(const Compare & compare, const Allocator & alloc = Allocator()) :
+      pShared(new Shared(compare, alloc))
+   {
+   }
+   cow_set(const std::initializer_list <T> & il) : pShared(nullptr)
+   {
+      insert(il.begin(), il.end());
+   }
+   template <class Iterator>
+   cow_set(Iterator first, Iterator last) : pShared(nullptr)
+   {
+      insert(first, last);
+   }
+
+   // copies share the tree: O(1) until one of them is changed
+   cow_set(const cow_set & rhs) noexcept : pShared(rhs.pShared)
+   {
+      if (pShared)
+      {
+         pShared->numCopies.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+   cow_set(cow_set && rhs) noexcept : pShared(rhs.pShared)
+   {
+      rhs.pShared = nullptr;
+   }
+   ~cow_set()
+   {
+      release();
+   }
+
+   //
+   // Assign
+   //
+
+   cow_set & operator = (const cow_set & rhs) noexcept
+   {
+      cow_set copy(rhs);
+      swap(copy);
+      return *this;
+   }
+   cow_set & operator = (cow_set && rhs) noexcept
+   {
+      cow_set moved(std::move(rhs));
+      swap(moved);
+      return *this;
+   }
+   void swap(cow_set & rhs) noexcept
+   {
+      std::swap(pShared, rhs.pShared);
+   }
+
+   //
+   // Iterator
+   //
+
+   iterator begin()  const noexcept { return wrap(get().begin());  }
+   iterator end()    const noexcept { return wrap(get().end());    }
+   iterator rbegin() const noexcept { return wrap(get().rbegin()); }
+   iterator rend()   const noexcept { return wrap(get().rend());   }
+
+   //
+   // Access
+   //
+
+   iterator find(const T & t)        const { return wrap(get().find(t));        }
+   iterator lower_bound(const T & t) const { return wrap(get().lower_bound(t)); }
+   iterator upper_bound(const T & t) const { return wrap(get().upper_bound(t)); }
+   std::pair<iterator, iterator> equal_range(const T & t) const
+   {
+      return std::pair<iterator, iterator>(lower_bound(t), upper_bound(t));
+   }
+   size_t   count(const T & t)       const { return get().count(t);       }
+   bool     contains(const T & t)    const { return get().contains(t);    }
+   const T & front()                 const { return get().front();        }
+   const T & back()                  const { return get().back();         }
+
+   // the set this copy reads from, shared or not
+   const set_type & get() const noexcept
+   {
+      return pShared ? pShared->s : emptySet();
+   }
+
+   //
+   // Insert
+   //
+
+   // a shared tree is not copied just to find t is already there
+   std::pair<iterator, bool> insert(const T & t)
+   {
+      if (shared())
+      {
+         iterator it = find(t);
+         if (it != end())
+         {
+            return std::pair<iterator, bool>(it, false);
+         }
+      }
+      return wrap(mutate().insert(t));
+   }
+   std::pair<iterator, bool> insert(T && t)
+   {
+      if (shared())
+      {
+         iterator it = find(t);
+         if (it != end())
+         {
+            return std::pair<iterator, bool>(it, false);
+         }
+      }
+      return wrap(mutate().insert(std::move(t)));
+   }
+   template <class ... Args>
+   std::pair<iterator, bool> emplace(Args && ... args)
+   {
+      return wrap(mutate().emplace(std::forward<Args>(args)...));
+   }
+   void insert(const std::initializer_list <T> & il)
+   {
+      mutate().insert(il);
+   }
+   template <class Iterator>
+   void insert(Iterator first, Iterator last)
+   {
+      mutate().insert(first, last);
+   }
+
+   //
+   // Remove
+   //
+
+   void clear();
+   void pop_front() { mutate().pop_front(); }
+   void pop_back()  { mutate().pop_back();  }
+   iterator erase(iterator it);
+   iterator erase(iterator itBegin, iterator itEnd);
+   size_t erase(const T & t)
+   {
+      return contains(t) ? mutate().erase(t) : 0;
+   }
+   size_t erase_range(const T & lo, const T & hi)
+   {
+      if (!key_comp()(lo, hi) || lower_bound(lo) == lower_bound(hi))
+      {
+         return 0;
+      }
+      return mutate().erase_range(lo, hi);
+   }
+
+   //
+   // Status
+   //
+
+   bool   empty() const noexcept { return get().empty(); }
+   size_t size()  const noexcept { return get().size();  }
+   key_compare    key_comp()      const { return get().key_comp();      }
+   allocator_type get_allocator() const { return get().get_allocator(); }
+
+   // does any other copy share this one's tree?
+   bool shared() const noexcept
+   {
+      return pShared && pShared->numCopies.load(std::memory_order_acquire) > 1;
+   }
+
+private:
+
+   // the tree and how many copies are using it
+   struct Shared
+   {
+      Shared() : numCopies(1)
+      {
+      }
+      Shared(const Compare & compare, const Allocator & alloc) : s(compare, alloc), numCopies(1)
+      {
+      }
+      Shared(const set_type & rhs) : s(rhs), numCopies(1)
+      {
+      }
+
+      set_type s;
+      std::atomic <size_t> numCopies;
+   };
+
+   set_type & mutate();
+   typename set_type::iterator reattach(const iterator & it) const;
+
+   // an iterator into the tree this copy reads from now
+   iterator wrap(const typename set_type::iterator & it) const
+   {
+      return iterator(it, &get());
+   }
+   std::pair<iterator, bool> wrap(const std::pair<typename set_type::iterator, bool> & p) const
+   {
+      return std::pair<iterator, bool>(wrap(p.first), p.second);
+   }
+   void release() noexcept
+   {
+      // the last one out sees every change made before the others left
+      if (pShared && pShared->numCopies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+         delete pShared;
+      }
+      pShared = nullptr;
+   }
+   static const set_type & emptySet()
+   {
+      static const set_type s;
+      return s;
+   }
+
+   Shared * pShared;     // the tree, or nullptr while there is none
+};
+
+/**************************************************
+ * COW SET ITERATOR
+ * An iterator through the set, along with the tree it walks so that
+ * erase() can tell one from before a detach
+ *************************************************/
+template <typename T, typename C, typename A>
+class cow_set <T, C, A> :: iterator
+{
+   friend class ::TestCowSet; // give unit tests access to the privates
+   friend class custom::cow_set <T, C, A>;
+
+public:
+   iterator() : it(), pSet(nullptr)
+   {
+   }
+
+   bool operator == (const iterator & rhs) const { return it == rhs.it; }
+   bool operator != (const iterator & rhs) const { return it != rhs.it; }
+
+   const T & operator * () const
+   {
+      return *it;
+   }
+
+   iterator & operator ++ ()
+   {
+      ++it;
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator itReturn(*this);
+      ++it;
+      return itReturn;
+   }
+   iterator & operator -- ()
+   {
+      --it;
+      return *this;
+   }
+   iterator operator -- (int)
+   {
+      iterator itReturn(*this);
+      --it;
+      return itReturn;
+   }
+
+private:
+   iterator(const typename set_type::iterator & it, const set_type * pSet) : it(it), pSet(pSet)
+   {
+   }
+
+   typename set_type::iterator it;
+   const set_type * pSet;        // the tree it came from
+};
+
+/*********************************************
+ * COW SET :: MUTATE
+ * The set to change, which no other copy may see. A tree that is
+ * shared is copied first. If the copy fails, nothing has changed
+ ********************************************/
+template <typename T, typename C, typename A>
+typename cow_set <T, C, A> :: set_type & cow_set <T, C, A> :: mutate()
+{
+   if (pShared == nullptr)
+   {
+      pShared = new Shared();
+   }
+   else if (pShared->numCopies.load(std::memory_order_acquire) != 1)
+   {
+      Shared * pCopy = new Shared(pShared->s);
+      release();
+      pShared = pCopy;
+   }
+   return pShared->s;
+}
+
+/*********************************************
+ * COW SET :: CLEAR
+ * Empty this copy. A shared tree is left to the other copies, and
+ * this one starts a new tree ordered the same way
+ ********************************************/
+template <typename T, typename C, typename A>
+void cow_set <T, C, A> :: clear()
+{
+   if (shared())
+   {
+      Shared * pEmpty = new Shared(key_comp(), get_allocator());
+      release();
+      pShared = pEmpty;
+   }
+   else if (pShared)
+   {
+      pShared->s.clear();
+   }
+}
+
+/*********************************************
+ * COW SET :: REATTACH
+ * An iterator from any tree this copy has used, turned into one into
+ * the tree it uses now. One from another tree is found again by value
+ ********************************************/
+template <typename T, typename C, typename A>
+typename cow_set <T, C, A> :: set_type::iterator cow_set <T, C, A> :: reattach(const iterator & it) const
+{
+   if (it.pSet == &get() || it == end())
+   {
+      return it.it;
+   }
+   return get().find(*it);
+}
+
+/*********************************************
+ * COW SET :: ERASE
+ * Remove one element by iterator, detaching first if need be. The
+ * iterator may be from a tree we used before an earlier detach, so it
+ * is looked up in ours rather than trusted. When this erase is what
+ * detaches us, we hold on to the old tree until it has been looked up
+ * in the new one, in case the other copies let go of it meanwhile
+ ********************************************/
+template <typename T, typename C, typename A>
+typename cow_set <T, C, A> :: iterator cow_set <T, C, A> :: erase(iterator it)
+{
+   if (it == end())
+   {
+      return end();
+   }
+
+   cow_set old(shared() ? *this : cow_set());
+   set_type & s = mutate();
+   typename set_type::iterator itHere = reattach(it);
+   return wrap(s.erase(itHere));
+}
+
+/*********************************************
+ * COW SET :: ERASE RANGE
+ * Remove [itBegin, itEnd), detaching first if need be
+ ********************************************/
+template <typename T, typename C, typename A>
+typename cow_set <T, C, A> :: iterator cow_set <T, C, A> :: erase(iterator itBegin, iterator itEnd)
+{
+   if (itBegin == itEnd)
+   {
+      return itEnd;
+   }
+
+   cow_set old(shared() ? *this : cow_set());
+   set_type & s = mutate();
+   typename set_type::iterator itBeginHere = reattach(itBegin);
+   typename set_type::iterator itEndHere   = reattach(itEnd);
+   return wrap(s.erase(itBeginHere, itEndHere));
+}
+
+/***********************************************
+ * COW SET : EQUIVALENCE
+ * Copies sharing a tree are equal without looking at it
+ ***********************************************/
+template <typename T, typename C, typename A>
+bool operator == (const cow_set <T, C, A> & lhs, const cow_set <T, C, A> & rhs)
+{
+   return &lhs.get() == &rhs.get() || lhs.get() == rhs.get();
+}
+
+template <typename T, typename C, typename A>
+inline bool operator != (const cow_set <T, C, A> & lhs, const cow_set <T, C, A> & rhs)
+{
+   return !(lhs == rhs);
+}
+
+} // namespace custom
@@ -0,0 +1,325 @@
+/***********************************************************************
+ * Header:
+ *    FLAT SET
+ * Summary:
+ *    A set kept in one sorted array
+ *
+ *    This will contain the class definition of:
+ *        flat_set            : A set stored in a sorted vector
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>     // for size_t
+#include <algorithm>   // for std::sort, std::inplace_merge and std::unique
+#include <functional>  // for std::less
+#include <iterator>    // for std::reverse_iterator and std::distance
+#include <memory>      // for std::allocator
+#include <utility>     // for std::pair, std::move and std::swap
+#include <vector>      // for std::vector
+
+class TestFlatSet; // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * FLAT SET
+ * A set with the interface of custom::set whose elements sit in one
+ * sorted, contiguous array. Nothing points at anything: a lookup is a
+ * binary search over neighbouring memory and a scan is a walk down an
+ * array, so a set built once and probed many times misses the cache
+ * far less than a tree does.
+ *
+ * The price is paid on change. A single insert or erase shifts every
+ * element after it, so build with the range insert, which sorts the
+ * new elements on their own and merges them in with one pass.
+ *
+ * Inserting or erasing invalidates every iterator
+ ***********************************************/
+template <typename T,
+          typename Compare = std::less<T>,
+          typename Allocator = std::allocator<T>>
+class flat_set
+{
+   friend class ::TestFlatSet; // give unit tests access to the privates
+
+   using container_type = std::vector <T, Allocator>;
+
+public:
+   using key_compare    = Compare;
+   using allocator_type = Allocator;
+
+   //
+   // Construct
+   //
+
+   flat_set() : data(), compare()
+   {
+   }
+   explicit flat_set(const Compare & compare, const Allocator & alloc = Allocator()) :
+      data(alloc), compare(compare)
+   {
+   }
+   flat_set(const std::initializer_list <T> & il) : data(), compare()
+   {
+      insert(il.begin(), il.end());
+   }
+   template <class Iterator>
+   flat_set(Iterator first, Iterator last) : data(), compare()
+   {
+      insert(first, last);
+   }
+   flat_set(const flat_set & rhs)     = default;
+   flat_set(flat_set && rhs) noexcept = default;
+
+   //
+   // Assign
+   //
+
+   flat_set & operator = (const flat_set & rhs)     = default;
+   flat_set & operator = (flat_set && rhs) noexcept = default;
+   flat_set & operator = (const std::initializer_list <T> & il)
+   {
+      clear();
+      insert(il.begin(), il.end());
+      return *this;
+   }
+   void swap(flat_set & rhs) noexcept
+   {
+      data.swap(rhs.data);
+      std::swap(compare, rhs.compare);
+   }
+
+   //
+   // Iterator
+   //
+
+   using iterator       = typename container_type::const_iterator;
+   using const_iterator = iterator;   // elements are never changed in place
+   iterator begin() const noexcept { return data.cbegin(); }
+   iterator end()   const noexcept { return data.cend();   }
+
+   // an array iterator cannot step off the front, so walking backwards
+   // takes a std::reverse_iterator and ++ rather than -- down to rend()
+   using reverse_iterator = std::reverse_iterator <iterator>;
+   reverse_iterator rbegin() const noexcept { return data.crbegin(); }
+   reverse_iterator rend()   const noexcept { return data.crend();   }
+
+   //
+   // Access
+   //
+
+   iterator find(const T & t) const
+   {
+      iterator it = lower_bound(t);
+      return (it != end() && !compare(t, *it)) ? it : end();
+   }
+   iterator lower_bound(const T & t) const
+   {
+      return begin() + lowerBound(t);
+   }
+   iterator upper_bound(const T & t) const
+   {
+      return begin() + upperBound(t);
+   }
+   std::pair<iterator, iterator> equal_range(const T & t) const
+   {
+      iterator it = lower_bound(t);
+      iterator itEnd = (it != end() && !compare(t, *it)) ? it + 1 : it;
+      return std::pair<iterator, iterator>(it, itEnd);
+   }
+   size_t count(const T & t)    const { return contains(t) ? 1 : 0; }
+   bool   contains(const T & t) const { return find(t) != end();    }
+
+   // the smallest and largest elements: not for an empty set
+   const T & front() const { assert(!data.empty()); return data.front(); }
+   const T & back()  const { assert(!data.empty()); return data.back();  }
+
+   //
+   // Insert
+   //
+
+   std::pair<iterator, bool> insert(const T & t) { return insertUnique(t);            }
+   std::pair<iterator, bool> insert(T && t)      { return insertUnique(std::move(t)); }
+   template <class ... Args>
+   std::pair<iterator, bool> emplace(Args && ... args)
+   {
+      T t(std::forward<Args>(args)...);
+      return insertUnique(std::move(t));
+   }
+   void insert(const std::initializer_list <T> & il)
+   {
+      insert(il.begin(), il.end());
+   }
+   template <class Iterator>
+   void insert(Iterator first, Iterator last);
+
+   //
+   // Remove
+   //
+
+   iterator erase(iterator it)
+   {
+      return data.erase(it);
+   }
+   iterator erase(iterator first, iterator last)
+   {
+      return data.erase(first, last);
+   }
+   size_t erase(const T & t)
+   {
+      iterator it = find(t);
+      if (it == end())
+      {
+         return 0;
+      }
+      data.erase(it);
+      return 1;
+   }
+   void clear() noexcept
+   {
+      data.clear();
+   }
+
+   //
+   // Status
+   //
+
+   bool   empty()    const noexcept { return data.empty();    }
+   size_t size()     const noexcept { return data.size();     }
+   size_t capacity() const noexcept { return data.capacity(); }
+   void   reserve(size_t num)       { data.reserve(num);      }
+   void   shrink_to_fit()           { data.shrink_to_fit();   }
+   key_compare    key_comp()      const { return compare;              }
+   allocator_type get_allocator() const { return data.get_allocator(); }
+
+private:
+
+   size_t lowerBound(const T & t) const;
+   size_t upperBound(const T & t) const;
+   template <class U>
+   std::pair<iterator, bool> insertUnique(U && t);
+
+   container_type data;   // the elements, sorted and without duplicates
+   Compare compare;       // strict weak ordering of the elements
+};
+
+/*********************************************
+ * FLAT SET :: LOWER BOUND
+ * The index of the first element not less than t. Each step halves
+ * the range and moves its start with a conditional add rather than a
+ * branch, so the compiler emits a cmov: the loop runs the same number
+ * of times whatever the data and never mispredicts
+ ********************************************/
+template <typename T, typename C, typename A>
+size_t flat_set <T, C, A> :: lowerBound(const T & t) const
+{
+   const T * pBase = data.data();
+   size_t num = data.size();
+   while (num > 0)
+   {
+      size_t half = num / 2;
+      pBase += compare(pBase[half], t) ? num - half : 0;
+      num = half;
+   }
+   return pBase - data.data();
+}
+
+/*********************************************
+ * FLAT SET :: UPPER BOUND
+ * The index of the first element greater than t, found the same way
+ ********************************************/
+template <typename T, typename C, typename A>
+size_t flat_set <T, C, A> :: upperBound(const T & t) const
+{
+   const T * pBase = data.data();
+   size_t num = data.size();
+   while (num > 0)
+   {
+      size_t half = num / 2;
+      pBase += compare(t, pBase[half]) ? 0 : num - half;
+      num = half;
+   }
+   return pBase - data.data();
+}
+
+/*********************************************
+ * FLAT SET :: INSERT UNIQUE
+ * Put one element in its place unless it is already there. An element
+ * larger than all the others just goes on the end, so a sorted load
+ * never shifts anything
+ ********************************************/
+template <typename T, typename C, typename A>
+template <class U>
+std::pair<typename flat_set <T, C, A> :: iterator, bool> flat_set <T, C, A> :: insertUnique(U && t)
+{
+   if (data.empty() || compare(data.back(), t))
+   {
+      data.push_back(std::forward<U>(t));
+      return std::pair<iterator, bool>(end() - 1, true);
+   }
+
+   iterator it = lower_bound(t);
+   if (!compare(t, *it))
+   {
+      return std::pair<iterator, bool>(it, false);
+   }
+   return std::pair<iterator, bool>(data.insert(it, std::forward<U>(t)), true);
+}
+
+/*********************************************
+ * FLAT SET :: INSERT RANGE
+ * Add many elements at once: append them, sort just the new ones,
+ * merge the two sorted runs, and squeeze out the duplicates. That is
+ * O(n + m log m) for m new elements instead of O(n m) one at a time.
+ * The merge is stable, so an element already in the set is the one
+ * kept over a new equivalent one
+ ********************************************/
+template <typename T, typename C, typename A>
+template <class Iterator>
+void flat_set <T, C, A> :: insert(Iterator first, Iterator last)
+{
+   size_t numOld = data.size();
+   data.insert(data.end(), first, last);
+   if (data.size() == numOld)
+   {
+      return;
+   }
+
+   auto itMiddle = data.begin() + numOld;
+   std::stable_sort(itMiddle, data.end(), compare);
+   if (numOld != 0 && compare(*itMiddle, data[numOld - 1]))
+   {
+      std::inplace_merge(data.begin(), itMiddle, data.end(), compare);
+   }
+
+   const C & comp = compare;
+   auto itUnique = std::unique(data.begin(), data.end(),
+                               [&comp](const T & lhs, const T & rhs)
+                               {
+                                  return !comp(lhs, rhs);
+                               });
+   data.erase(itUnique, data.end());
+}
+
+/***********************************************
+ * FLAT SET : EQUIVALENCE
+ * Same elements in the same order
+ ***********************************************/
+template <typename T, typename C, typename A>
+bool operator == (const flat_set <T, C, A> & lhs, const flat_set <T, C, A> & rhs)
+{
+   return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, typename C, typename A>
+inline bool operator != (const flat_set <T, C, A> & lhs, const flat_set <T, C, A> & rhs)
+{
+   return !(lhs == rhs);
+}
+
+} // namespace custom
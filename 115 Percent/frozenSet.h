@@ -0,0 +1,353 @@
+/***********************************************************************
+ * Header:
+ *    FROZEN SET
+ * Summary:
+ *    A read-only set laid out for fast lookups
+ *
+ *    This will contain the class definition of:
+ *        frozen_set           : An immutable set in Eytzinger order
+ *        frozen_set::iterator : An iterator through frozen_set in order
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>     // for size_t and std::ptrdiff_t
+#include <cstdint>     // for std::uintptr_t
+#include <algorithm>   // for std::equal
+#include <functional>  // for std::less
+#include <iterator>    // for std::bidirectional_iterator_tag and std::distance
+#include <utility>     // for std::pair
+#include <vector>      // for std::vector
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h> // for _mm_prefetch
+#endif
+
+class TestFrozenSet; // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * FROZEN SET
+ * An immutable set whose elements are stored in one array in the
+ * order a breadth-first walk of a perfectly balanced tree would visit
+ * them (the Eytzinger layout): the root first, then its two children,
+ * then their four, and so on. The children of slot k are slots 2k and
+ * 2k + 1, counting from 1, so there are no pointers at all.
+ *
+ * A lookup reads the top of the tree from the same few cache lines
+ * every time, and each step down lands at a predictable place, so we
+ * ask for the line a few levels below while still comparing this one.
+ *
+ * Built in O(n) from elements already in order, such as the in-order
+ * walk of a set: see set::freeze(). T must be default constructible
+ * since the slots are filled out of order. Iterating goes in sorted
+ * order
+ ***********************************************/
+template <typename T, typename Compare = std::less<T>>
+class frozen_set
+{
+   friend class ::TestFrozenSet; // give unit tests access to the privates
+
+public:
+   using key_compare = Compare;
+
+   //
+   // Construct
+   //
+
+   frozen_set() : data(), compare()
+   {
+   }
+
+   // the caller promises [first, last) is sorted without duplicates
+   template <class Iterator>
+   frozen_set(Iterator first, Iterator last, const Compare & compare = Compare()) :
+      data(), compare(compare)
+   {
+      build(first, (size_t)std::distance(first, last));
+   }
+   template <class Iterator>
+   frozen_set(Iterator first, size_t num, const Compare & compare = Compare()) :
+      data(), compare(compare)
+   {
+      build(first, num);
+   }
+
+   //
+   // Iterator
+   //
+
+   class iterator;
+   using const_iterator = iterator;   // elements are never changed
+   iterator begin() const noexcept { return iterator(this, leftmost(1)); }
+   iterator end()   const noexcept { return iterator(this, 0);           }
+
+   // walk backwards with --: the iterator falls off the front to rend()
+   iterator rbegin() const noexcept { return iterator(this, rightmost(1)); }
+   iterator rend()   const noexcept { return iterator(this, 0);            }
+
+   //
+   // Access
+   //
+
+   iterator find(const T & t) const
+   {
+      size_t k = lowerBound(t);
+      return iterator(this, (k != 0 && !compare(t, at(k))) ? k : 0);
+   }
+   iterator lower_bound(const T & t) const { return iterator(this, lowerBound(t)); }
+   iterator upper_bound(const T & t) const { return iterator(this, upperBound(t)); }
+   std::pair<iterator, iterator> equal_range(const T & t) const
+   {
+      return std::pair<iterator, iterator>(lower_bound(t), upper_bound(t));
+   }
+   size_t count(const T & t)    const { return contains(t) ? 1 : 0; }
+   bool   contains(const T & t) const { return find(t) != end();    }
+
+   // the smallest and largest elements: not for an empty set
+   const T & front() const { assert(!data.empty()); return at(leftmost(1));  }
+   const T & back()  const { assert(!data.empty()); return at(rightmost(1)); }
+
+   //
+   // Status
+   //
+
+   bool   empty() const noexcept { return data.empty(); }
+   size_t size()  const noexcept { return data.size();  }
+   key_compare key_comp() const  { return compare;      }
+
+private:
+
+   // the largest power of two no more than num, or 1
+   static constexpr size_t floorPow2(size_t num) noexcept
+   {
+      return num < 2 ? 1 : 2 * floorPow2(num / 2);
+   }
+
+   // k times this is where the descendants of k that fill one cache
+   // line start, log2(numAhead) levels down: four for 4-byte elements,
+   // one for 32-byte ones. Only a power of two lands on descendants of
+   // k. At 1, for elements of more than half a line, it would fetch
+   // the line being compared, so there is no prefetch at all
+   static constexpr size_t numAhead = floorPow2(64 / sizeof(T));
+
+   template <class Iterator>
+   void build(Iterator & it, size_t num);
+   template <class Iterator>
+   void fill(Iterator & it, size_t k);
+
+   size_t lowerBound(const T & t) const;
+   size_t upperBound(const T & t) const;
+
+   // slots count from 1 so the children of k are 2k and 2k + 1
+   const T & at(size_t k) const { return data[k - 1]; }
+
+   // the first and last slots of the subtree under k, in sorted order
+   size_t leftmost(size_t k) const noexcept
+   {
+      if (k > data.size())
+         return 0;
+      while (2 * k <= data.size())
+         k = 2 * k;
+      return k;
+   }
+   size_t rightmost(size_t k) const noexcept
+   {
+      if (k > data.size())
+         return 0;
+      while (2 * k + 1 <= data.size())
+         k = 2 * k + 1;
+      return k;
+   }
+
+   // the slot we were at before the last run of steps in one direction:
+   // undo the right steps (for lower bound) or the left steps (for --)
+   static size_t climbPastRight(size_t k) noexcept
+   {
+      while (k & 1)
+         k >>= 1;
+      return k >> 1;
+   }
+   static size_t climbPastLeft(size_t k) noexcept
+   {
+      while (k != 0 && !(k & 1))
+         k >>= 1;
+      return k >> 1;
+   }
+
+   // no bounds check: a branch here costs more than the prefetch saves,
+   // and a prefetch past the end of the array is dropped, not a fault.
+   // The address is worked out as an integer so it is never a pointer
+   // past the end
+   void prefetch(size_t k) const noexcept
+   {
+      if constexpr (numAhead > 1)
+      {
+         const char * pAhead = reinterpret_cast<const char *>(
+            reinterpret_cast<std::uintptr_t>(data.data()) + (k * numAhead - 1) * sizeof(T));
+#if defined(__GNUC__) || defined(__clang__)
+         __builtin_prefetch(pAhead);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+         _mm_prefetch(pAhead, _MM_HINT_T0);
+#else
+         (void)pAhead;
+#endif
+      }
+   }
+
+   std::vector <T> data;  // the elements in breadth-first order
+   Compare compare;       // strict weak ordering of the elements
+};
+
+/**************************************************
+ * FROZEN SET ITERATOR
+ * Walks the array in sorted order: the slot after k is the leftmost
+ * below its right child, or failing that the first ancestor we are
+ * to the left of. 0 is end()
+ *************************************************/
+template <typename T, typename Compare>
+class frozen_set <T, Compare> :: iterator
+{
+   friend class ::TestFrozenSet; // give unit tests access to the privates
+   friend class custom::frozen_set <T, Compare>;
+
+public:
+   using iterator_category = std::bidirectional_iterator_tag;
+   using value_type        = T;
+   using difference_type   = std::ptrdiff_t;
+   using pointer           = const T *;
+   using reference         = const T &;
+
+   iterator() : pSet(nullptr), k(0)
+   {
+   }
+
+   bool operator == (const iterator & rhs) const { return k == rhs.k; }
+   bool operator != (const iterator & rhs) const { return k != rhs.k; }
+
+   const T & operator * () const
+   {
+      assert(k != 0);
+      return pSet->at(k);
+   }
+   const T * operator -> () const
+   {
+      return &**this;
+   }
+
+   iterator & operator ++ ()
+   {
+      assert(k != 0);
+      k = (2 * k + 1 <= pSet->data.size()) ? pSet->leftmost(2 * k + 1) : climbPastRight(k);
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator itReturn(*this);
+      ++*this;
+      return itReturn;
+   }
+   iterator & operator -- ()
+   {
+      assert(k != 0);
+      k = (2 * k <= pSet->data.size()) ? pSet->rightmost(2 * k) : climbPastLeft(k);
+      return *this;
+   }
+   iterator operator -- (int)
+   {
+      iterator itReturn(*this);
+      --*this;
+      return itReturn;
+   }
+
+private:
+   iterator(const frozen_set * pSet, size_t k) : pSet(pSet), k(k)
+   {
+   }
+
+   const frozen_set * pSet;
+   size_t k;              // slot counting from 1, or 0 for end()
+};
+
+/*********************************************
+ * FROZEN SET :: BUILD
+ * Make room for num elements and drop them into their slots with an
+ * in-order walk of the implicit tree, which visits the slots in the
+ * same order the sorted input arrives: O(n)
+ ********************************************/
+template <typename T, typename C>
+template <class Iterator>
+void frozen_set <T, C> :: build(Iterator & it, size_t num)
+{
+   data.resize(num);
+   fill(it, 1);
+}
+
+template <typename T, typename C>
+template <class Iterator>
+void frozen_set <T, C> :: fill(Iterator & it, size_t k)
+{
+   if (k > data.size())
+      return;
+   fill(it, 2 * k);
+   data[k - 1] = *it;
+   ++it;
+   fill(it, 2 * k + 1);
+}
+
+/*********************************************
+ * FROZEN SET :: LOWER BOUND
+ * The slot of the first element not less than t, or 0. Go left when
+ * the element is not less than t and right when it is, so k spells
+ * out the path in binary. The answer is where we last went left: drop
+ * the trailing right steps and that one left step
+ ********************************************/
+template <typename T, typename C>
+size_t frozen_set <T, C> :: lowerBound(const T & t) const
+{
+   size_t k = 1;
+   while (k <= data.size())
+   {
+      prefetch(k);
+      k = 2 * k + (compare(at(k), t) ? 1 : 0);
+   }
+   return climbPastRight(k);
+}
+
+/*********************************************
+ * FROZEN SET :: UPPER BOUND
+ * The slot of the first element greater than t, or 0
+ ********************************************/
+template <typename T, typename C>
+size_t frozen_set <T, C> :: upperBound(const T & t) const
+{
+   size_t k = 1;
+   while (k <= data.size())
+   {
+      prefetch(k);
+      k = 2 * k + (compare(t, at(k)) ? 0 : 1);
+   }
+   return climbPastRight(k);
+}
+
+/***********************************************
+ * FROZEN SET : EQUIVALENCE
+ * Same elements in the same order
+ ***********************************************/
+template <typename T, typename C>
+bool operator == (const frozen_set <T, C> & lhs, const frozen_set <T, C> & rhs)
+{
+   return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, typename C>
+inline bool operator != (const frozen_set <T, C> & lhs, const frozen_set <T, C> & rhs)
+{
+   return !(lhs == rhs);
+}
+
+} // namespace custom
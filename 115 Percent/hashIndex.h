@@ -0,0 +1,232 @@
+/***********************************************************************
+ * Header:
+ *    HASH INDEX
+ * Summary:
+ *    A hash table from an element to the node holding it
+ *
+ *    This will contain the class definition of:
+ *        HashIndex           : Open addressing from elements to nodes
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint64_t
+#include <utility>     // for std::swap
+#include <vector>      // for std::vector
+
+namespace custom
+{
+
+/************************************************
+ * HASH INDEX
+ * Finds the node holding an element in O(1) on average, next to a
+ * tree that already holds the nodes. Slots are probed one after the
+ * other (linear probing) from where the hash lands, and each keeps the
+ * full hash beside the node pointer so a slot that does not match is
+ * passed over without touching the node. An erase shifts the run after
+ * it back rather than leaving a marker, so lookups never slow down
+ * from churn.
+ *
+ * Two elements equivalent under Compare must have the same Hash.
+ *
+ * Copying one would point into the other tree, so there is no copy:
+ * the owner rebuilds it from its own nodes instead
+ ***********************************************/
+template <typename T, typename Node, typename Compare, typename Hash>
+class HashIndex
+{
+public:
+   static constexpr bool enabled = true;
+
+   HashIndex() : slots(), numEntries(0), hash()
+   {
+   }
+   HashIndex(const HashIndex &) = delete;
+   HashIndex & operator = (const HashIndex &) = delete;
+   void swap(HashIndex & rhs) noexcept
+   {
+      slots.swap(rhs.slots);
+      std::swap(numEntries, rhs.numEntries);
+      std::swap(hash, rhs.hash);
+   }
+
+   // the node holding an element equivalent to t, or nullptr
+   Node * find(const T & t, const Compare & compare) const
+   {
+      if (numEntries == 0)
+         return nullptr;
+      size_t h = mix(hash(t));
+      for (size_t i = h & mask();; i = (i + 1) & mask())
+      {
+         const Slot & slot = slots[i];
+         if (slot.pNode == nullptr)
+            return nullptr;
+         if (slot.hash == h && !compare(t, slot.pNode->data) && !compare(slot.pNode->data, t))
+            return slot.pNode;
+      }
+   }
+
+   void insert(Node * pNode);
+   void erase(const Node * pNode);
+   void reserve(size_t num);
+   void clear() noexcept
+   {
+      std::vector <Slot> ().swap(slots);
+      numEntries = 0;
+   }
+
+   size_t size()  const noexcept { return numEntries; }
+   size_t bytes() const noexcept { return slots.capacity() * sizeof(Slot); }
+
+private:
+
+   struct Slot
+   {
+      size_t hash;        // mixed hash of the element, to skip most compares
+      Node * pNode;       // the node, or nullptr for an empty slot
+   };
+
+   // no more than three slots in four are used before we grow
+   static constexpr size_t numSlotsMin = 16;
+   static bool isFull(size_t numEntries, size_t numSlots)
+   {
+      return numEntries * 4 > numSlots * 3;
+   }
+
+   size_t mask() const noexcept { return slots.size() - 1; }
+
+   // spread the bits of a hash over the low ones we mask with: the
+   // standard hash of an integer is the integer, and keys that step
+   // by a power of two would otherwise all land in a few slots
+   static size_t mix(size_t h) noexcept
+   {
+      uint64_t x = h;
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdull;
+      x ^= x >> 33;
+      return (size_t)x;
+   }
+   void resize(size_t numSlots);
+
+   std::vector <Slot> slots;   // a power of two of them
+   size_t numEntries;          // how many slots are in use
+   Hash hash;                  // hash of an element
+};
+
+/************************************************
+ * HASH INDEX : no index
+ * Hash of void means there is nothing to keep up to date
+ ***********************************************/
+template <typename T, typename Node, typename Compare>
+class HashIndex <T, Node, Compare, void>
+{
+public:
+   static constexpr bool enabled = false;
+
+   void swap(HashIndex &) noexcept                          {                 }
+   Node * find(const T &, const Compare &) const            { return nullptr; }
+   void insert(Node *)                                      {                 }
+   void erase(const Node *)                                 {                 }
+   void reserve(size_t)                                     {                 }
+   void clear() noexcept                                    {                 }
+   size_t size()  const noexcept                            { return 0;       }
+   size_t bytes() const noexcept                            { return 0;       }
+};
+
+/*********************************************
+ * HASH INDEX :: INSERT
+ * Remember which node holds an element. The element is not already
+ * in the index: the tree has just made a node for it
+ ********************************************/
+template <typename T, typename Node, typename C, typename H>
+void HashIndex <T, Node, C, H> :: insert(Node * pNode)
+{
+   assert(pNode != nullptr);
+   if (slots.empty() || isFull(numEntries + 1, slots.size()))
+      resize(slots.empty() ? numSlotsMin : slots.size() * 2);
+
+   size_t h = mix(hash(pNode->data));
+   size_t i = h & mask();
+   while (slots[i].pNode != nullptr)
+      i = (i + 1) & mask();
+   slots[i].hash = h;
+   slots[i].pNode = pNode;
+   numEntries++;
+}
+
+/*********************************************
+ * HASH INDEX :: ERASE
+ * Forget a node before it is destroyed. Every slot after it in the
+ * same run that could live in its place moves back one hop at a time,
+ * so no lookup ever stops early at the hole
+ ********************************************/
+template <typename T, typename Node, typename C, typename H>
+void HashIndex <T, Node, C, H> :: erase(const Node * pNode)
+{
+   if (numEntries == 0)
+      return;
+
+   size_t i = mix(hash(pNode->data)) & mask();
+   while (slots[i].pNode != pNode)
+   {
+      if (slots[i].pNode == nullptr)
+         return;
+      i = (i + 1) & mask();
+   }
+
+   // i is the hole. A later slot j moves into it unless its home is
+   // between the hole and j, going round the end of the table
+   for (size_t j = (i + 1) & mask(); slots[j].pNode != nullptr; j = (j + 1) & mask())
+   {
+      size_t home = slots[j].hash & mask();
+      bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+      if (!stays)
+      {
+         slots[i] = slots[j];
+         i = j;
+      }
+   }
+   slots[i].pNode = nullptr;
+   numEntries--;
+}
+
+/*********************************************
+ * HASH INDEX :: RESERVE
+ * Room for num entries without growing
+ ********************************************/
+template <typename T, typename Node, typename C, typename H>
+void HashIndex <T, Node, C, H> :: reserve(size_t num)
+{
+   size_t numSlots = numSlotsMin;
+   while (isFull(num, numSlots))
+      numSlots *= 2;
+   if (numSlots > slots.size())
+      resize(numSlots);
+}
+
+/*********************************************
+ * HASH INDEX :: RESIZE
+ * Move every entry into a table of numSlots slots. The hashes are
+ * kept, so no element is hashed twice
+ ********************************************/
+template <typename T, typename Node, typename C, typename H>
+void HashIndex <T, Node, C, H> :: resize(size_t numSlots)
+{
+   std::vector <Slot> slotsOld(numSlots, Slot { 0, nullptr });
+   slots.swap(slotsOld);
+   for (const Slot & slot : slotsOld)
+   {
+      if (slot.pNode == nullptr)
+         continue;
+      size_t i = slot.hash & mask();
+      while (slots[i].pNode != nullptr)
+         i = (i + 1) & mask();
+      slots[i] = slot;
+   }
+}
+
+} // namespace custom
@@ -0,0 +1,914 @@
+/***********************************************************************
+ * Header:
+ *    PERSISTENT SET
+ * Summary:
+ *    A set whose every version stays valid. Changing it copies the
+ *    path to the change and shares everything else with older versions
+ *
+ *    This will contain the class definition of:
+ *        persistent_set            : An immutable, path-copying set
+ *        persistent_set::iterator  : An iterator through one version
+ *        ==, !=, <, >, <=, >=      : Comparison of two versions
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>    // for size_t and std::ptrdiff_t
+#include <atomic>     // for std::atomic
+#include <functional> // for std::less
+#include <iterator>   // for std::forward_iterator_tag
+#include <utility>    // for std::pair, std::move, std::forward, and std::swap
+#if __cpp_impl_three_way_comparison >= 201907L && __has_include(<compare>)
+#include <compare>    // for operator <=>
+#endif
+#include "pool.h"     // for custom::shared_pool
+
+class TestPersistentSet; // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * PERSISTENT SET
+ * A set where a copy is a snapshot: it shares the whole tree, so it
+ * costs O(1), and nothing done to one version is seen by another.
+ * Nodes are never changed once built. An insert or erase builds new
+ * nodes for the path down to the change, O(log n) of them, and points
+ * them at the untouched subtrees of the old version. Subtrees are
+ * reference counted, so a node lives as long as some version uses it.
+ *
+ * The tree is height balanced (AVL) rather than red-black: rebuilding
+ * the path bottom up makes the AVL erase simple, and the path copied
+ * is just as short.
+ *
+ * Versions may be read, copied, and released from different threads
+ * while another thread changes its own version
+ ***********************************************/
+template <typename T, typename Compare = std::less<T>>
+class persistent_set
+{
+   friend class ::TestPersistentSet; // give unit tests access to the privates
+
+   template <class TT, class CC>
+   friend bool operator == (const persistent_set <TT, CC> &, const persistent_set <TT, CC> &);
+   template <class TT, class CC>
+   friend bool operator < (const persistent_set <TT, CC> &, const persistent_set <TT, CC> &);
+
+   class PNode;
+   class Ref;
+
+public:
+   using key_compare = Compare;
+
+   //
+   // Construct
+   //
+
+   persistent_set() : numElements(0), compare()
+   {
+   }
+   explicit persistent_set(const Compare & compare) : numElements(0), compare(compare)
+   {
+   }
+   persistent_set(const std::initializer_list <T> & il) : numElements(0), compare()
+   {
+      insert(il.begin(), il.end());
+   }
+   template <class Iterator>
+   persistent_set(Iterator first, Iterator last) : numElements(0), compare()
+   {
+      insert(first, last);
+   }
+
+   // copies share the tree: these are all O(1)
+   persistent_set(const persistent_set &  rhs) = default;
+   persistent_set(      persistent_set && rhs) noexcept : root(std::move(rhs.root)),
+      numElements(rhs.numElements), compare(rhs.compare)
+   {
+      rhs.numElements = 0;
+   }
+   persistent_set & operator = (const persistent_set & rhs) = default;
+   persistent_set & operator = (persistent_set && rhs) noexcept
+   {
+      swap(rhs);
+      rhs.clear();
+      return *this;
+   }
+   void swap(persistent_set & rhs) noexcept
+   {
+      std::swap(root, rhs.root);
+      std::swap(numElements, rhs.numElements);
+      std::swap(compare, rhs.compare);
+   }
+
+   // this version as it is now, unaffected by later changes to either
+   persistent_set snapshot() const
+   {
+      return *this;
+   }
+
+   //
+   // Iterator
+   //
+
+   class iterator;
+   using const_iterator = iterator;   // elements are never changed in place
+   iterator begin() const;
+   iterator end()   const { return iterator(); }
+
+   //
+   // Access
+   //
+
+   iterator find(const T & t) const;
+   iterator lower_bound(const T & t) const;
+   iterator upper_bound(const T & t) const;
+   std::pair <iterator, iterator> equal_range(const T & t) const
+   {
+      iterator itLower = lower_bound(t);
+      iterator itUpper = itLower;
+      if (itUpper != end() && !compare(t, *itUpper))
+      {
+         ++itUpper;
+      }
+      return std::pair <iterator, iterator> (itLower, itUpper);
+   }
+   bool     contains(const T & t) const;
+   size_t   count(const T & t) const { return contains(t) ? 1 : 0; }
+
+   //
+   // Insert: the iterator is into the new version
+   //
+
+   std::pair <iterator, bool> insert(const T & t)
+   {
+      return insertValue(t);
+   }
+   std::pair <iterator, bool> insert(T && t)
+   {
+      return insertValue(std::move(t));
+   }
+   template <class ... Args>
+   std::pair <iterator, bool> emplace(Args && ... args)
+   {
+      return insertValue(T(std::forward<Args>(args)...));
+   }
+   template <class Iterator>
+   void insert(Iterator first, Iterator last)
+   {
+      for (; first != last; ++first)
+      {
+         insert(*first);
+      }
+   }
+
+   //
+   // Remove: iterators given are into this version, the one returned
+   // into the new one
+   //
+
+   size_t   erase(const T & t);
+   iterator erase(iterator it);
+   iterator erase(iterator first, iterator last);
+   void clear() noexcept
+   {
+      root = Ref();
+      numElements = 0;
+   }
+
+   //
+   // Status
+   //
+
+   bool   empty() const noexcept { return numElements == 0; }
+   size_t size()  const noexcept { return numElements;      }
+   key_compare key_comp() const  { return compare;          }
+
+private:
+
+   template <class U>
+   std::pair <iterator, bool> insertValue(U && t);
+   template <class U>
+   Ref insert(const Ref & pNode, U && t, Ref & pLeaf);
+   Ref erase(const Ref & pNode, const T & t, bool & erased);
+   static Ref eraseMin(const Ref & pNode);
+   static Ref balance(const T & t, Ref pLeft, Ref pRight);
+   template <class U>
+   static Ref makeNode(U && t, Ref pLeft, Ref pRight);
+   static int heightOf(const Ref & pNode) noexcept
+   {
+      return pNode ? pNode->height : 0;
+   }
+
+   Ref root;              // this version's tree, shared with others
+   size_t numElements;    // number of elements in this version
+   Compare compare;       // strict weak ordering of the elements
+};
+
+/************************************************
+ * PERSISTENT SET :: REF
+ * A counted reference to a node. The last reference to go frees the
+ * node, and with it the node's own references to its children
+ ***********************************************/
+template <typename T, typename C>
+class persistent_set <T, C> :: Ref
+{
+public:
+   Ref() noexcept : p(nullptr)
+   {
+   }
+   // take over a node fresh from new, which starts with one reference
+   explicit Ref(PNode * p) noexcept : p(p)
+   {
+   }
+   Ref(const Ref & rhs) noexcept : p(rhs.p)
+   {
+      if (p)
+      {
+         p->numRefs.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+   Ref(Ref && rhs) noexcept : p(rhs.p)
+   {
+      rhs.p = nullptr;
+   }
+   ~Ref()
+   {
+      // the last one out sees every change made before the others left
+      if (p && p->numRefs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+         delete p;
+      }
+   }
+   Ref & operator = (Ref rhs) noexcept
+   {
+      std::swap(p, rhs.p);
+      return *this;
+   }
+
+   const PNode * operator -> () const noexcept { return p;            }
+   const PNode * get()          const noexcept { return p;            }
+   explicit operator bool()     const noexcept { return p != nullptr; }
+
+private:
+   PNode * p;
+};
+
+/************************************************
+ * PERSISTENT SET :: PNODE
+ * A node that never changes after it is built
+ ***********************************************/
+template <typename T, typename C>
+class persistent_set <T, C> :: PNode
+{
+public:
+   template <class U>
+   PNode(U && t, Ref && pLeft, Ref && pRight) : data(std::forward<U>(t)),
+      pLeft(std::move(pLeft)), pRight(std::move(pRight)), numRefs(1)
+   {
+      int heightLeft  = heightOf(this->pLeft);
+      int heightRight = heightOf(this->pRight);
+      height = 1 + (heightLeft > heightRight ? heightLeft : heightRight);
+   }
+
+   //
+   // Allocate: nodes come out of a shared slab pool rather than the heap
+   //
+   static void * operator new(size_t size)
+   {
+      assert(size == sizeof(PNode));
+      return shared_pool <PNode> :: instance().allocate();
+   }
+   static void operator delete(void * p) noexcept
+   {
+      shared_pool <PNode> :: instance().deallocate(p);
+   }
+
+   T data;                              // the element
+   Ref pLeft;                           // left subtree - smaller
+   Ref pRight;                          // right subtree - larger
+   int height;                          // nodes on the longest path down
+   mutable std::atomic <size_t> numRefs; // references from parents and versions
+};
+
+/**********************************************************
+ * PERSISTENT SET ITERATOR
+ * Nodes do not know their parents, since many versions may share
+ * them, so the iterator keeps the path from the root: the nodes we
+ * went left from and, on top, the current one. The path is never
+ * longer than the tree is tall. It fits in the iterator for a tree of
+ * a few thousand elements and comes from the heap for a taller one.
+ * An iterator is good as long as the version it came from is
+ *********************************************************/
+template <typename T, typename C>
+class persistent_set <T, C> :: iterator
+{
+   friend class ::TestPersistentSet; // give unit tests access to the privates
+   friend class persistent_set <T, C>;
+public:
+   using iterator_category = std::forward_iterator_tag;
+   using value_type        = T;
+   using difference_type   = std::ptrdiff_t;
+   using pointer           = const T *;
+   using reference         = const T &;
+
+   iterator() : path(inlinePath), depth(0), capacity(numInline)
+   {
+   }
+   iterator(const iterator & rhs) : iterator()
+   {
+      *this = rhs;
+   }
+   iterator(iterator && rhs) noexcept : iterator()
+   {
+      *this = std::move(rhs);
+   }
+   ~iterator()
+   {
+      if (path != inlinePath)
+      {
+         delete [] path;
+      }
+   }
+   iterator & operator = (const iterator & rhs)
+   {
+      if (this != &rhs)
+      {
+         reserve(rhs.capacity);
+         for (int i = 0; i < rhs.depth; i++)
+         {
+            path[i] = rhs.path[i];
+         }
+         depth = rhs.depth;
+      }
+      return *this;
+   }
+   iterator & operator = (iterator && rhs) noexcept
+   {
+      if (rhs.path != rhs.inlinePath)
+      {
+         std::swap(path, rhs.path);
+         std::swap(capacity, rhs.capacity);
+         if (rhs.path == inlinePath)
+         {
+            rhs.path = rhs.inlinePath;
+         }
+         depth = rhs.depth;
+      }
+      else if (this != &rhs)
+      {
+         for (int i = 0; i < rhs.depth; i++)
+         {
+            path[i] = rhs.path[i];
+         }
+         depth = rhs.depth;
+      }
+      return *this;
+   }
+
+   // compare
+   bool operator == (const iterator & rhs) const
+   {
+      return depth == rhs.depth && (depth == 0 || path[depth - 1] == rhs.path[depth - 1]);
+   }
+   bool operator != (const iterator & rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   // de-reference. Cannot change because other versions may share it
+   const T & operator * () const
+   {
+      return path[depth - 1]->data;
+   }
+
+   // increment
+   iterator & operator ++ ();
+   iterator   operator ++ (int postfix)
+   {
+      iterator itReturn = *this;
+      ++(*this);
+      return itReturn;
+   }
+
+private:
+
+   // go down the left spine of pNode, remembering the way
+   void pushLeft(const PNode * pNode)
+   {
+      for (; pNode != nullptr; pNode = pNode->pLeft.get())
+      {
+         push(pNode);
+      }
+   }
+   void push(const PNode * pNode)
+   {
+      assert(depth < capacity);
+      path[depth++] = pNode;
+   }
+
+   // room for a path down a tree this tall. Only done while empty or
+   // about to be overwritten, so nothing is copied
+   void reserve(int height)
+   {
+      if (height > capacity)
+      {
+         const PNode ** pathNew = new const PNode * [height];
+         if (path != inlinePath)
+         {
+            delete [] path;
+         }
+         path = pathNew;
+         capacity = height;
+      }
+   }
+
+   // an AVL tree this tall holds at least a few hundred elements and
+   // usually thousands
+   static constexpr int numInline = 12;
+
+   const PNode ** path;                 // inlinePath, or from new if taller
+   int depth;                           // nodes on the path
+   int capacity;                        // room in path
+   const PNode * inlinePath[numInline];
+};
+
+
+/*********************************************
+ * PERSISTENT SET :: BEGIN
+ * The path down to the smallest element
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: iterator persistent_set <T, C> :: begin() const
+{
+   iterator it;
+   it.reserve(heightOf(root));
+   it.pushLeft(root.get());
+   return it;
+}
+
+/*********************************************
+ * PERSISTENT SET :: FIND
+ * The element equivalent to t, end() if none
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: iterator persistent_set <T, C> :: find(const T & t) const
+{
+   iterator it = lower_bound(t);
+   if (it != end() && compare(t, *it))
+   {
+      return end();
+   }
+   return it;
+}
+
+/*********************************************
+ * PERSISTENT SET :: LOWER BOUND
+ * The first element not less than t, end() if none. The nodes we go
+ * left from are exactly the path the iterator needs
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: iterator persistent_set <T, C> :: lower_bound(const T & t) const
+{
+   iterator it;
+   it.reserve(heightOf(root));
+   for (const PNode * p = root.get(); p != nullptr; )
+   {
+      if (compare(p->data, t))
+      {
+         p = p->pRight.get();
+      }
+      else
+      {
+         it.push(p);
+         p = p->pLeft.get();
+      }
+   }
+
+   // the bound is the last node we went left from, now on top
+   return it;
+}
+
+/*********************************************
+ * PERSISTENT SET :: UPPER BOUND
+ * The first element greater than t, end() if none
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: iterator persistent_set <T, C> :: upper_bound(const T & t) const
+{
+   iterator it;
+   it.reserve(heightOf(root));
+   for (const PNode * p = root.get(); p != nullptr; )
+   {
+      if (compare(t, p->data))
+      {
+         it.push(p);
+         p = p->pLeft.get();
+      }
+      else
+      {
+         p = p->pRight.get();
+      }
+   }
+   return it;
+}
+
+/*********************************************
+ * PERSISTENT SET :: CONTAINS
+ * Is there an element equivalent to t?
+ ********************************************/
+template <typename T, typename C>
+bool persistent_set <T, C> :: contains(const T & t) const
+{
+   const PNode * p = root.get();
+   while (p != nullptr)
+   {
+      if (compare(t, p->data))
+      {
+         p = p->pLeft.get();
+      }
+      else if (compare(p->data, t))
+      {
+         p = p->pRight.get();
+      }
+      else
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+/*********************************************
+ * PERSISTENT SET :: INSERT VALUE
+ * Add t unless it is already there. Other versions are unaffected.
+ * A rotation on the way up may copy the new node, so it is found again
+ * by its value, which the leaf we made keeps alive until then
+ ********************************************/
+template <typename T, typename C>
+template <class U>
+std::pair <typename persistent_set <T, C> :: iterator, bool> persistent_set <T, C> :: insertValue(U && t)
+{
+   Ref pLeaf;
+   Ref pNew = insert(root, std::forward<U>(t), pLeaf);
+   if (!pLeaf)
+   {
+      // t was not used, so it is still there to look for
+      return std::pair <iterator, bool> (find(t), false);
+   }
+   root = std::move(pNew);
+   numElements++;
+   return std::pair <iterator, bool> (find(pLeaf->data), true);
+}
+
+/*********************************************
+ * PERSISTENT SET :: ERASE
+ * Remove the element equivalent to t, if any, and say how many went
+ ********************************************/
+template <typename T, typename C>
+size_t persistent_set <T, C> :: erase(const T & t)
+{
+   bool erased = false;
+   Ref pNew = erase(root, t, erased);
+   if (!erased)
+   {
+      return 0;
+   }
+   root = std::move(pNew);
+   numElements--;
+   return 1;
+}
+
+/*********************************************
+ * PERSISTENT SET :: ERASE ITERATOR
+ * Remove the element it is on. The next one is found in the new
+ * version
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: iterator persistent_set <T, C> :: erase(iterator it)
+{
+   if (it == end())
+   {
+      return end();
+   }
+   iterator itNext = it;
+   return erase(it, ++itNext);
+}
+
+/*********************************************
+ * PERSISTENT SET :: ERASE RANGE
+ * Remove [first, last). The old version is held on to until we are
+ * done, so first and last stay good while each erase builds a new one
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: iterator persistent_set <T, C> :: erase(iterator first, iterator last)
+{
+   Ref pOld = root;
+   for (; first != last; ++first)
+   {
+      erase(*first);
+   }
+   return last == end() ? end() : lower_bound(*last);
+}
+
+/*********************************************
+ * PERSISTENT SET :: INSERT NODE
+ * The subtree pNode with t added, copying the path down to where t
+ * goes, and pLeaf set to the node made for t. When t is already there,
+ * pNode itself, and pLeaf is left empty. Only the new node takes t,
+ * so an rvalue is moved there and nowhere else
+ ********************************************/
+template <typename T, typename C>
+template <class U>
+typename persistent_set <T, C> :: Ref persistent_set <T, C> :: insert(const Ref & pNode, U && t, Ref & pLeaf)
+{
+   if (!pNode)
+   {
+      pLeaf = makeNode(std::forward<U>(t), Ref(), Ref());
+      return pLeaf;
+   }
+
+   if (compare(t, pNode->data))
+   {
+      Ref pLeft = insert(pNode->pLeft, std::forward<U>(t), pLeaf);
+      return pLeaf ? balance(pNode->data, std::move(pLeft), pNode->pRight) : pNode;
+   }
+   if (compare(pNode->data, t))
+   {
+      Ref pRight = insert(pNode->pRight, std::forward<U>(t), pLeaf);
+      return pLeaf ? balance(pNode->data, pNode->pLeft, std::move(pRight)) : pNode;
+   }
+
+   return pNode;
+}
+
+/*********************************************
+ * PERSISTENT SET :: ERASE NODE
+ * The subtree pNode without t, copying the path down to it. A node
+ * with two children is replaced by a copy of its in-order successor
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: Ref persistent_set <T, C> :: erase(const Ref & pNode, const T & t, bool & erased)
+{
+   if (!pNode)
+   {
+      erased = false;
+      return Ref();
+   }
+
+   if (compare(t, pNode->data))
+   {
+      Ref pLeft = erase(pNode->pLeft, t, erased);
+      return erased ? balance(pNode->data, std::move(pLeft), pNode->pRight) : pNode;
+   }
+   if (compare(pNode->data, t))
+   {
+      Ref pRight = erase(pNode->pRight, t, erased);
+      return erased ? balance(pNode->data, pNode->pLeft, std::move(pRight)) : pNode;
+   }
+
+   erased = true;
+   if (!pNode->pLeft)
+   {
+      return pNode->pRight;
+   }
+   if (!pNode->pRight)
+   {
+      return pNode->pLeft;
+   }
+
+   const PNode * pIOS = pNode->pRight.get();
+   while (pIOS->pLeft)
+   {
+      pIOS = pIOS->pLeft.get();
+   }
+   return balance(pIOS->data, pNode->pLeft, eraseMin(pNode->pRight));
+}
+
+/*********************************************
+ * PERSISTENT SET :: ERASE MIN
+ * The subtree pNode without its smallest element
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: Ref persistent_set <T, C> :: eraseMin(const Ref & pNode)
+{
+   if (!pNode->pLeft)
+   {
+      return pNode->pRight;
+   }
+   return balance(pNode->data, eraseMin(pNode->pLeft), pNode->pRight);
+}
+
+/*********************************************
+ * PERSISTENT SET :: BALANCE
+ * A new node holding t over pLeft and pRight, whose heights differ
+ * by at most two. When they differ by two, rotate the taller side up,
+ * building new nodes for the ones that move
+ *          t                 L
+ *        +-+-+             +-+-+
+ *       L     c    =>     a     t
+ *     +-+-+                   +-+-+
+ *    a     b                 b     c
+ ********************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: Ref persistent_set <T, C> :: balance(const T & t, Ref pLeft, Ref pRight)
+{
+   int heightLeft  = heightOf(pLeft);
+   int heightRight = heightOf(pRight);
+
+   if (heightLeft > heightRight + 1)
+   {
+      // single rotation when the outside grandchild is the tall one
+      if (heightOf(pLeft->pLeft) >= heightOf(pLeft->pRight))
+      {
+         Ref pNew = makeNode(t, pLeft->pRight, std::move(pRight));
+         return makeNode(pLeft->data, pLeft->pLeft, std::move(pNew));
+      }
+
+      // else the inside grandchild comes all the way up
+      const PNode * pMiddle = pLeft->pRight.get();
+      Ref pNewLeft  = makeNode(pLeft->data, pLeft->pLeft, pMiddle->pLeft);
+      Ref pNewRight = makeNode(t, pMiddle->pRight, std::move(pRight));
+      return makeNode(pMiddle->data, std::move(pNewLeft), std::move(pNewRight));
+   }
+
+   if (heightRight > heightLeft + 1)
+   {
+      if (heightOf(pRight->pRight) >= heightOf(pRight->pLeft))
+      {
+         Ref pNew = makeNode(t, std::move(pLeft), pRight->pLeft);
+         return makeNode(pRight->data, std::move(pNew), pRight->pRight);
+      }
+
+      const PNode * pMiddle = pRight->pLeft.get();
+      Ref pNewLeft  = makeNode(t, std::move(pLeft), pMiddle->pLeft);
+      Ref pNewRight = makeNode(pRight->data, pMiddle->pRight, pRight->pRight);
+      return makeNode(pMiddle->data, std::move(pNewLeft), std::move(pNewRight));
+   }
+
+   return makeNode(t, std::move(pLeft), std::move(pRight));
+}
+
+/*********************************************
+ * PERSISTENT SET :: MAKE NODE
+ * Allocate a node over two subtrees. If that fails, the references
+ * we were handed are let go on the way out
+ ********************************************/
+template <typename T, typename C>
+template <class U>
+typename persistent_set <T, C> :: Ref persistent_set <T, C> :: makeNode(U && t, Ref pLeft, Ref pRight)
+{
+   try
+   {
+      return Ref(new PNode(std::forward<U>(t), std::move(pLeft), std::move(pRight)));
+   }
+   catch (...)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+}
+
+/**************************************************
+ * PERSISTENT SET ITERATOR :: INCREMENT PREFIX
+ * Done with the node on top. Next is the left-most node of its right
+ * subtree or, without one, the node below it on the path
+ *************************************************/
+template <typename T, typename C>
+typename persistent_set <T, C> :: iterator & persistent_set <T, C> :: iterator :: operator ++ ()
+{
+   if (depth == 0)
+   {
+      return *this;
+   }
+
+   const PNode * pRight = path[--depth]->pRight.get();
+   pushLeft(pRight);
+   return *this;
+}
+
+/***********************************************
+ * PERSISTENT SET : EQUIVALENCE
+ * Two versions that share their tree, as a snapshot does until one of
+ * them changes, are equal without looking further. Otherwise both are
+ * walked in lockstep as with set
+ ***********************************************/
+template <typename T, typename C>
+bool operator == (const persistent_set <T, C> & lhs, const persistent_set <T, C> & rhs)
+{
+   if (lhs.size() != rhs.size())
+   {
+      return false;
+   }
+   if (lhs.root.get() == rhs.root.get())
+   {
+      return true;
+   }
+
+   for (auto itLHS = lhs.begin(), itRHS = rhs.begin(); itLHS != lhs.end(); ++itLHS, ++itRHS)
+   {
+      if (!(*itLHS == *itRHS))
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+template <typename T, typename C>
+inline bool operator != (const persistent_set <T, C> & lhs, const persistent_set <T, C> & rhs)
+{
+   return !(lhs == rhs);
+}
+
+/***********************************************
+ * PERSISTENT SET : RELATIVE COMPARISON
+ * Lexicographic: the first pair of elements that differs decides,
+ * else the shorter set is first
+ ***********************************************/
+template <typename T, typename C>
+bool operator < (const persistent_set <T, C> & lhs, const persistent_set <T, C> & rhs)
+{
+   if (lhs.root.get() == rhs.root.get())
+   {
+      return false;
+   }
+
+   auto itLHS = lhs.begin();
+   auto itRHS = rhs.begin();
+   for (; itLHS != lhs.end() && itRHS != rhs.end(); ++itLHS, ++itRHS)
+   {
+      if (*itLHS < *itRHS)
+      {
+         return true;
+      }
+      if (*itRHS < *itLHS)
+      {
+         return false;
+      }
+   }
+   return itLHS == lhs.end() && itRHS != rhs.end();
+}
+
+template <typename T, typename C>
+inline bool operator > (const persistent_set <T, C> & lhs, const persistent_set <T, C> & rhs)
+{
+   return rhs < lhs;
+}
+
+template <typename T, typename C>
+inline bool operator <= (const persistent_set <T, C> & lhs, const persistent_set <T, C> & rhs)
+{
+   return !(rhs < lhs);
+}
+
+template <typename T, typename C>
+inline bool operator >= (const persistent_set <T, C> & lhs, const persistent_set <T, C> & rhs)
+{
+   return !(lhs < rhs);
+}
+
+#if __cpp_impl_three_way_comparison >= 201907L && __has_include(<compare>)
+/***********************************************
+ * PERSISTENT SET : THREE-WAY COMPARISON
+ * The same lexicographic order in one pass. Elements without <=>
+ * of their own are ordered with <
+ ***********************************************/
+template <typename T, typename C>
+auto operator <=> (const persistent_set <T, C> & lhs, const persistent_set <T, C> & rhs)
+{
+   auto itLHS = lhs.begin();
+   auto itRHS = rhs.begin();
+   if constexpr (std::three_way_comparable<T>)
+   {
+      for (; itLHS != lhs.end() && itRHS != rhs.end(); ++itLHS, ++itRHS)
+      {
+         auto order = *itLHS <=> *itRHS;
+         if (order != 0)
+         {
+            return order;
+         }
+      }
+      return std::compare_three_way_result_t<T>(lhs.size() <=> rhs.size());
+   }
+   else
+   {
+      for (; itLHS != lhs.end() && itRHS != rhs.end(); ++itLHS, ++itRHS)
+      {
+         if (*itLHS < *itRHS)
+         {
+            return std::weak_ordering::less;
+         }
+         if (*itRHS < *itLHS)
+         {
+            return std::weak_ordering::greater;
+         }
+      }
+      return std::weak_ordering(lhs.size() <=> rhs.size());
+   }
+}
+#endif
+
+} // namespace custom
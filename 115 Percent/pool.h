@@ -0,0 +1,417 @@
+/***********************************************************************
+ * Header:
+ *    POOL
+ * Summary:
+ *    A slab allocator handing out fixed-size slots for tree nodes
+ *
+ *    This will contain the class definition of:
+ *        pool                : A free-list of slots carved out of slabs
+ *        shared_pool         : One locked pool for every owner of a type
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>     // for std::atomic
+#include <cassert>
+#include <cstddef>    // for size_t and offsetof
+#include <new>        // for std::align_val_t and std::bad_alloc
+#include <mutex>      // for std::mutex
+
+namespace custom
+{
+
+/*****************************************************************
+ * POOL
+ * Hands out slots big enough for one T. Slots are carved out of
+ * slabs so allocating a node is a pointer bump or a pop off the free
+ * list instead of a trip to the heap, and freed slots are recycled.
+ * The first slab holds a few slots and each one after holds twice as
+ * many as the last, up to 64KB, so a small tree costs one small
+ * allocation and a large one a few big ones.
+ *
+ * A pool belongs to the tree that made it, and while that tree is the
+ * only one that can reach its slots it takes no lock. The halves of a
+ * split both own their pool, and a join leaves the slots of a second
+ * pool in a tree that does not own it. From then on the pool is shared
+ * and takes its lock for every call, so trees that traded nodes can
+ * still be used from different threads, like any other trees.
+ *
+ * Every slot remembers its pool, so a slot goes back where it came
+ * from whoever frees it, and a pool lives until its last owner has let
+ * go and its last slot is back. Slabs are kept when slots are freed,
+ * even all of them, so a tree that is cleared and filled again does
+ * not go back to the heap; trim() gives them back
+ *****************************************************************/
+template <typename T>
+class pool
+{
+public:
+   //
+   // Construct: a pool starts with one owner and is never copied
+   //
+
+   static pool * create()
+   {
+      return new pool;
+   }
+   pool(const pool &) = delete;
+   pool & operator = (const pool &) = delete;
+
+   void acquire() noexcept;
+   void release() noexcept;
+
+   // another tree may free slots from here from now on
+   void share() noexcept
+   {
+      isShared.store(true, std::memory_order_relaxed);
+   }
+
+   //
+   // Allocate
+   //
+
+   void * allocate();
+   void trim() noexcept;
+
+   // back to the pool p came from, or to the heap
+   static void deallocate(void * p) noexcept;
+
+   // a slot of no pool, for a T made with new by hand
+   static void * allocateUnpooled();
+
+   // the pool p came from, or nullptr
+   static pool * poolOf(const void * p) noexcept
+   {
+      return slotOf(p)->pOwner;
+   }
+
+   //
+   // Status
+   //
+
+   size_t numSlabs() const noexcept { return numSlabsAllocated; }
+   size_t numLive()  const noexcept { return numSlotsLive;      }
+   bool   shared()   const noexcept { return isShared.load(std::memory_order_relaxed); }
+
+private:
+
+   pool() : pFree(nullptr), pCarve(nullptr), pCarveEnd(nullptr), pSlabs(nullptr),
+            numSlabsAllocated(0), numSlotsLive(0), numSlotsNext(numSlotsFirst), numOwners(1),
+            isShared(false), mutex()
+   {
+   }
+   ~pool()
+   {
+      freeSlabs();
+   }
+
+   // a slot is handed out, and knows its pool, or linked into the free list
+   struct Slot
+   {
+      union
+      {
+         pool * pOwner;
+         Slot * pNext;
+      };
+      alignas(T) unsigned char data[sizeof(T)];
+   };
+
+   // every slab starts with this header, and its slots follow
+   struct Slab
+   {
+      Slab * pNext;            // the slab made before this one
+   };
+
+   static constexpr size_t numSlotsFirst = 8;
+   static constexpr size_t slotsOffset()
+   {
+      return (sizeof(Slab) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+   }
+   static constexpr size_t numSlotsMax()
+   {
+      return (64 * 1024 - slotsOffset()) / sizeof(Slot) > numSlotsFirst ?
+             (64 * 1024 - slotsOffset()) / sizeof(Slot) : numSlotsFirst;
+   }
+   static constexpr bool overAligned = alignof(Slot) > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+   static Slot * slotOf(const void * p) noexcept
+   {
+      return reinterpret_cast<Slot *>(
+         const_cast<unsigned char *>(static_cast<const unsigned char *>(p)) - offsetof(Slot, data));
+   }
+   static void * heapAllocate(size_t size);
+   static void heapFree(void * p) noexcept;
+
+   // the lock, taken only once the pool is shared. Sharing happens
+   // before the trees involved are handed to other threads and is
+   // never undone, so a relaxed look at the flag is enough
+   std::unique_lock <std::mutex> lock() noexcept
+   {
+      if (isShared.load(std::memory_order_relaxed))
+         return std::unique_lock <std::mutex> (mutex);
+      return std::unique_lock <std::mutex> ();
+   }
+
+   void free(Slot * pSlot) noexcept;
+   void addSlab();
+   void freeSlabs() noexcept;
+
+   Slot * pFree;               // recycled slots
+   Slot * pCarve;              // the next slot never handed out
+   Slot * pCarveEnd;           // the end of the slab it is in
+   Slab * pSlabs;              // most recent slab first
+   size_t numSlabsAllocated;   // slabs currently held
+   size_t numSlotsLive;        // slots currently handed out
+   size_t numSlotsNext;        // slots in the next slab we make
+   size_t numOwners;           // trees that may still allocate from us
+   std::atomic <bool> isShared; // can more than one tree reach our slots?
+   std::mutex mutex;            // guards all of the above once shared
+};
+
+/*********************************************
+ * POOL :: ACQUIRE
+ * One more tree owns the pool, so it is shared from now on
+ ********************************************/
+template <typename T>
+void pool <T> :: acquire() noexcept
+{
+   share();
+   std::unique_lock <std::mutex> guard = lock();
+   numOwners++;
+}
+
+/*********************************************
+ * POOL :: RELEASE
+ * An owner is done with the pool. Slots still handed out keep it
+ * alive until they come back
+ ********************************************/
+template <typename T>
+void pool <T> :: release() noexcept
+{
+   bool isLast;
+   {
+      std::unique_lock <std::mutex> guard = lock();
+      assert(numOwners > 0);
+      isLast = (--numOwners == 0 && numSlotsLive == 0);
+   }
+   if (isLast)
+   {
+      delete this;
+   }
+}
+
+/*********************************************
+ * POOL :: ALLOCATE
+ * Hand out one slot: recycled if possible, else carved from a slab
+ ********************************************/
+template <typename T>
+void * pool <T> :: allocate()
+{
+   std::unique_lock <std::mutex> guard = lock();
+   assert(numOwners > 0);
+
+   Slot * pSlot = pFree;
+   if (pSlot)
+   {
+      pFree = pSlot->pNext;
+   }
+   else
+   {
+      if (pCarve == pCarveEnd)
+      {
+         addSlab();
+      }
+      pSlot = pCarve++;
+   }
+
+   pSlot->pOwner = this;
+   numSlotsLive++;
+   return pSlot->data;
+}
+
+/*********************************************
+ * POOL :: DEALLOCATE
+ * Put a slot back on the free list of its pool
+ ********************************************/
+template <typename T>
+void pool <T> :: deallocate(void * p) noexcept
+{
+   if (p == nullptr)
+   {
+      return;
+   }
+
+   Slot * pSlot = slotOf(p);
+   if (pSlot->pOwner)
+   {
+      pSlot->pOwner->free(pSlot);
+   }
+   else
+   {
+      heapFree(pSlot);
+   }
+}
+
+/*********************************************
+ * POOL :: ALLOCATE UNPOOLED
+ * One slot straight from the heap, which deallocate() sends back there
+ ********************************************/
+template <typename T>
+void * pool <T> :: allocateUnpooled()
+{
+   Slot * pSlot = static_cast<Slot *>(heapAllocate(sizeof(Slot)));
+   pSlot->pOwner = nullptr;
+   return pSlot->data;
+}
+
+/*********************************************
+ * POOL :: TRIM
+ * Give back every slab, but only once no slot is handed out: a slot
+ * does not know which slab it is in, so one slab cannot be told free
+ * while the others are in use
+ ********************************************/
+template <typename T>
+void pool <T> :: trim() noexcept
+{
+   std::unique_lock <std::mutex> guard = lock();
+   if (numSlotsLive == 0)
+   {
+      freeSlabs();
+   }
+}
+
+/*********************************************
+ * POOL :: FREE
+ * The slot is back. If nobody owns the pool any more and this was the
+ * last slot out, the pool goes too
+ ********************************************/
+template <typename T>
+void pool <T> :: free(Slot * pSlot) noexcept
+{
+   bool isLast;
+   {
+      std::unique_lock <std::mutex> guard = lock();
+      pSlot->pNext = pFree;
+      pFree = pSlot;
+
+      assert(numSlotsLive > 0);
+      isLast = (--numSlotsLive == 0 && numOwners == 0);
+   }
+   if (isLast)
+   {
+      delete this;
+   }
+}
+
+/*********************************************
+ * POOL :: ADD SLAB
+ * Make a slab twice the size of the last one, up to the most we want
+ * to ask the heap for at once
+ ********************************************/
+template <typename T>
+void pool <T> :: addSlab()
+{
+   Slab * pSlab = static_cast<Slab *>(heapAllocate(slotsOffset() + numSlotsNext * sizeof(Slot)));
+   pSlab->pNext = pSlabs;
+   pSlabs = pSlab;
+   numSlabsAllocated++;
+
+   pCarve = reinterpret_cast<Slot *>(reinterpret_cast<unsigned char *>(pSlab) + slotsOffset());
+   pCarveEnd = pCarve + numSlotsNext;
+   if (numSlotsNext < numSlotsMax())
+   {
+      numSlotsNext = (numSlotsNext * 2 < numSlotsMax()) ? numSlotsNext * 2 : numSlotsMax();
+   }
+}
+
+/*********************************************
+ * POOL :: FREE SLABS
+ * Back to where a new pool starts
+ ********************************************/
+template <typename T>
+void pool <T> :: freeSlabs() noexcept
+{
+   while (pSlabs)
+   {
+      Slab * pSlab = pSlabs;
+      pSlabs = pSlab->pNext;
+      heapFree(pSlab);
+   }
+   pFree = pCarve = pCarveEnd = nullptr;
+   numSlabsAllocated = 0;
+   numSlotsNext = numSlotsFirst;
+}
+
+/*********************************************
+ * POOL :: HEAP ALLOCATE and HEAP FREE
+ * Slots that need more than the usual alignment ask for it
+ ********************************************/
+template <typename T>
+void * pool <T> :: heapAllocate(size_t size)
+{
+   if constexpr (overAligned)
+   {
+      return ::operator new(size, std::align_val_t(alignof(Slot)));
+   }
+   else
+   {
+      return ::operator new(size);
+   }
+}
+
+template <typename T>
+void pool <T> :: heapFree(void * p) noexcept
+{
+   if constexpr (overAligned)
+   {
+      ::operator delete(p, std::align_val_t(alignof(Slot)));
+   }
+   else
+   {
+      ::operator delete(p);
+   }
+}
+
+/*****************************************************************
+ * SHARED POOL
+ * One pool for every container of a type, for nodes that are not
+ * owned by any one of them, such as those shared between versions of
+ * a persistent set. It is locked, and never destroyed so containers
+ * with static storage can still free into it at exit
+ *****************************************************************/
+template <typename T>
+class shared_pool
+{
+public:
+   static shared_pool & instance()
+   {
+      static shared_pool * pInstance = new shared_pool;
+      return *pInstance;
+   }
+
+   void * allocate()
+   {
+      std::lock_guard <std::mutex> guard(mutex);
+      return pSlots->allocate();
+   }
+   void deallocate(void * p) noexcept
+   {
+      std::lock_guard <std::mutex> guard(mutex);
+      pool <T> :: deallocate(p);
+   }
+
+   size_t numSlabs() const noexcept { return pSlots->numSlabs(); }
+   size_t numLive()  const noexcept { return pSlots->numLive();  }
+
+private:
+   shared_pool() : pSlots(pool <T> :: create()), mutex()
+   {
+   }
+
+   pool <T> * pSlots;
+   std::mutex mutex;
+};
+
+} // namespace custom
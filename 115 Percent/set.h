@@ -21,8 +21,20 @@
 #include <cassert>
 #include <iostream>
 #include "bst.h"
-#include <memory>     // for std::allocator
-#include <functional> // for std::less
+#include "frozenSet.h" // for custom::frozen_set
+#include "hashIndex.h" // for custom::HashIndex
+#include "bloomFilter.h" // for custom::BloomFilter
+#include <memory>     // for std::allocator and std::unique_ptr
+#include <algorithm>  // for std::max
+#include <functional> // for std::less and std::reference_wrapper
+#include <vector>     // for std::vector
+#include <type_traits>// for std::conditional and std::is_invocable
+#if __has_include(<compare>)
+#include <compare>    // for operator <=>
+#endif
+#if __has_include(<memory_resource>)
+#include <memory_resource> // for std::pmr::polymorphic_allocator
+#endif
 
 class TestSet;        // forward declaration for unit tests
 
@@ -35,11 +47,30 @@ namespace custom
  * SET
  * A class that represents a Set
  ***********************************************/
-template <typename T>
+template <typename T,
+          typename Compare = std::less<T>,
+          typename Allocator = std::allocator<T>,
+          bool Ranked = false,
+          typename Monoid = void,
+          bool Threaded = false,
+          typename Hash = void,
+          typename FilterHash = typename DefaultFilterHash<T, Compare>::type>
 class set
 {
    friend class ::TestSet; // give unit tests access to the privates
+
+   template <class TT, class CC, class AA, bool RR, class GG, bool HH, class II, class FF>
+   friend set <TT, CC, AA, RR, GG, HH, II, FF> set_union(const set <TT, CC, AA, RR, GG, HH, II, FF> &, const set <TT, CC, AA, RR, GG, HH, II, FF> &);
+   template <class TT, class CC, class AA, bool RR, class GG, bool HH, class II, class FF>
+   friend set <TT, CC, AA, RR, GG, HH, II, FF> set_intersection(const set <TT, CC, AA, RR, GG, HH, II, FF> &, const set <TT, CC, AA, RR, GG, HH, II, FF> &);
+   template <class TT, class CC, class AA, bool RR, class GG, bool HH, class II, class FF>
+   friend set <TT, CC, AA, RR, GG, HH, II, FF> set_difference(const set <TT, CC, AA, RR, GG, HH, II, FF> &, const set <TT, CC, AA, RR, GG, HH, II, FF> &);
+   template <class TT, class CC, class AA, bool RR, class GG, bool HH, class II, class FF>
+   friend set <TT, CC, AA, RR, GG, HH, II, FF> set_symmetric_difference(const set <TT, CC, AA, RR, GG, HH, II, FF> &, const set <TT, CC, AA, RR, GG, HH, II, FF> &);
 public:
+   using key_compare    = Compare;
+   using value_compare  = Compare;
+   using allocator_type = Allocator;
    
    // 
    // Construct
@@ -47,23 +78,40 @@ public:
    set() 
    { 
    }
+   explicit set(const Compare & compare, const Allocator & alloc = Allocator()) : bst(compare, alloc)
+   {
+   }
+   explicit set(const Allocator & alloc) : bst(alloc)
+   {
+   }
    set(const set &  rhs)
    {
        this->bst = rhs.bst;
+       if (rhs.pFilter)
+          pFilter = std::make_unique <Filter> (*rhs.pFilter);
+       reindex();
    }
    set(set && rhs) 
    {
        this ->bst = std::move(rhs.bst);
+       index.swap(rhs.index);
+       pFilter.swap(rhs.pFilter);
    }
    set(const std::initializer_list <T> & il) 
    {
-       this->bst= il;
+       insert(il.begin(), il.end());
    }
    template <class Iterator>
    set(Iterator first, Iterator last) 
    {
-       for(auto p = first; p!= last; ++p)
-          insert(*p);
+       insert(first, last);
+   }
+   // the caller promises [first, last) is sorted without duplicates
+   template <class Iterator>
+   set(sorted_unique_t, Iterator first, Iterator last)
+   {
+       bst.assign(sorted_unique, first, last);
+       reindex();
    }
     ~set() { clear(); }
 
@@ -73,8 +121,12 @@ public:
 
    set & operator = (const set & rhs)
    {
-       clear();
+       // the tree reuses the nodes it has
        this->bst = rhs.bst;
+       pFilter.reset();
+       if (rhs.pFilter)
+          pFilter = std::make_unique <Filter> (*rhs.pFilter);
+       reindex();
        
        return *this;
 
@@ -88,13 +140,14 @@ public:
     set & operator = (const std::initializer_list <T> & il)
     {
        clear();
-       for(auto it = il.begin(); it != il.end(); ++it)
-          insert(*it);
+       insert(il.begin(), il.end());
        return *this;
     }
     void swap(set& rhs) noexcept
     {
         this->bst.swap(rhs.bst);
+        index.swap(rhs.index);
+        pFilter.swap(rhs.pFilter);
     }
 
    //
@@ -102,6 +155,7 @@ public:
    //
 
    class iterator;
+   using const_iterator = iterator;   // elements are never changed in place
    iterator begin() const noexcept 
    { 
       return iterator(bst.begin());
@@ -111,12 +165,167 @@ public:
       return iterator(bst.end());
    }
 
+   // backwards: start at rbegin() and -- until rend()
+   iterator rbegin() const noexcept
+   {
+      return iterator(bst.rbegin());
+   }
+   iterator rend() const noexcept
+   {
+      return iterator(bst.rend());
+   }
+
    //
    // Access
    //
-   iterator find(const T& t) 
+   iterator find(const T& t) const
    { 
-      return iterator(bst.find(t));
+      if (pFilter && !pFilter->mayContain(t))
+         return end();
+      iterator it = index.enabled ?
+         iterator(typename custom::BST <T, Compare, Allocator, Ranked, Monoid, Threaded> :: iterator(index.find(t, bst.compare))) :
+         iterator(bst.find(t));
+      if (pFilter && it == end())
+         pFilter->falsePositive();
+      return it;
+   }
+   iterator lower_bound(const T& t) const
+   {
+      return iterator(bst.lower_bound(t));
+   }
+   iterator upper_bound(const T& t) const
+   {
+      return iterator(bst.upper_bound(t));
+   }
+   std::pair<iterator, iterator> equal_range(const T& t) const
+   {
+      auto p = bst.equal_range(t);
+      return std::pair<iterator, iterator>(iterator(p.first), iterator(p.second));
+   }
+   size_t count(const T& t) const
+   {
+      return contains(t) ? 1 : 0;
+   }
+   bool contains(const T& t) const
+   {
+      return find(t) != end();
+   }
+
+   // the smallest and largest elements in O(1): not for an empty set
+   const T & front() const
+   {
+      return bst.front();
+   }
+   const T & back() const
+   {
+      return bst.back();
+   }
+
+   // with a transparent Compare such as std::less<>, probe with any
+   // key the comparator accepts without building a T first
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   iterator find(const K& k) const
+   {
+      return iterator(bst.find(k));
+   }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   iterator lower_bound(const K& k) const
+   {
+      return iterator(bst.lower_bound(k));
+   }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   iterator upper_bound(const K& k) const
+   {
+      return iterator(bst.upper_bound(k));
+   }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   std::pair<iterator, iterator> equal_range(const K& k) const
+   {
+      auto p = bst.equal_range(k);
+      return std::pair<iterator, iterator>(iterator(p.first), iterator(p.second));
+   }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   size_t count(const K& k) const
+   {
+      return bst.count(k);
+   }
+   template <class K, class CC = Compare, class = typename CC::is_transparent>
+   bool contains(const K& k) const
+   {
+      return bst.contains(k);
+   }
+
+   //
+   // Rank: a Ranked set answers these in O(log n)
+   //
+   iterator nth(size_t k) const
+   {
+      return iterator(bst.nth(k));
+   }
+   size_t rank(const T& t) const
+   {
+      return bst.rank(t);
+   }
+   std::ptrdiff_t distance(const_iterator first, const_iterator last) const
+   {
+      return bst.distance(first.it, last.it);
+   }
+
+   //
+   // Aggregate: a set with a Monoid summarizes [lo, hi) in O(log n)
+   //
+   template <class GG = Monoid>
+   typename GG::value_type aggregate(const T& lo, const T& hi) const
+   {
+      return bst.aggregate(lo, hi);
+   }
+
+   //
+   // Filter: a Bloom filter in front of find(), contains(), count(),
+   // and erase(key), so a lookup for an element that is not there
+   // usually ends after one cache line instead of a walk down the tree
+   //
+
+   // sized for numExpected elements and hashed with FilterHash: at 12
+   // bits each, about 1 lookup in 250 for an element that is not there
+   // gets past the filter. Elements Compare treats as equal must hash
+   // equal, so only std::less gets std::hash without asking. A set
+   // with no FilterHash has no hash to take, hence the template
+   template <class FH = FilterHash>
+   void attach_filter(size_t numExpected, size_t bitsPerElement = 12, const FH & hash = FH())
+   {
+      static_assert(std::is_same <FH, FilterHash>::value && Filter::enabled,
+                    "attach_filter() needs a FilterHash that can hash T the way Compare orders it");
+      pFilter = std::make_unique <Filter> (std::max(numExpected, size()), bitsPerElement, hash);
+      rebuild_filter();
+   }
+   void detach_filter() noexcept
+   {
+      pFilter.reset();
+   }
+   // erased elements leave their bits behind: start again from what is
+   // in the set now, and count the stats from zero
+   void rebuild_filter()
+   {
+      if (!pFilter)
+         return;
+      pFilter->clear();
+      pFilter->resetStats();
+      for (auto it = bst.begin(); it != bst.end(); ++it)
+         pFilter->insert(*it);
+   }
+   // lookups are only counted once asked for. Counting makes readers
+   // on different threads write to the same memory
+   void keep_filter_stats(bool keep = true) noexcept
+   {
+      if (pFilter)
+         pFilter->keepStats(keep);
+   }
+   BloomFilterStats filter_stats() const noexcept
+   {
+      if (!pFilter)
+         return BloomFilterStats { 0, 0, 0, 0, 0 };
+      return pFilter->getStats(size());
    }
 
    //
@@ -130,6 +339,34 @@ public:
    { 
       return bst.size();
    }
+   allocator_type get_allocator() const noexcept
+   {
+      return bst.get_allocator();
+   }
+   key_compare key_comp() const
+   {
+      return bst.key_comp();
+   }
+   value_compare value_comp() const
+   {
+      return bst.key_comp();
+   }
+   // what the hash index of a set with a Hash costs on top of the tree
+   size_t index_bytes() const noexcept
+   {
+      return index.bytes();
+   }
+
+   //
+   // Freeze
+   //
+
+   // an immutable copy laid out for fast lookups, built in O(n) from
+   // the in-order walk. The set is left as it was
+   frozen_set <T, Compare> freeze() const
+   {
+      return frozen_set <T, Compare> (begin(), size(), key_comp());
+   }
 
    //
    // Insert
@@ -138,6 +375,8 @@ public:
    {
       std::pair<iterator, bool> p(iterator(), true);
       p = bst.insert(t,true);
+      if (p.second)
+         added(p.first.it.pNode);
        
       return std::pair<iterator, bool>(iterator(p.first), p.second);
    }
@@ -145,19 +384,60 @@ public:
    {
       std::pair<iterator, bool> p(iterator(), true);
       p = bst.insert(std::move(t), true);
+      if (p.second)
+         added(p.first.it.pNode);
       
       return std::pair<iterator, bool>(iterator(p.first), p.second);
    }
+   template <class ... Args>
+   std::pair<iterator, bool> emplace(Args && ... args)
+   {
+      auto p = bst.emplace(true, std::forward<Args>(args)...);
+      if (p.second)
+         added(p.first.pNode);
+      return std::pair<iterator, bool>(iterator(p.first), p.second);
+   }
+   template <class ... Args>
+   iterator emplace_hint(const_iterator hint, Args && ... args)
+   {
+      auto p = bst.emplace_hint(hint.it, true, std::forward<Args>(args)...);
+      if (p.second)
+         added(p.first.pNode);
+      return iterator(p.first);
+   }
+
+   // insert right before hint. Nearly free when hint is where t goes,
+   // or is the element just before it, as with ascending keys
+   iterator insert(const_iterator hint, const T& t)
+   {
+      auto p = bst.insert(hint.it, t, true);
+      if (p.second)
+         added(p.first.pNode);
+      return iterator(p.first);
+   }
+   iterator insert(const_iterator hint, T&& t)
+   {
+      auto p = bst.insert(hint.it, std::move(t), true);
+      if (p.second)
+         added(p.first.pNode);
+      return iterator(p.first);
+   }
    void insert(const std::initializer_list <T>& il)
    {
-      for(auto p = il.begin(); p!= il.end(); ++p)
-         insert(*p);
+      insert(il.begin(), il.end());
    }
+   // an empty set built from a sorted range is built in O(n)
    template <class Iterator>
    void insert(Iterator first, Iterator last)
    {
-      for(auto p = first; p!= last; ++p)
-         insert(*p);
+      if ((index.enabled || pFilter) && !empty())
+      {
+         for (; first != last; ++first)
+            insert(*first);
+         return;
+      }
+      bst.insert(first, last, true /*keepUnique*/);
+      reindex();
    }
 
 
@@ -167,9 +447,32 @@ public:
    void clear() noexcept 
    {
       bst.clear();
+      index.clear();
+      if (pFilter)
+         pFilter->clear();
+   }
+   // give back the memory clear() keeps for the next inserts
+   void trim() noexcept
+   {
+      bst.trim();
+   }
+   // remove the smallest or largest element: amortized O(1)
+   void pop_front() noexcept
+   {
+      if (!empty())
+         index.erase(bst.begin().pNode);
+      bst.pop_front();
+   }
+   void pop_back() noexcept
+   {
+      if (!empty())
+         index.erase(bst.rbegin().pNode);
+      bst.pop_back();
    }
    iterator erase(iterator &it)
    { 
+      if (it != end())
+         index.erase(it.it.pNode);
       return iterator(bst.erase(it.it));
    }
    size_t erase(const T & t) 
@@ -181,18 +484,100 @@ public:
       return 1;
 
    }
+   // a long range is cut out whole rather than one node at a time
    iterator erase(iterator &itBegin, iterator &itEnd)
    {
-      while(itBegin != itEnd)
-         itBegin = erase(itBegin);
-      
-      return itEnd;
-
+      unindex(itBegin.it, itEnd.it);
+      return iterator(bst.erase(itBegin.it, itEnd.it));
+   }
+   // remove every element in [lo, hi), returning how many there were
+   size_t erase_range(const T & lo, const T & hi)
+   {
+      if (!bst.compare(lo, hi))
+         return 0;
+      size_t num = size();
+      auto itBegin = bst.lower_bound(lo);
+      auto itEnd   = bst.lower_bound(hi);
+      unindex(itBegin, itEnd);
+      bst.erase(itBegin, itEnd);
+      return num - size();
    }
 
+   //
+   // Set algebra, in place
+   //
+   void merge (const set & rhs);
+   void retain(const set & rhs);
+
 private:
+
+   using BNode = typename custom::BST <T, Compare, Allocator, Ranked, Monoid, Threaded> :: BNode;
+
+   // no FilterHash, or one that cannot hash T, as std::hash of a class
+   // it does not know, gets the filter that is never there
+   using Filter = BloomFilter <T, typename std::conditional <
+      std::is_invocable <std::add_lvalue_reference_t <const FilterHash>, const T &>::value,
+      FilterHash, void>::type>;
+   using Refs  = std::vector <std::reference_wrapper <const T>>;
+
+   // build a set shaped like this one from references in sorted order
+   set fromSorted(const Refs & refs) const
+   {
+      set s(bst.compare, get_allocator());
+      s.bst.assign(sorted_unique, refs.begin(), refs.end());
+      s.reindex();
+      return s;
+   }
+
+   // a node just went into the tree
+   void added(BNode * pNode)
+   {
+      index.insert(pNode);
+      if (pFilter)
+         pFilter->insert(pNode->data);
+   }
+
+   // put every node back in the hash index and the filter, after the
+   // tree was copied or built in one go: a copy reuses the nodes it
+   // already had
+   void reindex()
+   {
+      if (!index.enabled && !pFilter)
+         return;
+      index.clear();
+      index.reserve(size());
+      if (pFilter)
+         pFilter->clear();
+      for (auto it = bst.begin(); it != bst.end(); ++it)
+         added(it.pNode);
+   }
+
+   // take [first, last) out of the hash index before it leaves the tree
+   template <class TreeIterator>
+   void unindex(TreeIterator first, TreeIterator last)
+   {
+      if (!index.enabled)
+         return;
+      for (; first != last; ++first)
+         index.erase(first.pNode);
+   }
+
+   // the first node, and the first node not less than t at or after pFrom
+   BNode * firstNode() const
+   {
+      return bst.begin().pNode;
+   }
+   BNode * lowerBoundFrom(BNode * pFrom, const T & t) const
+   {
+      return bst.lowerBoundFrom(pFrom, t);
+   }
+
+   // below this ratio of sizes, probing the larger set beats walking it
+   static constexpr size_t probeRatio = 16;
    
-   custom::BST <T> bst;
+   custom::BST <T, Compare, Allocator, Ranked, Monoid, Threaded> bst;
+   HashIndex <T, BNode, Compare, Hash> index;   // empty unless there is a Hash
+   std::unique_ptr <Filter> pFilter;             // null unless attach_filter()
 };
 
 
@@ -200,18 +585,18 @@ private:
  * SET ITERATOR
  * An iterator through Set
  *************************************************/
-template <typename T>
-class set <T> :: iterator
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+class set <T, C, A, R, G, H, I, F> :: iterator
 {
    friend class ::TestSet; // give unit tests access to the privates
-   friend class custom::set<T>;
+   friend class custom::set<T, C, A, R, G, H, I, F>;
 public:
    // constructors, destructors, and assignment operator
    iterator() 
    {
       it = nullptr;
    }
-   iterator(const typename custom::BST<T>::iterator& itRHS) 
+   iterator(const typename custom::BST<T, C, A, R, G, H>::iterator& itRHS) 
    {
       this->it = itRHS;
    }
@@ -273,40 +658,399 @@ public:
    }
 private:
 
-   typename custom::BST<T>::iterator it;
+   typename custom::BST<T, C, A, R, G, H>::iterator it;
 };
 
 /***********************************************
  * SET : EQUIVALENCE
- * See if two sets are the same size
+ * See if two sets hold the same elements. Sets of different sizes
+ * are rejected without looking at an element. Otherwise both are
+ * walked in lockstep until the first pair that differs
  ***********************************************/
-template <typename T>
-bool operator == (const set <T> & lhs, const set <T> & rhs)
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+bool operator == (const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
 {
+   if (lhs.size() != rhs.size())
+   {
+      return false;
+   }
+
+   for (auto itLHS = lhs.begin(), itRHS = rhs.begin(); itLHS != lhs.end(); ++itLHS, ++itRHS)
+   {
+      if (!(*itLHS == *itRHS))
+      {
+         return false;
+      }
+   }
    return true;
 }
 
-template <typename T>
-inline bool operator != (const set <T> & lhs, const set <T> & rhs)
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+inline bool operator != (const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
 {
-   return true;
+   return !(lhs == rhs);
 }
 
 /***********************************************
  * SET : RELATIVE COMPARISON
- * See if one set is lexicographically before the second
+ * See if one set is lexicographically before the second: the first
+ * pair of elements that differs decides, else the shorter set is first
  ***********************************************/
-template <typename T>
-bool operator < (const set <T> & lhs, const set <T> & rhs)
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+bool operator < (const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
 {
-   return true;
+   auto itLHS = lhs.begin();
+   auto itRHS = rhs.begin();
+   for (; itLHS != lhs.end() && itRHS != rhs.end(); ++itLHS, ++itRHS)
+   {
+      if (*itLHS < *itRHS)
+      {
+         return true;
+      }
+      if (*itRHS < *itLHS)
+      {
+         return false;
+      }
+   }
+   return itLHS == lhs.end() && itRHS != rhs.end();
 }
 
-template <typename T>
-inline bool operator > (const set <T> & lhs, const set <T> & rhs)
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+inline bool operator > (const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
 {
-   return true;
+   return rhs < lhs;
+}
+
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+inline bool operator <= (const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
+{
+   return !(rhs < lhs);
+}
+
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+inline bool operator >= (const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
+{
+   return !(lhs < rhs);
+}
+
+#if __cpp_impl_three_way_comparison >= 201907L && __has_include(<compare>)
+/***********************************************
+ * SET : THREE-WAY COMPARISON
+ * The same lexicographic order in one pass. Elements without <=>
+ * of their own are ordered with <
+ ***********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+auto operator <=> (const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
+{
+   auto itLHS = lhs.begin();
+   auto itRHS = rhs.begin();
+   if constexpr (std::three_way_comparable<T>)
+   {
+      for (; itLHS != lhs.end() && itRHS != rhs.end(); ++itLHS, ++itRHS)
+      {
+         auto order = *itLHS <=> *itRHS;
+         if (order != 0)
+         {
+            return order;
+         }
+      }
+      return std::compare_three_way_result_t<T>(lhs.size() <=> rhs.size());
+   }
+   else
+   {
+      for (; itLHS != lhs.end() && itRHS != rhs.end(); ++itLHS, ++itRHS)
+      {
+         if (*itLHS < *itRHS)
+         {
+            return std::weak_ordering::less;
+         }
+         if (*itRHS < *itLHS)
+         {
+            return std::weak_ordering::greater;
+         }
+      }
+      return std::weak_ordering(lhs.size() <=> rhs.size());
+   }
+}
+#endif
+
+/***********************************************
+ * SET : MERGE
+ * Add every element of rhs to this set. The elements of rhs come in
+ * order, so each one is looked for starting from where the last one
+ * landed and then inserted right there with a hint
+ ***********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+void set <T, C, A, R, G, H, I, F> :: merge(const set & rhs)
+{
+   if (this == &rhs)
+   {
+      return;
+   }
+
+   BNode * pBound = bst.begin().pNode;
+   for (auto it = rhs.bst.begin(); it != rhs.bst.end(); ++it)
+   {
+      pBound = bst.lowerBoundFrom(pBound, *it);
+      if (pBound == nullptr || bst.compare(*it, pBound->data))
+      {
+         auto p = bst.insert(typename BST <T, C, A, R, G, H> :: iterator(pBound), *it, true);
+         added(p.first.pNode);
+      }
+   }
+}
+
+/***********************************************
+ * SET : RETAIN
+ * Remove every element that is not also in rhs, looking each one up
+ * in rhs from where the last one was found
+ ***********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+void set <T, C, A, R, G, H, I, F> :: retain(const set & rhs)
+{
+   if (this == &rhs)
+   {
+      return;
+   }
+
+   BNode * pBound = rhs.firstNode();
+   auto it = bst.begin();
+   while (it != bst.end())
+   {
+      pBound = rhs.lowerBoundFrom(pBound, *it);
+      if (pBound == nullptr || bst.compare(*it, pBound->data))
+      {
+         index.erase(it.pNode);
+         it = bst.erase(it);
+      }
+      else
+      {
+         ++it;
+      }
+   }
+}
+
+/***********************************************
+ * SET : UNION
+ * Every element in either set. One merge walk over both
+ ***********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+set <T, C, A, R, G, H, I, F> set_union(const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
+{
+   C compare = lhs.key_comp();
+   typename set <T, C, A, R, G, H, I, F> :: Refs refs;
+   refs.reserve(lhs.size() + rhs.size());
+
+   auto itLHS = lhs.bst.begin();
+   auto itRHS = rhs.bst.begin();
+   while (itLHS != lhs.bst.end() && itRHS != rhs.bst.end())
+   {
+      if (compare(*itLHS, *itRHS))
+      {
+         refs.push_back(std::cref(*itLHS++));
+      }
+      else if (compare(*itRHS, *itLHS))
+      {
+         refs.push_back(std::cref(*itRHS++));
+      }
+      else
+      {
+         refs.push_back(std::cref(*itLHS++));
+         ++itRHS;
+      }
+   }
+   for (; itLHS != lhs.bst.end(); ++itLHS)
+   {
+      refs.push_back(std::cref(*itLHS));
+   }
+   for (; itRHS != rhs.bst.end(); ++itRHS)
+   {
+      refs.push_back(std::cref(*itRHS));
+   }
+
+   return lhs.fromSorted(refs);
+}
+
+/***********************************************
+ * SET : INTERSECTION
+ * Every element of lhs also in rhs. Sets of similar size are merge
+ * walked. When one is much smaller, each of its elements is looked
+ * up in the larger one from where the last was found instead: that
+ * is O(m log(n/m + 1)) rather than O(m + n)
+ ***********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+set <T, C, A, R, G, H, I, F> set_intersection(const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
+{
+   using BNode = typename set <T, C, A, R, G, H, I, F> :: BNode;
+   C compare = lhs.key_comp();
+   typename set <T, C, A, R, G, H, I, F> :: Refs refs;
+
+   bool lhsSmaller = lhs.size() <= rhs.size();
+   const set <T, C, A, R, G, H, I, F> & small = lhsSmaller ? lhs : rhs;
+   const set <T, C, A, R, G, H, I, F> & large = lhsSmaller ? rhs : lhs;
+   refs.reserve(small.size());
+
+   if (small.size() * set <T, C, A, R, G, H, I, F> :: probeRatio < large.size())
+   {
+      BNode * pBound = large.firstNode();
+      for (auto it = small.bst.begin(); it != small.bst.end() && pBound; ++it)
+      {
+         pBound = large.lowerBoundFrom(pBound, *it);
+         if (pBound && !compare(*it, pBound->data))
+         {
+            refs.push_back(std::cref(lhsSmaller ? *it : pBound->data));
+         }
+      }
+   }
+   else
+   {
+      auto itLHS = lhs.bst.begin();
+      auto itRHS = rhs.bst.begin();
+      while (itLHS != lhs.bst.end() && itRHS != rhs.bst.end())
+      {
+         if (compare(*itLHS, *itRHS))
+         {
+            ++itLHS;
+         }
+         else if (compare(*itRHS, *itLHS))
+         {
+            ++itRHS;
+         }
+         else
+         {
+            refs.push_back(std::cref(*itLHS++));
+            ++itRHS;
+         }
+      }
+   }
+
+   return lhs.fromSorted(refs);
+}
+
+/***********************************************
+ * SET : DIFFERENCE
+ * Every element of lhs not in rhs. When lhs is much smaller its
+ * elements are looked up in rhs, otherwise both are merge walked
+ ***********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+set <T, C, A, R, G, H, I, F> set_difference(const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
+{
+   using BNode = typename set <T, C, A, R, G, H, I, F> :: BNode;
+   C compare = lhs.key_comp();
+   typename set <T, C, A, R, G, H, I, F> :: Refs refs;
+   refs.reserve(lhs.size());
+
+   if (lhs.size() * set <T, C, A, R, G, H, I, F> :: probeRatio < rhs.size())
+   {
+      BNode * pBound = rhs.firstNode();
+      for (auto it = lhs.bst.begin(); it != lhs.bst.end(); ++it)
+      {
+         pBound = rhs.lowerBoundFrom(pBound, *it);
+         if (pBound == nullptr || compare(*it, pBound->data))
+         {
+            refs.push_back(std::cref(*it));
+         }
+      }
+   }
+   else
+   {
+      auto itLHS = lhs.bst.begin();
+      auto itRHS = rhs.bst.begin();
+      while (itLHS != lhs.bst.end() && itRHS != rhs.bst.end())
+      {
+         if (compare(*itLHS, *itRHS))
+         {
+            refs.push_back(std::cref(*itLHS++));
+         }
+         else if (compare(*itRHS, *itLHS))
+         {
+            ++itRHS;
+         }
+         else
+         {
+            ++itLHS;
+            ++itRHS;
+         }
+      }
+      for (; itLHS != lhs.bst.end(); ++itLHS)
+      {
+         refs.push_back(std::cref(*itLHS));
+      }
+   }
+
+   return lhs.fromSorted(refs);
+}
+
+/***********************************************
+ * SET : SYMMETRIC DIFFERENCE
+ * Every element in exactly one of the sets. One merge walk
+ ***********************************************/
+template <typename T, typename C, typename A, bool R, typename G, bool H, typename I, typename F>
+set <T, C, A, R, G, H, I, F> set_symmetric_difference(const set <T, C, A, R, G, H, I, F> & lhs, const set <T, C, A, R, G, H, I, F> & rhs)
+{
+   C compare = lhs.key_comp();
+   typename set <T, C, A, R, G, H, I, F> :: Refs refs;
+   refs.reserve(lhs.size() + rhs.size());
+
+   auto itLHS = lhs.bst.begin();
+   auto itRHS = rhs.bst.begin();
+   while (itLHS != lhs.bst.end() && itRHS != rhs.bst.end())
+   {
+      if (compare(*itLHS, *itRHS))
+      {
+         refs.push_back(std::cref(*itLHS++));
+      }
+      else if (compare(*itRHS, *itLHS))
+      {
+         refs.push_back(std::cref(*itRHS++));
+      }
+      else
+      {
+         ++itLHS;
+         ++itRHS;
+      }
+   }
+   for (; itLHS != lhs.bst.end(); ++itLHS)
+   {
+      refs.push_back(std::cref(*itLHS));
+   }
+   for (; itRHS != rhs.bst.end(); ++itRHS)
+   {
+      refs.push_back(std::cref(*itRHS));
+   }
+
+   return lhs.fromSorted(refs);
+}
+
+// a set that also knows the position of every element: nth(), rank(),
+// and distance() in O(log n) for one more size_t in each node
+template <typename T, typename Compare = std::less<T>>
+using ranked_set = set <T, Compare, std::allocator<T>, true>;
+
+// a set that can summarize any range of keys with Monoid, such as
+// custom::sum_of<T>, in O(log n) for one more value in each node
+template <typename T, typename Monoid, typename Compare = std::less<T>>
+using aggregate_set = set <T, Compare, std::allocator<T>, false, Monoid>;
+
+// a set whose nodes are also linked in order, so ++ and -- are one
+// pointer each and scans walk a list, for two more pointers in each node
+template <typename T, typename Compare = std::less<T>>
+using threaded_set = set <T, Compare, std::allocator<T>, false, void, true>;
+
+// a set that also keeps a hash table from each element to its node,
+// so find(), contains(), and count() skip the descent: O(1) on average
+// for about two more pointers per element. Still iterates in order
+template <typename T, typename Hash = std::hash<T>, typename Compare = std::less<T>>
+using hashed_set = set <T, Compare, std::allocator<T>, false, void, false, Hash>;
+
+#if __has_include(<memory_resource>)
+namespace pmr
+{
+   // a set whose nodes come from a std::pmr::memory_resource
+   template <typename T, typename Compare = std::less<T>>
+   using set = custom::set <T, Compare, std::pmr::polymorphic_allocator<T>>;
 }
+#endif
 
 }; // namespace custom
 
@@ -19,7 +19,9 @@
 #include <memory>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <functional> // for std::less and std::greater
+#include <thread>     // for std::thread
 
  /***********************************************
   * TEST BST
@@ -77,6 +79,13 @@ public:
       test_find_standardBegin();
       test_find_standardLast();
       test_find_standardMissing();
+      test_find_comparisonsPerLevel();
+      test_equalRange_duplicates();
+      test_count_duplicates();
+      test_insert_comparisonsPerLevel();
+      test_insertHint_ascendingEnd();
+      test_insertHint_ascendingPrevious();
+      test_insertHint_wrongHint();
 
       // Insert
       test_insert_oneLeft();
@@ -87,6 +96,8 @@ public:
       test_insertMove_oneRight();
       test_insertMove_duplicate();
       test_insertMove_keepUnique();
+      test_insertRange_sortedBalanced();
+      test_insertRange_sortedPartialLevel();
       test_insert_case1();
       test_insert_case2();
       test_insert_case3();
@@ -105,15 +116,60 @@ public:
       test_erase_noChildren();
       test_erase_oneChild();
       test_erase_twoChildren();
+      test_erase_blackLeafRotate();
+      test_erase_blackLeafRecolor();
+      test_erase_manyBalanced();
+      test_eraseRange_long();
+      test_eraseRange_duplicates();
       test_clear_empty();
       test_clear_standard();
 
+      // Split and join
+      test_split_standard();
+      test_split_many();
+      test_split_counted();
+      test_join_many();
+      test_joinKey_unevenHeights();
+
+      // Rank
+      test_nth_many();
+      test_rank_many();
+      test_distance_afterErase();
+      test_rank_splitJoin();
+
+      // Aggregate
+      test_aggregate_sum();
+      test_aggregate_inOrder();
+      test_aggregate_splitJoin();
+
+      // Ends
+      test_rbegin_standard();
+      test_frontBack_standard();
+      test_ends_insertErase();
+      test_ends_splitJoin();
+      test_popFront_many();
+      test_popBack_many();
+
+      // Threaded
+      test_threaded_insertErase();
+      test_threaded_copy();
+      test_threaded_splitJoin();
+
       // Status
       test_empty_empty();
       test_empty_standard();
       test_size_empty();
       test_size_standard();
 
+      // Pool
+      test_pool_recycle();
+      test_pool_perTree();
+      test_pool_clearKeepsTrimReleases();
+      test_pool_trimNotEmpty();
+      test_pool_joinKeepsBoth();
+      test_pool_splitShares();
+      test_pool_splitThreads();
+
       report("BST");
    }
    
@@ -170,6 +226,7 @@ public:
       p50->isRed = false;
       bstSrc.root = p50;
       bstSrc.numElements = 1;
+      bstSrc.resetEnds();
       Spy::reset();
       // exercise
       custom::BST <Spy> bstDest(bstSrc);
@@ -293,6 +350,7 @@ public:
       p50->isRed = false;
       bstSrc.root = p50;
       bstSrc.numElements = 1;
+      bstSrc.resetEnds();
       Spy::reset();
       // exercise
       custom::BST <Spy> bstDest(std::move(bstSrc));
@@ -591,6 +649,7 @@ public:
       p99->isRed = false;
       bstDest.root = p99;
       bstDest.numElements = 1;
+      bstDest.resetEnds();
       Spy::reset();
       // exercise
       bstDest = bstSrc;
@@ -633,6 +692,7 @@ public:
       p99->isRed = false;
       bstSrc.root = p99;
       bstSrc.numElements = 1;
+      bstSrc.resetEnds();
       //                (50b) = bstSrc
       //          +-------+-------+
       //        (30b)           (70b)
@@ -837,6 +897,7 @@ public:
       p99->isRed = false;
       bstDest.root = p99;
       bstDest.numElements = 1;
+      bstDest.resetEnds();
       Spy::reset();
       // exercise
       bstDest = std::move(bstSrc);
@@ -872,6 +933,7 @@ public:
       p99->isRed = false;
       bstSrc.root = p99;
       bstSrc.numElements = 1;
+      bstSrc.resetEnds();
       //                (50b) = bstDest
       //          +-------+-------+
       //        (30b)           (70b)
@@ -1573,8 +1635,8 @@ public:
       // exercise
       it = bst.find(s);
       // verify
-      assertUnit(Spy::numEquals() == 3);      // check [50][30][20]
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][30]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][30][20], confirm [20]
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -1616,8 +1678,8 @@ public:
       // exercise
       it = bst.find(s);
       // verify
-      assertUnit(Spy::numEquals() == 3);      // check [50][70][80]
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][70][80], confirm [80]
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -1659,8 +1721,8 @@ public:
       // exercise
       it = bst.find(s);
       // verify
-      assertUnit(Spy::numEquals() == 3);      // check [50][30][40]
-      assertUnit(Spy::numLessthan() == 3);    // compare [50][30][40]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][30][40], confirm [40]
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -1676,7 +1738,225 @@ public:
       teardownStandardFixture(bst);
    }
 
+   // every lookup costs at most one comparison per level plus the confirm
+   void test_find_comparisonsPerLevel()
+   {  // setup
+      custom::BST <Spy> bst;
+      for (int i = 0; i < 500; i++)
+         bst.insert(Spy(i * 2));
+      int height = findHeight(bst.root);
+      // exercise
+      for (int i = -1; i <= 1000; i++)
+      {
+         Spy s(i);
+         Spy::reset();
+         auto it = bst.find(s);
+         // verify
+         assertUnit(Spy::numLessthan() + Spy::numEquals() <= height + 1);
+         assertUnit((it != bst.end()) == (i >= 0 && i < 1000 && i % 2 == 0));
+      }
+   }  // teardown
+
+   // without keepUnique a key can repeat: equal_range spans every copy
+   void test_equalRange_duplicates()
+   {  // setup
+      custom::BST <int> bst;
+      for (int i = 0; i < 100; i++)
+         bst.insert(i % 10);
+      // exercise
+      auto range = bst.equal_range(4);
+      // verify
+      int num = 0;
+      for (auto it = range.first; it != range.second; ++it, num++)
+         assertUnit(*it == 4);
+      assertUnit(num == 10);
+      assertUnit(range.first == bst.lower_bound(4));
+      assertUnit(range.second == bst.upper_bound(4));
+      assertUnit(range.second != bst.end() && *range.second == 5);
+   }  // teardown
+
+   // count agrees with equal_range, ranked or not
+   void test_count_duplicates()
+   {  // setup
+      custom::BST <int> bst;
+      custom::BST <int, std::less<int>, std::allocator<int>, true /*Ranked*/> bstRanked;
+      for (int i = 0; i < 100; i++)
+      {
+         bst.insert(i % 10 + i % 3);
+         bstRanked.insert(i % 10 + i % 3);
+      }
+      // exercise and verify
+      for (int key = -1; key <= 12; key++)
+      {
+         auto range = bst.equal_range(key);
+         size_t num = 0;
+         for (auto it = range.first; it != range.second; ++it)
+            num++;
+         assertUnit(bst.count(key) == num);
+         assertUnit(bstRanked.count(key) == num);
+      }
+      assertUnit(bst.count(4) > 1);
+      assertUnit(bst.count(-1) == 0);
+   }  // teardown
+
+   // a unique insert also costs one comparison per level plus the confirm
+   void test_insert_comparisonsPerLevel()
+   {  // setup
+      custom::BST <Spy> bst;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+      {
+         Spy s((i * 7919) % 1000);
+         int height = findHeight(bst.root);
+         Spy::reset();
+         bst.insert(s, true /*keepUnique*/);
+         // verify
+         assertUnit(Spy::numLessthan() + Spy::numEquals() <= height + 1);
+      }
+      assertUnit(bst.size() == 1000);
+   }  // teardown
+
+
+
+   /***************************************
+    * Insert a range
+    *    BST::insert(Iterator, Iterator)
+    ***************************************/
+
+   // a sorted range builds a tree of minimal height
+   void test_insertRange_sortedBalanced()
+   {  // setup
+      custom::BST <int> bst;
+      int values[1023];
+      for (int i = 0; i < 1023; i++)
+         values[i] = i;
+      // exercise
+      bst.insert(values, values + 1023, true);
+      // verify
+      assertUnit(bst.size() == 1023);
+      assertUnit(bst.root != nullptr);
+      if (bst.root)
+      {
+         assertUnit(bst.root->computeSize() == 1023);
+         assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+         assertUnit(findHeight(bst.root) == 10);  // log2(1023 + 1)
+      }
+      int expected = 0;
+      for (auto it = bst.begin(); it != bst.end(); ++it, expected++)
+         assertUnit(*it == expected);
+      assertUnit(expected == 1023);
+   }  // teardown
+
+   // only the partly filled bottom level is red
+   void test_insertRange_sortedPartialLevel()
+   {  // setup
+      //               (30b)
+      //          +------+------+
+      //        (10b)         (50b)
+      //          +----+    +----+----+
+      //              (20r)(40r)     (60r)
+      custom::BST <int> bst;
+      int values[] = { 10, 20, 30, 40, 50, 60 };
+      // exercise
+      bst.insert(values, values + 6, true);
+      // verify
+      assertUnit(bst.size() == 6);
+      assertUnit(bst.root != nullptr);
+      if (bst.root && bst.root->pLeft && bst.root->pRight)
+      {
+         assertUnit(bst.root->data == 30 && !bst.root->isRed);
+         assertUnit(bst.root->pLeft->data == 10 && !bst.root->pLeft->isRed);
+         assertUnit(bst.root->pRight->data == 50 && !bst.root->pRight->isRed);
+         assertUnit(bst.root->pLeft->pLeft == nullptr);
+         assertUnit(bst.root->pLeft->pRight && bst.root->pLeft->pRight->isRed);
+         assertUnit(bst.root->pRight->pLeft && bst.root->pRight->pLeft->isRed);
+         assertUnit(bst.root->pRight->pRight && bst.root->pRight->pRight->isRed);
+         assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      }
+   }  // teardown
+
+   /***************************************
+    * Insert with a hint
+    *    BST::insert(iterator, const T &)
+    ***************************************/
 
+   // ascending keys hinted at end() cost one comparison each
+   void test_insertHint_ascendingEnd()
+   {  // setup
+      custom::BST <Spy> bst;
+      Spy::reset();
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         bst.insert(bst.end(), Spy(i), true);
+      // verify
+      assertUnit(Spy::numLessthan() == 999);  // compare with the largest, none for the first
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(bst.size() == 1000);
+      assertUnit(bst.root != nullptr);
+      if (bst.root)
+      {
+         assertUnit(bst.root->computeSize() == 1000);
+         assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      }
+      int expected = 0;
+      for (auto it = bst.begin(); it != bst.end(); ++it, expected++)
+         assertUnit(*it == Spy(expected));
+   }  // teardown
+
+   // ascending keys hinted at the previous insert cost two comparisons each
+   void test_insertHint_ascendingPrevious()
+   {  // setup
+      custom::BST <Spy> bst;
+      custom::BST <Spy> ::iterator it = bst.end();
+      Spy::reset();
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         it = bst.insert(it, Spy(i), true).first;
+      // verify
+      assertUnit(Spy::numLessthan() == 2 * 999); // compare with the hint, then not less than it
+      assertUnit(Spy::numEquals() == 0);         // Compare only uses operator<
+      assertUnit(bst.size() == 1000);
+      assertUnit(bst.root != nullptr);
+      if (bst.root)
+      {
+         assertUnit(bst.root->computeSize() == 1000);
+         assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      }
+      int expected = 0;
+      for (auto it = bst.begin(); it != bst.end(); ++it, expected++)
+         assertUnit(*it == Spy(expected));
+   }  // teardown
+
+   // a hint in the wrong place still puts the element where it belongs
+   void test_insertHint_wrongHint()
+   {  // setup
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+     +----+----+
+      //    20        40    60        80  
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      custom::BST <Spy> ::iterator itHint = bst.begin();
+      Spy s(65);
+      // exercise
+      auto pairBST = bst.insert(itHint, s, true);
+      // verify
+      assertUnit(pairBST.second == true);
+      assertUnit(pairBST.first != bst.end());
+      if (pairBST.first != bst.end())
+         assertUnit(*pairBST.first == Spy(65));
+      assertUnit(bst.numElements == 8);
+      assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      int expected[] = { 20, 30, 40, 50, 60, 65, 70, 80 };
+      int i = 0;
+      for (auto it = bst.begin(); it != bst.end() && i < 8; ++it, i++)
+         assertUnit(*it == Spy(expected[i]));
+      assertUnit(i == 8);
+      // teardown
+      bst.clear();
+   }
 
    /***************************************
     * Insert
@@ -1692,6 +1972,7 @@ public:
       p50->isRed = false;
       bst.root = p50;
       bst.numElements = 1;
+      bst.resetEnds();
       Spy s(60);
       Spy::reset();
       // exercise
@@ -1754,6 +2035,7 @@ public:
       p50->isRed = false;
       bst.root = p50;
       bst.numElements = 1;
+      bst.resetEnds();
       Spy s(40);
       Spy::reset();
       // exercise
@@ -1819,6 +2101,7 @@ public:
       p50->isRed = false;
       bst.root = p50;
       bst.numElements = 1;
+      bst.resetEnds();
       Spy s(50);
       Spy::reset();
       // exercise
@@ -1889,8 +2172,8 @@ public:
       // exercise
       auto pairBST = bst.insert(s, true /* keepUnique */);
       // verify
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][30]
-      assertUnit(Spy::numEquals() == 3);      // compare [50][30][40]
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][30][40], confirm [40]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numAlloc() == 0);
       assertUnit(Spy::numDestructor() == 0);
@@ -1929,6 +2212,7 @@ public:
       p50->isRed = false;
       bst.root = p50;
       bst.numElements = 1;
+      bst.resetEnds();
       Spy s(60);
       Spy::reset();
       // exercise
@@ -1991,6 +2275,7 @@ public:
       p50->isRed = false;
       bst.root = p50;
       bst.numElements = 1;
+      bst.resetEnds();
       Spy s(40);
       Spy::reset();
       // exercise
@@ -2057,6 +2342,7 @@ public:
       p50->isRed = false;
       bst.root = p50;
       bst.numElements = 1;
+      bst.resetEnds();
       Spy s(50);
       Spy::reset();
       // exercise
@@ -2128,8 +2414,8 @@ public:
       // exercise
       auto pairBST = bst.insert(std::move(s), true /* keepUnique */);
       // verify
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][30]
-      assertUnit(Spy::numEquals() == 3);      // compare [50][30][40]
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][30][40], confirm [40]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numAlloc() == 0);
       assertUnit(Spy::numDestructor() == 0);
@@ -2206,6 +2492,7 @@ public:
       p50->isRed = false;
       bst.root = p50;
       bst.numElements = 1;
+      bst.resetEnds();
       Spy s(30);
       Spy::reset();
       // exercise
@@ -2277,6 +2564,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p50;
       bst.numElements = 3;
+      bst.resetEnds();
 
       Spy s(20);
       Spy::reset();
@@ -2372,6 +2660,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p50;
       bst.numElements = 2;
+      bst.resetEnds();
 
       Spy s(10);
       Spy::reset();
@@ -2455,6 +2744,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p50;
       bst.numElements = 2;
+      bst.resetEnds();
 
       Spy s(90);
       Spy::reset();
@@ -2538,6 +2828,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p50;
       bst.numElements = 2;
+      bst.resetEnds();
 
       Spy s(40);
       Spy::reset();
@@ -2619,6 +2910,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p50;
       bst.numElements = 2;
+      bst.resetEnds();
 
       Spy s(60);
       Spy::reset();
@@ -2707,6 +2999,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p50;
       bst.numElements = 4;
+      bst.resetEnds();
 
       Spy s(10);
       Spy::reset();
@@ -2821,6 +3114,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p50;
       bst.numElements = 4;
+      bst.resetEnds();
 
       Spy s(90);
       Spy::reset();
@@ -2944,6 +3238,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p70;
       bst.numElements = 7;
+      bst.resetEnds();
 
       Spy s(40);
       Spy::reset();
@@ -3101,6 +3396,7 @@ public:
       custom::BST <Spy> bst;
       bst.root = p30;
       bst.numElements = 7;
+      bst.resetEnds();
 
       Spy s(60);
       Spy::reset();
@@ -3351,6 +3647,7 @@ public:
       p30->pLeft = p20;
       p30->pRight = p40;
       bst.numElements = 6;
+      bst.resetEnds();
       auto it = custom::BST <int> :: iterator(p10);
       // exercise
       auto itReturn = bst.erase(it);
@@ -3415,6 +3712,7 @@ public:
       p50->pRight = p60;
       p30->pRight = p40;
       bst.numElements = 8;
+      bst.resetEnds();
       auto it = custom::BST <int> ::iterator(p20);
       // exercise
       auto itReturn = bst.erase(it);
@@ -3460,6 +3758,921 @@ public:
       bst.root = nullptr;
    }
 
+   // remove a black leaf whose sibling has a red far child: one rotation
+   void test_erase_blackLeafRotate()
+   {  // setup
+      //                (50b)
+      //          +-------+-------+
+      //      [[(30b)]]         (70b)
+      //                          +----+
+      //                             (80r)
+      custom::BST <int> bst;
+      auto p30 = new custom::BST<int>::BNode(30);
+      auto p50 = new custom::BST<int>::BNode(50);
+      auto p70 = new custom::BST<int>::BNode(70);
+      auto p80 = new custom::BST<int>::BNode(80);
+      bst.root = p30->pParent = p70->pParent = p50;
+      p50->pLeft = p30;
+      p50->pRight = p80->pParent = p70;
+      p70->pRight = p80;
+      p30->isRed = p50->isRed = p70->isRed = false;
+      bst.numElements = 4;
+      bst.resetEnds();
+      auto it = custom::BST <int> ::iterator(p30);
+      // exercise
+      auto itReturn = bst.erase(it);
+      // verify
+      //                (70b)
+      //          +-------+-------+
+      //        (50b)           (80b)
+      assertUnit(itReturn == custom::BST <int> ::iterator(p50));
+      assertUnit(bst.numElements == 3);
+      assertUnit(bst.root == p70);
+      assertUnit(p70->pParent == nullptr);
+      assertUnit(p70->pLeft == p50);
+      assertUnit(p70->pRight == p80);
+      assertUnit(p50->pParent == p70);
+      assertUnit(p50->pLeft == nullptr);
+      assertUnit(p50->pRight == nullptr);
+      assertUnit(p80->pParent == p70);
+      assertUnit(p70->isRed == false);
+      assertUnit(p50->isRed == false);
+      assertUnit(p80->isRed == false);
+      // teardown
+      delete p50;
+      delete p70;
+      delete p80;
+      bst.numElements = 0;
+      bst.root = nullptr;
+   }
+
+   // remove a black leaf whose sibling has no red children: recolor only
+   void test_erase_blackLeafRecolor()
+   {  // setup
+      //                (50b)
+      //          +-------+-------+
+      //      [[(30b)]]         (70b)
+      custom::BST <int> bst;
+      auto p30 = new custom::BST<int>::BNode(30);
+      auto p50 = new custom::BST<int>::BNode(50);
+      auto p70 = new custom::BST<int>::BNode(70);
+      bst.root = p30->pParent = p70->pParent = p50;
+      p50->pLeft = p30;
+      p50->pRight = p70;
+      p30->isRed = p50->isRed = p70->isRed = false;
+      bst.numElements = 3;
+      bst.resetEnds();
+      auto it = custom::BST <int> ::iterator(p30);
+      // exercise
+      auto itReturn = bst.erase(it);
+      // verify
+      //                (50b)
+      //                  +-------+
+      //                        (70r)
+      assertUnit(itReturn == custom::BST <int> ::iterator(p50));
+      assertUnit(bst.numElements == 2);
+      assertUnit(bst.root == p50);
+      assertUnit(p50->pLeft == nullptr);
+      assertUnit(p50->pRight == p70);
+      assertUnit(p50->isRed == false);
+      assertUnit(p70->isRed == true);
+      assertUnit(p70->pParent == p50);
+      // teardown
+      delete p50;
+      delete p70;
+      bst.numElements = 0;
+      bst.root = nullptr;
+   }
+
+   // churn through many inserts and erases: the tree must stay red-black
+   void test_erase_manyBalanced()
+   {  // setup
+      custom::BST <int> bst;
+      for (int i = 0; i < 1000; i++)
+         bst.insert(i);
+      // exercise
+      for (int i = 0; i < 1000; i += 3)
+      {
+         auto it = bst.find(i);
+         bst.erase(it);
+      }
+      for (int i = 1; i < 1000; i += 3)
+      {
+         auto it = bst.find(i);
+         bst.erase(it);
+      }
+      // verify
+      assertUnit(bst.size() == 333);
+      assertUnit(bst.root != nullptr);
+      if (bst.root)
+      {
+         assertUnit(bst.root->computeSize() == 333);
+         assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+         assertUnit(findHeight(bst.root) <= 2 * 9);  // 2 log2(333 + 1)
+      }
+      int expected = 2;
+      for (auto it = bst.begin(); it != bst.end(); ++it, expected += 3)
+         assertUnit(*it == expected);
+   }  // teardown
+
+   // a range too long to erase one at a time is cut out whole
+   void test_eraseRange_long()
+   {  // setup
+      custom::BST <int> bst;
+      for (int i = 0; i < 1000; i++)
+         bst.insert(i);
+      auto first = bst.find(100);
+      auto last = bst.find(700);
+      // exercise
+      auto itReturn = bst.erase(first, last);
+      // verify
+      assertUnit(itReturn == last);
+      assertUnit(*itReturn == 700);
+      assertUnit(bst.size() == 400);
+      assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      assertUnit(verifyEnds(bst));
+      int expected = 0;
+      for (auto it = bst.begin(); it != bst.end(); ++it, expected++)
+      {
+         if (expected == 100)
+            expected = 700;
+         assertUnit(*it == expected);
+      }
+      assertUnit(expected == 1000);
+   }  // teardown
+
+   // with duplicates, only the elements from first on go, not every
+   // element equal to *first
+   void test_eraseRange_duplicates()
+   {  // setup
+      custom::BST <int> bst;
+      for (int i = 0; i < 600; i++)
+         bst.insert(i);
+      bst.insert(5);
+      bst.insert(5);
+      auto first = bst.begin();
+      for (int i = 0; i < 6; i++)   // 0 1 2 3 4 5 [5] 5 6
+         ++first;
+      auto last = first;
+      for (int i = 0; i < 400; i++)
+         ++last;
+      // exercise
+      bst.erase(first, last);
+      // verify
+      assertUnit(bst.size() == 602 - 400);
+      assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      assertUnit(verifyEnds(bst));
+      auto it = bst.begin();
+      for (int i = 0; i < 6; i++, ++it)
+         assertUnit(*it == i);         // 0 through 5, the first 5 kept
+      assertUnit(*it == 404);          // [5] 5 6 ... 403 erased
+      assertUnit(bst.back() == 599);
+   }  // teardown
+
+   /***************************************
+    * SPLIT AND JOIN
+    *    BST::split(const T &)
+    *    BST::join(BST &&, BST &&)
+    *    BST::join(BST &&, const T &, BST &&)
+    ***************************************/
+
+   // split the standard fixture down the middle
+   void test_split_standard()
+   {  // setup
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+     +----+----+
+      //    20        40    60        80  
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      Spy s(45);
+      Spy::reset();
+      // exercise
+      auto halves = bst.split(s);
+      // verify
+      assertUnit(Spy::numLessthan() == 3);    // compare [50][30][40]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numCopy() == 0);        // nodes are relinked, not copied
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(bst.root == nullptr);
+      assertUnit(bst.size() == 0);
+      assertUnit(halves.first.size() == 3);
+      assertUnit(halves.second.size() == 4);
+      assertUnit(halves.first.root->verifyRedBlack(halves.first.root->findDepth()));
+      assertUnit(halves.second.root->verifyRedBlack(halves.second.root->findDepth()));
+      int expected[] = { 20, 30, 40, 50, 60, 70, 80 };
+      int i = 0;
+      for (auto it = halves.first.begin(); it != halves.first.end() && i < 7; ++it, i++)
+         assertUnit(*it == Spy(expected[i]));
+      assertUnit(i == 3);
+      for (auto it = halves.second.begin(); it != halves.second.end() && i < 7; ++it, i++)
+         assertUnit(*it == Spy(expected[i]));
+      assertUnit(i == 7);
+   }  // teardown
+
+   // every split point of a larger tree leaves two red-black trees
+   void test_split_many()
+   {
+      for (int key = -1; key <= 200; key += 7)
+      {  // setup
+         custom::BST <int> bst;
+         for (int i = 0; i < 200; i++)
+            bst.insert(i);
+         // exercise
+         auto halves = bst.split(key);
+         // verify
+         size_t numLeft = key < 0 ? 0 : key;
+         assertUnit(halves.first.size() == numLeft);
+         assertUnit(halves.second.size() == 200 - numLeft);
+         if (halves.first.root)
+            assertUnit(halves.first.root->verifyRedBlack(halves.first.root->findDepth()));
+         if (halves.second.root)
+            assertUnit(halves.second.root->verifyRedBlack(halves.second.root->findDepth()));
+         int expected = 0;
+         for (auto it = halves.first.begin(); it != halves.first.end(); ++it, expected++)
+            assertUnit(*it == expected);
+         for (auto it = halves.second.begin(); it != halves.second.end(); ++it, expected++)
+            assertUnit(*it == expected);
+         assertUnit(expected == 200);
+      }  // teardown
+   }
+
+   // the halves know their sizes as soon as they are made, so asking
+   // writes nothing
+   void test_split_counted()
+   {  // setup
+      custom::BST <int> bst;
+      for (int i = 0; i < 100; i++)
+         bst.insert(i);
+      // exercise
+      auto halves = bst.split(30);
+      // verify
+      assertUnit(halves.first.numElements == 30);
+      assertUnit(halves.second.numElements == 70);
+      custom::BST <int> joined = custom::BST <int> ::join(std::move(halves.first), std::move(halves.second));
+      assertUnit(joined.numElements == 100);
+   }  // teardown
+
+   // join two trees back together
+   void test_join_many()
+   {  // setup
+      custom::BST <int> left;
+      custom::BST <int> right;
+      for (int i = 0; i < 300; i++)
+         left.insert(i);
+      for (int i = 300; i < 310; i++)
+         right.insert(i);
+      // exercise
+      custom::BST <int> bst = custom::BST <int> ::join(std::move(left), std::move(right));
+      // verify
+      assertUnit(left.root == nullptr);
+      assertUnit(right.root == nullptr);
+      assertUnit(bst.size() == 310);
+      assertUnit(bst.root->computeSize() == 310);
+      assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      int expected = 0;
+      for (auto it = bst.begin(); it != bst.end(); ++it, expected++)
+         assertUnit(*it == expected);
+      assertUnit(expected == 310);
+   }  // teardown
+
+   // join a short tree, a key, and a tall tree
+   void test_joinKey_unevenHeights()
+   {  // setup
+      custom::BST <int> left;
+      custom::BST <int> right;
+      left.insert(1);
+      for (int i = 10; i < 1000; i++)
+         right.insert(i);
+      // exercise
+      custom::BST <int> bst = custom::BST <int> ::join(std::move(left), 5, std::move(right));
+      // verify
+      assertUnit(bst.size() == 992);
+      assertUnit(bst.root->computeSize() == 992);
+      assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      auto it = bst.begin();
+      assertUnit(*it == 1);
+      ++it;
+      assertUnit(*it == 5);
+      ++it;
+      assertUnit(*it == 10);
+   }  // teardown
+
+   /***************************************
+    * RANK
+    *    BST::nth()
+    *    BST::rank()
+    *    BST::index()
+    *    BST::distance()
+    ***************************************/
+
+   // find every element by its position
+   void test_nth_many()
+   {  // setup
+      custom::BST <int, std::less<int>, std::allocator<int>, true> bst;
+      for (int i = 0; i < 300; i++)
+         bst.insert((i * 37) % 300);    // every number once, out of order
+      // exercise and verify
+      for (int i = 0; i < 300; i++)
+         assertUnit(*bst.nth(i) == i);
+      assertUnit(bst.nth(300) == bst.end());
+      assertUnit(verifySizes(bst.root));
+   }  // teardown
+
+   // count the elements less than a key, present or not
+   void test_rank_many()
+   {  // setup
+      custom::BST <int, std::less<int>, std::allocator<int>, true> bst;
+      for (int i = 0; i < 300; i++)
+         bst.insert(((i * 37) % 300) * 2);    // the even numbers below 600
+      // exercise and verify
+      for (int i = -1; i <= 600; i++)
+         assertUnit(bst.rank(i) == (size_t)(i < 0 ? 0 : (i + 1) / 2));
+      assertUnit(bst.index(bst.begin()) == 0);
+      assertUnit(bst.index(bst.end()) == 300);
+      assertUnit(bst.index(bst.find(100)) == 50);
+   }  // teardown
+
+   // sizes stay right through the rotations of an erase
+   void test_distance_afterErase()
+   {  // setup
+      custom::BST <int, std::less<int>, std::allocator<int>, true> bst;
+      for (int i = 0; i < 200; i++)
+         bst.insert(i);
+      // exercise
+      for (int i = 0; i < 200; i += 3)
+      {
+         auto it = bst.find(i);
+         bst.erase(it);
+      }
+      // verify
+      assertUnit(bst.size() == 133);
+      assertUnit(verifySizes(bst.root));
+      assertUnit(bst.distance(bst.begin(), bst.end()) == 133);
+      assertUnit(bst.distance(bst.find(1), bst.find(2)) == 1);
+      assertUnit(bst.distance(bst.find(1), bst.find(199)) == 132);
+      assertUnit(bst.distance(bst.find(199), bst.find(1)) == -132);
+      assertUnit(*bst.nth(2) == 4);
+   }  // teardown
+
+   // the halves of a split know their sizes right away
+   void test_rank_splitJoin()
+   {  // setup
+      custom::BST <int, std::less<int>, std::allocator<int>, true> bst;
+      for (int i = 0; i < 500; i++)
+         if (i != 123)
+            bst.insert(i);
+      // exercise
+      auto halves = bst.split(123);
+      // verify
+      assertUnit(halves.first.numElements == 123);
+      assertUnit(halves.second.numElements == 376);
+      assertUnit(verifySizes(halves.first.root));
+      assertUnit(verifySizes(halves.second.root));
+      assertUnit(*halves.second.nth(0) == 124);
+      // exercise
+      auto joined = custom::BST <int, std::less<int>, std::allocator<int>, true> ::
+         join(std::move(halves.first), 123, std::move(halves.second));
+      // verify
+      assertUnit(joined.numElements == 500);
+      assertUnit(verifySizes(joined.root));
+      for (int i = 0; i < 500; i++)
+         assertUnit(joined.rank(i) == (size_t)i);
+   }  // teardown
+
+   /***************************************
+    * AGGREGATE
+    *    BST::aggregate()
+    ***************************************/
+
+   // sum any range, through the rotations of inserts and erases
+   void test_aggregate_sum()
+   {  // setup
+      custom::BST <int, std::less<int>, std::allocator<int>, false, custom::sum_of<int>> bst;
+      for (int i = 0; i < 300; i++)
+         bst.insert((i * 37) % 300);
+      for (int i = 0; i < 300; i += 3)
+      {
+         auto it = bst.find(i);
+         bst.erase(it);
+      }
+      // exercise and verify
+      for (int lo = -5; lo < 310; lo += 13)
+         for (int hi = lo; hi < 310; hi += 29)
+         {
+            int sum = 0;
+            for (int i = (lo < 0 ? 0 : lo); i < hi && i < 300; i++)
+               if (i % 3 != 0)
+                  sum += i;
+            assertUnit(bst.aggregate(lo, hi) == sum);
+         }
+      assertUnit(bst.root->aggregate == 30000);   // 0 + ... + 299 less the multiples of 3
+   }  // teardown
+
+   // the Monoid need not be commutative: elements combine in order
+   struct Digits
+   {
+      using value_type = std::string;
+      static std::string identity()          { return "";                   }
+      static std::string value(int t)        { return std::to_string(t % 10); }
+      static std::string combine(const std::string & lhs, const std::string & rhs)
+                                             { return lhs + rhs;            }
+   };
+   void test_aggregate_inOrder()
+   {  // setup
+      custom::BST <int, std::less<int>, std::allocator<int>, false, Digits> bst;
+      for (int i = 9; i >= 0; i--)
+         bst.insert(i);
+      // exercise and verify
+      assertUnit(bst.aggregate(0, 10) == "0123456789");
+      assertUnit(bst.aggregate(3, 7) == "3456");
+      assertUnit(bst.aggregate(7, 3) == "");
+      assertUnit(bst.aggregate(-5, 1) == "0");
+   }  // teardown
+
+   // the halves of a split and the joined tree keep their aggregates
+   void test_aggregate_splitJoin()
+   {  // setup
+      using Tree = custom::BST <int, std::less<int>, std::allocator<int>, false, custom::max_of<int>>;
+      Tree bst;
+      for (int i = 0; i < 500; i++)
+         bst.insert(i * 2);
+      // exercise
+      auto halves = bst.split(401);
+      // verify
+      assertUnit(halves.first.root->aggregate == 400);
+      assertUnit(halves.second.root->aggregate == 998);
+      // exercise
+      Tree joined = Tree::join(std::move(halves.first), std::move(halves.second));
+      // verify
+      assertUnit(joined.aggregate(0, 401) == 400);
+      assertUnit(joined.aggregate(0, 1000) == 998);
+      assertUnit(joined.aggregate(999, 2000) == std::numeric_limits<int>::lowest());
+   }  // teardown
+
+   /***************************************
+    * ENDS
+    *    BST::rbegin()
+    *    BST::front()
+    *    BST::back()
+    *    BST::pop_front()
+    *    BST::pop_back()
+    ***************************************/
+
+   // walk the standard fixture backwards
+   void test_rbegin_standard()
+   {  // setup
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      int expected = 80;
+      // exercise
+      for (auto it = bst.rbegin(); it != bst.rend(); --it, expected -= 10)
+         // verify
+         assertUnit(*it == Spy(expected));
+      assertUnit(expected == 10);
+      assertUnit(bst.rbegin() == custom::BST <Spy> ::iterator(bst.root->pRight->pRight));
+      // teardown
+      teardownStandardFixture(bst);
+   }
+
+   // the smallest and largest without a walk down the tree
+   void test_frontBack_standard()
+   {  // setup
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      Spy::reset();
+      // exercise
+      const Spy & sFront = bst.front();
+      const Spy & sBack = bst.back();
+      // verify
+      assertUnit(Spy::numLessthan() == 0);
+      assertUnit(sFront == Spy(20));
+      assertUnit(sBack == Spy(80));
+      assertUnit(&sFront == &bst.root->pLeft->pLeft->data);
+      // teardown
+      teardownStandardFixture(bst);
+   }
+
+   // the ends follow every insert and erase, rotations and all
+   void test_ends_insertErase()
+   {  // setup
+      custom::BST <int> bst;
+      assertUnit(bst.pFirst == nullptr && bst.pLast == nullptr);
+      // exercise
+      for (int i = 0; i < 500; i++)
+      {
+         bst.insert((i * 37) % 500);
+         // verify
+         assertUnit(verifyEnds(bst));
+      }
+      for (int i = 0; i < 500; i++)
+      {
+         auto it = bst.find((i * 91) % 500);
+         bst.erase(it);
+         // verify
+         assertUnit(verifyEnds(bst));
+      }
+      assertUnit(bst.pFirst == nullptr && bst.pLast == nullptr);
+   }  // teardown
+
+   // and the halves of a split and the tree they join back into
+   void test_ends_splitJoin()
+   {  // setup
+      custom::BST <int> bst;
+      for (int i = 0; i < 100; i++)
+         bst.insert(i);
+      // exercise
+      auto halves = bst.split(40);
+      // verify
+      assertUnit(bst.pFirst == nullptr && bst.pLast == nullptr);
+      assertUnit(verifyEnds(halves.first));
+      assertUnit(verifyEnds(halves.second));
+      assertUnit(halves.first.back() == 39);
+      assertUnit(halves.second.front() == 40);
+      // exercise
+      auto joined = custom::BST <int> ::join(std::move(halves.first), std::move(halves.second));
+      // verify
+      assertUnit(verifyEnds(joined));
+      assertUnit(joined.front() == 0);
+      assertUnit(joined.back() == 99);
+      assertUnit(halves.first.pFirst == nullptr && halves.second.pLast == nullptr);
+   }  // teardown
+
+   // drain a tree from the front, as a scheduler takes the earliest deadline
+   void test_popFront_many()
+   {  // setup
+      custom::BST <int> bst;
+      for (int i = 0; i < 300; i++)
+         bst.insert((i * 37) % 300);
+      // exercise
+      for (int i = 0; i < 300; i++)
+      {
+         // verify
+         assertUnit(bst.front() == i);
+         bst.pop_front();
+         assertUnit(bst.size() == (size_t)(299 - i));
+         assertUnit(verifyEnds(bst));
+         if (bst.root)
+            assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+      }
+      assertUnit(bst.root == nullptr);
+   }  // teardown
+
+   // and from the back
+   void test_popBack_many()
+   {  // setup
+      custom::BST <Spy> bst;
+      for (int i = 0; i < 100; i++)
+         bst.insert(Spy(i));
+      int numDestructor = 0;
+      int numLessthan = 0;
+      // exercise
+      for (int i = 99; i >= 50; i--)
+      {
+         // verify
+         assertUnit(bst.back() == Spy(i));
+         Spy::reset();
+         bst.pop_back();
+         numDestructor += Spy::numDestructor();
+         numLessthan += Spy::numLessthan();
+      }
+      assertUnit(numDestructor == 50);
+      assertUnit(numLessthan == 0);
+      assertUnit(bst.size() == 50);
+      assertUnit(verifyEnds(bst));
+      assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+   }  // teardown
+
+   /***************************************
+    * THREADED
+    *    BNode::pNext
+    *    BNode::pPrev
+    ***************************************/
+
+   // the links follow every insert and erase, rotations and all
+   void test_threaded_insertErase()
+   {  // setup
+      custom::BST <int, std::less<int>, std::allocator<int>, false, void, true> bst;
+      // exercise
+      for (int i = 0; i < 300; i++)
+      {
+         bst.insert((i * 37) % 300);
+         // verify
+         assertUnit(verifyThreads(bst));
+      }
+      for (int i = 0; i < 300; i += 2)
+      {
+         auto it = bst.find((i * 91) % 300);
+         bst.erase(it);
+         // verify
+         assertUnit(verifyThreads(bst));
+      }
+      bst.pop_front();
+      bst.pop_back();
+      assertUnit(verifyThreads(bst));
+      assertUnit(bst.size() == 148);
+   }  // teardown
+
+   // a copy gets links of its own
+   void test_threaded_copy()
+   {  // setup
+      custom::BST <int, std::less<int>, std::allocator<int>, false, void, true> bstSrc;
+      for (int i = 0; i < 100; i++)
+         bstSrc.insert(i);
+      custom::BST <int, std::less<int>, std::allocator<int>, false, void, true> bstDest;
+      for (int i = 0; i < 10; i++)
+         bstDest.insert(i * 1000);
+      // exercise
+      bstDest = bstSrc;
+      // verify
+      assertUnit(verifyThreads(bstDest));
+      assertUnit(verifyThreads(bstSrc));
+      assertUnit(bstDest.pFirst != bstSrc.pFirst);
+      assertUnit(*++bstDest.begin() == 1);
+   }  // teardown
+
+   // split cuts the list in two and join splices it back
+   void test_threaded_splitJoin()
+   {  // setup
+      using Tree = custom::BST <int, std::less<int>, std::allocator<int>, false, void, true>;
+      Tree bst;
+      for (int i = 0; i < 200; i++)
+         bst.insert(i * 2);
+      // exercise
+      auto halves = bst.split(101);
+      // verify
+      assertUnit(verifyThreads(halves.first));
+      assertUnit(verifyThreads(halves.second));
+      assertUnit(halves.first.pLast->pNext == nullptr);
+      assertUnit(halves.second.pFirst->pPrev == nullptr);
+      // exercise
+      Tree joined = Tree::join(std::move(halves.first), 101, std::move(halves.second));
+      // verify
+      assertUnit(verifyThreads(joined));
+      assertUnit(joined.size() == 201);
+      auto it = joined.find(100);
+      assertUnit(*++it == 101);
+      assertUnit(*++it == 102);
+   }  // teardown
+
+   /***************************************
+    * POOL
+    *    BST::createNode()
+    *    BST::destroyNode()
+    *    BST::trim()
+    ***************************************/
+
+   // erased nodes are handed back out to the next inserts
+   void test_pool_recycle()
+   {  // setup
+      custom::BST <Spy> bst;
+      for (int i = 0; i < 100; i++)
+         bst.insert(Spy(i));
+      size_t numSlabs = bst.pPool->numSlabs();
+      size_t numLive = bst.pPool->numLive();
+      // exercise
+      for (int round = 0; round < 10; round++)
+      {
+         for (int i = 0; i < 100; i += 2)
+         {
+            auto it = bst.find(Spy(i));
+            bst.erase(it);
+         }
+         for (int i = 0; i < 100; i += 2)
+            bst.insert(Spy(i));
+      }
+      // verify
+      assertUnit(bst.size() == 100);
+      assertUnit(numLive == 100);
+      assertUnit(bst.pPool->numSlabs() == numSlabs);
+      assertUnit(bst.pPool->numLive() == numLive);
+   }  // teardown
+
+   // each tree has a pool of its own, made on the first insert
+   void test_pool_perTree()
+   {  // setup
+      custom::BST <long> bst1;
+      custom::BST <long> bst2;
+      bool noneYet = !bst1.pPool && !bst2.pPool;
+      // exercise
+      bst1.insert(10);
+      bst2.insert(20);
+      bst2.insert(30);
+      // verify
+      assertUnit(noneYet);
+      assertUnit(bst1.pPool && bst2.pPool);
+      assertUnit(bst1.pPool != bst2.pPool);
+      assertUnit(bst1.pPool->numLive() == 1);
+      assertUnit(bst2.pPool->numLive() == 2);
+      assertUnit(custom::pool <custom::BST <long> :: BNode> :: poolOf(bst1.root) == bst1.pPool);
+   }  // teardown
+
+   // clearing keeps the slabs for the next inserts; trim gives them back
+   void test_pool_clearKeepsTrimReleases()
+   {  // setup
+      custom::BST <long> bst;
+      for (long i = 0; i < 5000; i++)
+         bst.insert(i);
+      size_t numSlabs = bst.pPool->numSlabs();
+      // exercise
+      bst.clear();
+      size_t numSlabsCleared = bst.pPool->numSlabs();
+      for (long i = 0; i < 5000; i++)
+         bst.insert(i);
+      size_t numSlabsRefilled = bst.pPool->numSlabs();
+      bst.clear();
+      bst.trim();
+      // verify
+      assertUnit(numSlabs > 1);
+      assertUnit(numSlabsCleared == numSlabs);
+      assertUnit(numSlabsRefilled == numSlabs);
+      assertUnit(bst.pPool->numLive() == 0);
+      assertUnit(bst.pPool->numSlabs() == 0);
+      assertUnit(bst.root == nullptr);
+      assertUnit(bst.numElements == 0);
+   }  // teardown
+
+   // trim leaves the slabs alone while any node is still out
+   void test_pool_trimNotEmpty()
+   {  // setup
+      custom::BST <long> bst;
+      for (long i = 0; i < 100; i++)
+         bst.insert(i);
+      for (long i = 0; i < 99; i++)
+      {
+         auto it = bst.find(i);
+         bst.erase(it);
+      }
+      // exercise
+      bst.trim();
+      // verify
+      assertUnit(bst.pPool->numLive() == 1);
+      assertUnit(bst.pPool->numSlabs() > 0);
+      assertUnit(*bst.begin() == 99);
+   }  // teardown
+
+   // a join carries on with the left pool; the right one lasts until
+   // its nodes are back
+   void test_pool_joinKeepsBoth()
+   {  // setup
+      using Pool = custom::pool <custom::BST <long> :: BNode>;
+      custom::BST <long> bstLeft;
+      custom::BST <long> bstRight;
+      for (long i = 0; i < 100; i++)
+      {
+         bstLeft.insert(i);
+         bstRight.insert(i + 1000);
+      }
+      Pool * pPoolLeft = bstLeft.pPool;
+      Pool * pPoolRight = bstRight.pPool;
+      // exercise
+      custom::BST <long> bst = custom::BST <long> :: join(std::move(bstLeft), std::move(bstRight));
+      bool rightStays = Pool::poolOf(bst.pLast) == pPoolRight;
+      size_t numLiveRight = pPoolRight->numLive();
+      for (long i = 0; i < 100; i++)
+      {
+         auto it = bst.find(i * 2 < 100 ? i * 2 : i + 950);
+         bst.erase(it);
+      }
+      // verify
+      assertUnit(bst.pPool == pPoolLeft);
+      assertUnit(rightStays);
+      assertUnit(numLiveRight == 100);
+      assertUnit(bst.pPool->numLive() == 50);
+      assertUnit(pPoolRight->numLive() == 50);
+      assertUnit(bst.size() == 100);
+      assertUnit(bst.root->verifyRedBlack(bst.root->findDepth()));
+   }  // teardown
+
+   // a pool is only locked once a second tree can free into it
+   void test_pool_splitShares()
+   {  // setup
+      custom::BST <long> bst;
+      custom::BST <long> bstOther;
+      for (long i = 0; i < 100; i++)
+      {
+         bst.insert(i);
+         bstOther.insert(i + 1000);
+      }
+      bool sharedBefore = bst.pPool->shared() || bstOther.pPool->shared();
+      auto * pPoolOther = bstOther.pPool;
+      // exercise
+      auto halves = bst.split(50);
+      custom::BST <long> joined = custom::BST <long> ::join(std::move(halves.second), std::move(bstOther));
+      // verify
+      assertUnit(!sharedBefore);
+      assertUnit(halves.first.pPool->shared());
+      assertUnit(joined.pPool == halves.first.pPool);
+      assertUnit(pPoolOther->shared());
+      assertUnit(halves.first.size() == 50);
+      assertUnit(joined.size() == 150);
+   }  // teardown
+
+   // the halves of a split can be changed from two threads at once
+   void test_pool_splitThreads()
+   {  // setup
+      custom::BST <long> bst;
+      for (long i = 0; i < 2000; i++)
+         bst.insert(i);
+      auto halves = bst.split(1000);
+      auto churn = [](custom::BST <long> * pTree, long lo)
+      {
+         for (int round = 0; round < 20; round++)
+            for (long i = lo; i < lo + 1000; i++)
+            {
+               auto it = pTree->find(i);
+               pTree->erase(it);
+               pTree->insert(i);
+            }
+      };
+      // exercise
+      std::thread left(churn, &halves.first, 0L);
+      std::thread right(churn, &halves.second, 1000L);
+      left.join();
+      right.join();
+      // verify
+      assertUnit(halves.first.size() == 1000);
+      assertUnit(halves.second.size() == 1000);
+      assertUnit(halves.first.pPool->numLive() == 2000);
+      assertUnit(halves.first.root->verifyRedBlack(halves.first.root->findDepth()));
+      assertUnit(halves.second.root->verifyRedBlack(halves.second.root->findDepth()));
+   }  // teardown
+
+   /**************************************************************
+    * FIND HEIGHT
+    * The number of nodes on the longest path from the root to a leaf
+    *************************************************************/
+   template <class BNode>
+   int findHeight(const BNode * pNode)
+   {
+      if (pNode == nullptr)
+         return 0;
+      int heightLeft  = findHeight(pNode->pLeft);
+      int heightRight = findHeight(pNode->pRight);
+      return 1 + (heightLeft > heightRight ? heightLeft : heightRight);
+   }
+
+   /**************************************************************
+    * VERIFY ENDS
+    * Are the cached left-most and right-most nodes the real ones?
+    *************************************************************/
+   template <class Tree>
+   bool verifyEnds(const Tree & bst)
+   {
+      auto pFirst = bst.root;
+      auto pLast = bst.root;
+      while (pFirst && pFirst->pLeft)
+         pFirst = pFirst->pLeft;
+      while (pLast && pLast->pRight)
+         pLast = pLast->pRight;
+      return bst.pFirst == pFirst && bst.pLast == pLast;
+   }
+
+   /**************************************************************
+    * VERIFY THREADS
+    * Do the in-order links of a Threaded tree visit every node in
+    * order, both ways, and agree with the ends?
+    *************************************************************/
+   template <class Tree>
+   bool verifyThreads(const Tree & bst)
+   {
+      std::vector <const typename Tree::BNode *> nodes;
+      collectInOrder(bst.root, nodes);
+      if (!verifyEnds(bst))
+         return false;
+      for (size_t i = 0; i < nodes.size(); i++)
+      {
+         if (nodes[i]->pPrev != (i == 0 ? nullptr : nodes[i - 1]) ||
+             nodes[i]->pNext != (i + 1 == nodes.size() ? nullptr : nodes[i + 1]))
+            return false;
+      }
+      return true;
+   }
+   template <class BNode>
+   void collectInOrder(const BNode * pNode, std::vector <const BNode *> & nodes)
+   {
+      if (pNode == nullptr)
+         return;
+      collectInOrder(pNode->pLeft, nodes);
+      nodes.push_back(pNode);
+      collectInOrder(pNode->pRight, nodes);
+   }
+
+   /**************************************************************
+    * VERIFY SIZES
+    * Does every node of a ranked tree know the size of its subtree?
+    *************************************************************/
+   template <class BNode>
+   bool verifySizes(const BNode * pNode)
+   {
+      if (pNode == nullptr)
+         return true;
+      return verifySizes(pNode->pLeft) && verifySizes(pNode->pRight) &&
+         pNode->numSubtree == 1 + BNode::sizeOf(pNode->pLeft) + BNode::sizeOf(pNode->pRight);
+   }
+
    /**************************************************************
     * SETUP STANDARD FIXTURE
     *                (50b)
@@ -3503,6 +4716,7 @@ public:
       // now assign everything to the bst
       bst.root = p50;
       bst.numElements = 7;
+      bst.resetEnds();
    }
 
    /**************************************************************
@@ -0,0 +1,500 @@
+/***********************************************************************
+ * Header:
+ *    TEST B-TREE SET
+ * Summary:
+ *    Unit tests for btree_set
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "btreeSet.h"
+#include "unitTest.h"
+#include "spy.h"
+
+#include <iostream>
+#include <string>
+#include <cassert>
+
+class TestBTreeSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_nodeSize();
+      test_constructCopy_standard();
+
+      // Insert
+      test_insert_oneLeaf();
+      test_insert_split();
+      test_insert_splitAtEnd();
+      test_insert_duplicate();
+      test_insert_ascendingFills();
+      test_insert_ascendingShortEdge();
+      test_insert_endOfMiddleLeaf();
+      test_insert_strings();
+
+      // Access
+      test_find_standard();
+      test_bounds_standard();
+      test_iterate_backwards();
+
+      // Erase
+      test_erase_leaf();
+      test_erase_internal();
+      test_erase_all();
+      test_erase_afterAscending();
+      test_eraseRange_standard();
+
+      // Equivalence
+      test_equal_standard();
+      test_equal_noLessThan();
+
+      report("BTreeSet");
+   }
+
+   // three elements to a node, so a handful of elements makes a few levels
+   using SmallSet = custom::btree_set <int, std::less<int>, 16>;
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, no allocations
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::btree_set <Spy> s;
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(s.root == nullptr);
+      assertUnit(s.numElements == 0);
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // nodes hold as many elements as fit in NodeBytes
+   void test_construct_nodeSize()
+   {  // setup
+      // exercise and verify
+      assertUnit((custom::btree_set <int> ::numSlots == 60));        // (256 - 16) / 4
+      assertUnit((custom::btree_set <double, std::less<double>, 4096> ::numSlots == 510));
+      assertUnit(SmallSet::numSlots == 3);
+      assertUnit(SmallSet::minKeys == 1);
+   }  // teardown
+
+   // a copy has nodes of its own
+   void test_constructCopy_standard()
+   {  // setup
+      SmallSet sSrc;
+      for (int i = 0; i < 50; i++)
+         sSrc.insert(i);
+      // exercise
+      SmallSet sDest(sSrc);
+      sSrc.erase(25);
+      // verify
+      assertUnit(sDest.size() == 50);
+      assertUnit(sDest.contains(25));
+      assertUnit(sDest.root != sSrc.root);
+      assertUnit(verifyBTree(sDest) == 50);
+      assertUnit(sDest != sSrc);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // a few elements fit in the root, in order
+   void test_insert_oneLeaf()
+   {  // setup
+      custom::btree_set <int> s;
+      // exercise
+      s.insert({ 50, 30, 70, 20, 40, 60, 80 });
+      // verify
+      assertUnit(s.root->isLeaf);
+      assertUnit(s.root->num == 7);
+      for (int i = 0; i < 7; i++)
+         assertUnit(s.root->key(i) == 20 + 10 * i);
+   }  // teardown
+
+   // a full root splits around its middle element
+   //        [30]
+   //     +---+---+
+   //   [20 25]  [40]
+   void test_insert_split()
+   {  // setup
+      SmallSet s { 20, 40, 30 };
+      // exercise
+      auto p = s.insert(25);
+      // verify
+      assertUnit(p.second);
+      assertUnit(*p.first == 25);
+      assertUnit(!s.root->isLeaf);
+      assertUnit(s.root->num == 1);
+      assertUnit(s.root->key(0) == 30);
+      assertUnit(s.root->child(0)->num == 2);
+      assertUnit(s.root->child(1)->num == 1);
+      assertUnit(s.root->child(1)->pParent == s.root);
+      assertUnit(s.root->child(1)->position == 1);
+      assertUnit(verifyBTree(s) == 4);
+   }  // teardown
+
+   // but one filling up at the end leaves the old node full
+   //          [40]
+   //       +---+---+
+   //   [20 30]    [50]
+   void test_insert_splitAtEnd()
+   {  // setup
+      SmallSet s { 20, 40, 30 };
+      // exercise
+      auto p = s.insert(50);
+      // verify
+      assertUnit(p.second);
+      assertUnit(*p.first == 50);
+      assertUnit(s.root->key(0) == 40);
+      assertUnit(s.root->child(0)->num == 2);
+      assertUnit(s.root->child(1)->num == 1);
+      assertUnit(verifyBTree(s) == 4);
+   }  // teardown
+
+   // a duplicate changes nothing and copies nothing
+   void test_insert_duplicate()
+   {  // setup
+      custom::btree_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      Spy s30(30);
+      Spy::reset();
+      // exercise
+      auto p = s.insert(s30);
+      // verify
+      assertUnit(p.second == false);
+      assertUnit(*p.first == Spy(30));
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // loading sorted data leaves the nodes nearly full
+   void test_insert_ascendingFills()
+   {  // setup
+      custom::btree_set <int> s;
+      // exercise
+      for (int i = 0; i < 6000; i++)
+         s.insert(i);
+      // verify
+      assertUnit(verifyBTree(s) == 6000);
+      assertUnit(countNodes(s.root) <= 6000 / 59 + 3);
+   }  // teardown
+
+   // the price of that is a short node down the right edge, allowed there
+   void test_insert_ascendingShortEdge()
+   {
+      for (int n : { 61, 3601 })
+      {  // setup
+         custom::btree_set <int> s;
+         // exercise
+         for (int i = 0; i < n; i++)
+            s.insert(i);
+         // verify
+         const auto * pLast = s.root;
+         while (!pLast->isLeaf)
+            pLast = pLast->child(pLast->num);
+         assertUnit(pLast->num < decltype(s)::minKeys);
+         assertUnit(verifyBTree(s) == (size_t)n);
+      }  // teardown
+   }
+
+   // the end of a full leaf inside the tree is not the end of the tree,
+   // so it splits in half like any other
+   void test_insert_endOfMiddleLeaf()
+   {  // setup
+      custom::btree_set <int> s;
+      for (int i = 0; i < 10000; i += 10)
+         s.insert(i);
+      // exercise
+      for (int j = 1; j < 10; j++)
+      {
+         for (int i = j; i < 10000; i += 10)
+            s.insert(i);
+         // verify
+         assertUnit(verifyBTree(s) == (size_t)(1000 * (j + 1)));
+      }
+   }  // teardown
+
+   void test_insert_strings()
+   {  // setup
+      custom::btree_set <std::string, std::less<std::string>, 128> s;
+      // exercise
+      for (int i = 0; i < 500; i++)
+         s.insert(std::to_string((i * 37) % 500));
+      // verify
+      assertUnit(verifyBTree(s) == 500);
+      assertUnit(*s.begin() == "0");
+      assertUnit(*s.lower_bound("45") == "45");
+      assertUnit(*s.upper_bound("45") == "450");
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // find what is there and not what is not, at every level
+   void test_find_standard()
+   {  // setup
+      SmallSet s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i * 2);
+      // exercise and verify
+      for (int i = 0; i < 200; i++)
+      {
+         auto it = s.find(i);
+         if (i % 2 == 0)
+            assertUnit(it != s.end() && *it == i);
+         else
+            assertUnit(it == s.end());
+      }
+   }  // teardown
+
+   // the first element not less than, and the first greater than
+   void test_bounds_standard()
+   {  // setup
+      SmallSet s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i * 2);
+      // exercise and verify
+      assertUnit(*s.lower_bound(51) == 52);
+      assertUnit(*s.lower_bound(52) == 52);
+      assertUnit(*s.upper_bound(52) == 54);
+      assertUnit(s.lower_bound(-5) == s.begin());
+      assertUnit(s.lower_bound(199) == s.end());
+      assertUnit(s.upper_bound(198) == s.end());
+      auto range = s.equal_range(60);
+      assertUnit(*range.first == 60 && *range.second == 62);
+   }  // teardown
+
+   // largest to smallest, through leaves and the nodes above them
+   void test_iterate_backwards()
+   {  // setup
+      SmallSet s;
+      for (int i = 0; i < 100; i++)
+         s.insert((i * 37) % 100);
+      int expected = 99;
+      // exercise
+      for (auto it = s.rbegin(); it != s.rend(); --it, expected--)
+         // verify
+         assertUnit(*it == expected);
+      assertUnit(expected == -1);
+      assertUnit(s.front() == 0);
+      assertUnit(s.back() == 99);
+   }  // teardown
+
+   /***************************************
+    * ERASE
+    ***************************************/
+
+   // a leaf with elements to spare just closes the gap
+   void test_erase_leaf()
+   {  // setup
+      custom::btree_set <int> s { 20, 30, 40, 50 };
+      // exercise
+      auto it = s.erase(s.find(30));
+      // verify
+      assertUnit(*it == 40);
+      assertUnit(s.root->num == 3);
+      assertUnit(s.erase(30) == 0);
+      assertUnit(s.erase(50) == 1);
+      assertUnit(s.size() == 2);
+   }  // teardown
+
+   // an element above the leaves returns the one after it
+   void test_erase_internal()
+   {  // setup
+      SmallSet s;
+      for (int i = 0; i < 30; i++)
+         s.insert(i);
+      int key = s.root->key(0);
+      // exercise
+      auto it = s.erase(s.find(key));
+      // verify
+      assertUnit(*it == key + 1);
+      assertUnit(!s.contains(key));
+      assertUnit(verifyBTree(s) == 29);
+   }  // teardown
+
+   // borrow and merge all the way down to nothing
+   void test_erase_all()
+   {  // setup
+      custom::btree_set <Spy, std::less<Spy>, 32> s;
+      for (int i = 0; i < 200; i++)
+         s.insert(Spy((i * 37) % 200));
+      Spy::reset();
+      // exercise
+      for (int i = 0; i < 200; i++)
+      {
+         s.erase(Spy((i * 91) % 200));
+         // verify
+         assertUnit(verifyBTree(s) == (size_t)(199 - i));
+      }
+      assertUnit(s.root == nullptr);
+      assertUnit(s.empty());
+   }  // teardown
+
+   // a tree loaded in order, short right edge and all, empties cleanly
+   void test_erase_afterAscending()
+   {  // setup
+      custom::btree_set <int> s;
+      for (int i = 0; i < 3601; i++)
+         s.insert(i);
+      // exercise
+      for (int i = 0; i < 3601; i++)
+      {
+         s.erase((i * 1013) % 3601);
+         // verify
+         assertUnit(verifyBTree(s) == (size_t)(3600 - i));
+      }
+      assertUnit(s.empty());
+   }  // teardown
+
+   // erase a run in the middle
+   void test_eraseRange_standard()
+   {  // setup
+      SmallSet s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      // exercise
+      auto it = s.erase(s.find(20), s.find(80));
+      // verify
+      assertUnit(*it == 80);
+      assertUnit(s.size() == 40);
+      assertUnit(*--s.find(80) == 19);
+      assertUnit(verifyBTree(s) == 40);
+   }  // teardown
+
+   /***************************************
+    * EQUIVALENCE
+    ***************************************/
+
+   // same elements, however they were put in
+   void test_equal_standard()
+   {  // setup
+      SmallSet s1;
+      SmallSet s2;
+      for (int i = 0; i < 50; i++)
+      {
+         s1.insert(i);
+         s2.insert(49 - i);
+      }
+      // exercise
+      bool equal = (s1 == s2);
+      s2.erase(25);
+      s2.insert(50);
+      bool notEqual = (s1 != s2);
+      // verify
+      assertUnit(equal);
+      assertUnit(notEqual);
+   }  // teardown
+
+   // elements with operator== and a comparator, but no operator<
+   struct Point
+   {
+      int x;
+      int y;
+      bool operator == (const Point & rhs) const { return x == rhs.x && y == rhs.y; }
+   };
+   struct PointLess
+   {
+      bool operator () (const Point & lhs, const Point & rhs) const
+      {
+         return lhs.x < rhs.x || (lhs.x == rhs.x && lhs.y < rhs.y);
+      }
+   };
+   void test_equal_noLessThan()
+   {  // setup
+      custom::btree_set <Point, PointLess> s1 { Point { 1, 2 }, Point { 3, 4 } };
+      custom::btree_set <Point, PointLess> s2 { Point { 3, 4 }, Point { 1, 2 } };
+      custom::btree_set <Point, PointLess> s3 { Point { 1, 2 }, Point { 3, 5 } };
+      // exercise and verify
+      assertUnit(s1 == s2);
+      assertUnit(s1 != s3);
+   }  // teardown
+
+   /**************************************************************
+    * VERIFY B-TREE
+    * The number of elements, or (size_t)-1 if anything is wrong:
+    * elements out of order, a child that does not know its place, a
+    * node less than half full other than the root and those down the
+    * right edge, an empty node other than the root, or leaves at
+    * different depths. The count must match size() too
+    *************************************************************/
+   template <class Set>
+   size_t verifyBTree(const Set & s)
+   {
+      if (s.root == nullptr)
+         return s.numElements == 0 ? 0 : (size_t)-1;
+      if (s.root->pParent != nullptr)
+         return (size_t)-1;
+      int depthLeaf = -1;
+      size_t num = verifyNode(s, s.root, 0, true /*onRightEdge*/, depthLeaf);
+      if (num != s.numElements)
+         return (size_t)-1;
+
+      // and the elements come out in order
+      auto it = s.begin();
+      for (size_t i = 1; i < num; i++)
+      {
+         auto itPrev = it++;
+         if (!s.compare(*itPrev, *it))
+            return (size_t)-1;
+      }
+      return num;
+   }
+   template <class Set, class Node>
+   size_t verifyNode(const Set & s, const Node * pNode, int depth, bool onRightEdge, int & depthLeaf)
+   {
+      if (pNode != s.root && pNode->num < (onRightEdge ? 1 : Set::minKeys))
+         return (size_t)-1;
+      for (size_t i = 1; i < pNode->num; i++)
+         if (!s.compare(pNode->key(i - 1), pNode->key(i)))
+            return (size_t)-1;
+      if (pNode->isLeaf)
+      {
+         if (depthLeaf == -1)
+            depthLeaf = depth;
+         return depth == depthLeaf ? pNode->num : (size_t)-1;
+      }
+      size_t num = pNode->num;
+      for (size_t i = 0; i <= pNode->num; i++)
+      {
+         const Node * pChild = pNode->child(i);
+         if (pChild->pParent != pNode || pChild->position != i)
+            return (size_t)-1;
+         size_t numChild = verifyNode(s, pChild, depth + 1, onRightEdge && i == pNode->num, depthLeaf);
+         if (numChild == (size_t)-1)
+            return (size_t)-1;
+         num += numChild;
+      }
+      return num;
+   }
+
+   /**************************************************************
+    * COUNT NODES
+    * How many nodes in the subtree
+    *************************************************************/
+   template <class Node>
+   size_t countNodes(const Node * pNode)
+   {
+      size_t num = 1;
+      if (!pNode->isLeaf)
+         for (size_t i = 0; i <= pNode->num; i++)
+            num += countNodes(pNode->child(i));
+      return num;
+   }
+};
+
+#endif // DEBUG
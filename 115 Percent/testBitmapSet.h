@@ -0,0 +1,283 @@
+/***********************************************************************
+ * Header:
+ *    TEST BITMAP SET
+ * Summary:
+ *    Unit tests for bitmap_set
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "bitmapSet.h"
+#include "unitTest.h"
+
+#include <iostream>
+#include <cstdint>
+#include <cassert>
+
+class TestBitmapSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_initializerList();
+
+      // Insert and erase
+      test_insert_chunks();
+      test_insert_duplicate();
+      test_insert_toBitmap();
+      test_erase_toArray();
+      test_erase_lastInChunk();
+      test_insert_signed();
+
+      // Access
+      test_bounds_acrossChunks();
+      test_iterate_bitmap();
+
+      // Set algebra
+      test_union_bitmaps();
+      test_intersection_mixed();
+      test_intersection_toArray();
+
+      report("BitmapSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, no chunks
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::bitmap_set <uint32_t> s;
+      // verify
+      assertUnit(s.chunks.empty());
+      assertUnit(s.numElements == 0);
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // in order whatever order they came in
+   void test_construct_initializerList()
+   {  // setup
+      // exercise
+      custom::bitmap_set <uint32_t> s { 50, 30, 70, 20, 40, 60, 80 };
+      // verify
+      assertUnit(s.size() == 7);
+      assertUnit(s.chunks.size() == 1);
+      uint32_t expected = 20;
+      for (auto it = s.begin(); it != s.end(); ++it, expected += 10)
+         assertUnit(*it == expected);
+      assertUnit(expected == 90);
+   }  // teardown
+
+   /***************************************
+    * INSERT AND ERASE
+    ***************************************/
+
+   // the top 16 bits pick the chunk, the bottom 16 go in it
+   void test_insert_chunks()
+   {  // setup
+      custom::bitmap_set <uint32_t> s;
+      // exercise
+      s.insert(0x00030005);
+      s.insert(0x00010007);
+      s.insert(0x00030001);
+      // verify
+      assertUnit(s.chunks.size() == 2);
+      assertUnit(s.chunks[0].key == 1);
+      assertUnit(s.chunks[1].key == 3);
+      assertUnit(s.chunks[1].num == 2);
+      assertUnit(s.chunks[1].array[0] == 1);
+      assertUnit(s.chunks[1].array[1] == 5);
+      assertUnit(!s.chunks[1].isBitmap());
+   }  // teardown
+
+   // a duplicate changes nothing
+   void test_insert_duplicate()
+   {  // setup
+      custom::bitmap_set <uint32_t> s { 50, 30, 70 };
+      // exercise
+      auto p = s.insert(30);
+      // verify
+      assertUnit(p.second == false);
+      assertUnit(*p.first == 30);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // one more than an array holds makes a bitmap
+   void test_insert_toBitmap()
+   {  // setup
+      custom::bitmap_set <uint32_t> s;
+      for (uint32_t i = 0; i < 4096; i++)
+         s.insert(i * 2);
+      bool wasArray = !s.chunks[0].isBitmap();
+      // exercise
+      s.insert(1);
+      // verify
+      assertUnit(wasArray);
+      assertUnit(s.chunks[0].isBitmap());
+      assertUnit(s.chunks[0].array.capacity() == 0);
+      assertUnit(s.chunks[0].num == 4097);
+      assertUnit(s.size() == 4097);
+      assertUnit(s.contains(1));
+      assertUnit(s.contains(8190));
+      assertUnit(!s.contains(3));
+   }  // teardown
+
+   // and one fewer goes back
+   void test_erase_toArray()
+   {  // setup
+      custom::bitmap_set <uint32_t> s;
+      for (uint32_t i = 0; i <= 4096; i++)
+         s.insert(i);
+      // exercise
+      size_t num = s.erase(100);
+      // verify
+      assertUnit(num == 1);
+      assertUnit(!s.chunks[0].isBitmap());
+      assertUnit(s.chunks[0].bits.capacity() == 0);
+      assertUnit(s.chunks[0].array.size() == 4096);
+      assertUnit(s.chunks[0].array[100] == 101);
+      assertUnit(s.size() == 4096);
+   }  // teardown
+
+   // an empty chunk is dropped
+   void test_erase_lastInChunk()
+   {  // setup
+      custom::bitmap_set <uint32_t> s { 5, 0x00020005 };
+      // exercise
+      size_t numMissing = s.erase(6);
+      size_t num = s.erase(5);
+      // verify
+      assertUnit(numMissing == 0);
+      assertUnit(num == 1);
+      assertUnit(s.chunks.size() == 1);
+      assertUnit(s.chunks[0].key == 2);
+      assertUnit(s.size() == 1);
+   }  // teardown
+
+   // negative numbers come before positive ones
+   void test_insert_signed()
+   {  // setup
+      custom::bitmap_set <int> s;
+      // exercise
+      s.insert({ 5, -1, -100000, 0, 70000 });
+      // verify
+      int expected[] = { -100000, -1, 0, 5, 70000 };
+      int i = 0;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         assertUnit(*it == expected[i++]);
+      assertUnit(i == 5);
+      assertUnit(s.front() == -100000);
+      assertUnit(s.back() == 70000);
+      assertUnit(*s.lower_bound(-50) == -1);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // a bound past the end of one chunk is the start of the next
+   void test_bounds_acrossChunks()
+   {  // setup
+      custom::bitmap_set <uint32_t> s { 10, 20, 0x00050003, 0x00050009 };
+      // exercise and verify
+      assertUnit(*s.lower_bound(15) == 20);
+      assertUnit(*s.lower_bound(21) == 0x00050003);
+      assertUnit(*s.upper_bound(20) == 0x00050003);
+      assertUnit(*s.lower_bound(0x00030000) == 0x00050003);
+      assertUnit(*s.upper_bound(0x00050003) == 0x00050009);
+      assertUnit(s.upper_bound(0x00050009) == s.end());
+      assertUnit(s.find(0x00050004) == s.end());
+      assertUnit(*s.find(0x00050009) == 0x00050009);
+   }  // teardown
+
+   // bits come out in order, skipping the empty words
+   void test_iterate_bitmap()
+   {  // setup
+      custom::bitmap_set <uint32_t> s;
+      for (uint32_t i = 0; i < 5000; i++)
+         s.insert(i * 13);
+      // exercise
+      uint32_t expected = 0;
+      bool inOrder = true;
+      for (auto it = s.begin(); it != s.end(); ++it, expected += 13)
+         inOrder = inOrder && *it == expected;
+      // verify
+      assertUnit(s.chunks[0].isBitmap());
+      assertUnit(inOrder);
+      assertUnit(expected == 5000 * 13);
+      assertUnit(s.back() == 4999 * 13);
+   }  // teardown
+
+   /***************************************
+    * SET ALGEBRA
+    ***************************************/
+
+   // two bitmaps ORed, counted with popcount
+   void test_union_bitmaps()
+   {  // setup
+      custom::bitmap_set <uint32_t> sEven;
+      custom::bitmap_set <uint32_t> sThree;
+      for (uint32_t i = 0; i < 10000; i++)
+      {
+         sEven.insert(i * 2);
+         sThree.insert(i * 3);
+      }
+      // exercise
+      custom::bitmap_set <uint32_t> s = custom::set_union(sEven, sThree);
+      // verify
+      assertUnit(s.size() == 10000 + 10000 - 3334);   // multiples of 6 below 20000
+      assertUnit(s.contains(9));
+      assertUnit(s.contains(19998));
+      assertUnit(!s.contains(7));
+      assertUnit(sEven.size() == 10000);
+   }  // teardown
+
+   // an array against a bitmap keeps the array elements whose bits are set
+   void test_intersection_mixed()
+   {  // setup
+      custom::bitmap_set <uint32_t> sDense;
+      for (uint32_t i = 0; i < 10000; i++)
+         sDense.insert(i * 2);
+      custom::bitmap_set <uint32_t> sSparse { 3, 4, 10, 11, 0x00070000 };
+      // exercise
+      custom::bitmap_set <uint32_t> s = custom::set_intersection(sDense, sSparse);
+      // verify
+      assertUnit(s.size() == 2);
+      assertUnit(s.chunks.size() == 1);
+      assertUnit(!s.chunks[0].isBitmap());
+      assertUnit(*s.begin() == 4);
+      assertUnit(s.back() == 10);
+   }  // teardown
+
+   // two bitmaps ANDed down to a few become an array
+   void test_intersection_toArray()
+   {  // setup
+      custom::bitmap_set <uint32_t> sEven;
+      custom::bitmap_set <uint32_t> sOdd;
+      for (uint32_t i = 0; i < 10000; i++)
+      {
+         sEven.insert(i * 2);
+         sOdd.insert(i * 2 + 1);
+      }
+      sOdd.insert(100);
+      // exercise
+      sEven.retain(sOdd);
+      // verify
+      assertUnit(sEven.size() == 1);
+      assertUnit(!sEven.chunks[0].isBitmap());
+      assertUnit(sEven.front() == 100);
+   }  // teardown
+};
+
+#endif // DEBUG
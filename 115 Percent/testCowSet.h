@@ -0,0 +1,283 @@
+/***********************************************************************
+ * Header:
+ *    TEST COPY-ON-WRITE SET
+ * Summary:
+ *    Unit tests for cow_set
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "cowSet.h"
+#include "unitTest.h"
+#include "spy.h"
+
+#include <iostream>
+#include <cassert>
+
+class TestCowSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructCopy_shares();
+      test_assign_shares();
+
+      // Read
+      test_read_staysShared();
+
+      // Write
+      test_insert_detaches();
+      test_insert_duplicateStaysShared();
+      test_insert_unique();
+      test_erase_detaches();
+      test_eraseIterator_fromBeforeDetach();
+      test_eraseRange_fromBeforeDetach();
+      test_eraseIterator_fromBeforeInsert();
+      test_clear_shared();
+      test_release_last();
+
+      report("CowSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, no allocations
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::cow_set <Spy> s;
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(s.pShared == nullptr);
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // a copy shares the tree rather than copying a single element
+   void test_constructCopy_shares()
+   {  // setup
+      custom::cow_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      Spy::reset();
+      // exercise
+      custom::cow_set <Spy> sCopy(s);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(sCopy.pShared == s.pShared);
+      assertUnit(s.pShared->numCopies == 2);
+      assertUnit(s.shared());
+      assertUnit(sCopy.size() == 3);
+   }  // teardown
+
+   // so does an assignment, letting go of the old tree
+   void test_assign_shares()
+   {  // setup
+      custom::cow_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      custom::cow_set <Spy> sDest { Spy(10) };
+      Spy::reset();
+      // exercise
+      sDest = s;
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numDestructor() == 1);   // [10]
+      assertUnit(sDest.pShared == s.pShared);
+      assertUnit(sDest.size() == 3);
+   }  // teardown
+
+   /***************************************
+    * READ
+    ***************************************/
+
+   // reading a copy never detaches it
+   void test_read_staysShared()
+   {  // setup
+      custom::cow_set <int> s { 50, 30, 70 };
+      custom::cow_set <int> sCopy(s);
+      // exercise
+      bool found = sCopy.contains(30);
+      auto it = sCopy.lower_bound(40);
+      size_t num = 0;
+      for (auto itCount = sCopy.begin(); itCount != sCopy.end(); ++itCount)
+         num++;
+      // verify
+      assertUnit(found);
+      assertUnit(*it == 50);
+      assertUnit(num == 3);
+      assertUnit(sCopy.pShared == s.pShared);
+      assertUnit(sCopy == s);
+   }  // teardown
+
+   /***************************************
+    * WRITE
+    ***************************************/
+
+   // the first change to a shared copy copies the tree, once
+   void test_insert_detaches()
+   {  // setup
+      custom::cow_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      custom::cow_set <Spy> sCopy(s);
+      Spy s40(40);
+      Spy s60(60);
+      Spy::reset();
+      // exercise
+      sCopy.insert(s40);
+      sCopy.insert(s60);
+      // verify
+      assertUnit(Spy::numCopy() == 5);   // [50][30][70] detaching, then [40] and [60]
+      assertUnit(sCopy.pShared != s.pShared);
+      assertUnit(!s.shared());
+      assertUnit(!sCopy.shared());
+      assertUnit(sCopy.size() == 5);
+      assertUnit(s.size() == 3);
+      assertUnit(!s.contains(Spy(40)));
+   }  // teardown
+
+   // inserting what is already there changes nothing, so copies nothing
+   void test_insert_duplicateStaysShared()
+   {  // setup
+      custom::cow_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      custom::cow_set <Spy> sCopy(s);
+      Spy::reset();
+      // exercise
+      auto p = sCopy.insert(Spy(30));
+      // verify
+      assertUnit(p.second == false);
+      assertUnit(*p.first == Spy(30));
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(sCopy.pShared == s.pShared);
+   }  // teardown
+
+   // a copy nobody shares is changed in place
+   void test_insert_unique()
+   {  // setup
+      custom::cow_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      auto pShared = s.pShared;
+      Spy s40(40);
+      Spy::reset();
+      // exercise
+      s.insert(s40);
+      // verify
+      assertUnit(Spy::numCopy() == 1);   // [40]
+      assertUnit(s.pShared == pShared);
+      assertUnit(s.size() == 4);
+   }  // teardown
+
+   // erasing from a copy leaves the other alone
+   void test_erase_detaches()
+   {  // setup
+      custom::cow_set <int> s { 50, 30, 70 };
+      custom::cow_set <int> sCopy(s);
+      // exercise
+      size_t numMissing = sCopy.erase(45);
+      size_t num = sCopy.erase(30);
+      // verify
+      assertUnit(numMissing == 0);
+      assertUnit(num == 1);
+      assertUnit(!sCopy.contains(30));
+      assertUnit(s.contains(30));
+      assertUnit(sCopy != s);
+   }  // teardown
+
+   // an iterator into the shared tree still names the element to erase
+   void test_eraseIterator_fromBeforeDetach()
+   {  // setup
+      custom::cow_set <int> s { 50, 30, 70 };
+      custom::cow_set <int> sCopy(s);
+      auto it = sCopy.find(50);
+      // exercise
+      auto itNext = sCopy.erase(it);
+      // verify
+      assertUnit(*itNext == 70);
+      assertUnit(itNext == sCopy.find(70));
+      assertUnit(sCopy.size() == 2);
+      assertUnit(s.size() == 3);
+      assertUnit(s.contains(50));
+   }  // teardown
+
+   // so do the ends of a range
+   void test_eraseRange_fromBeforeDetach()
+   {  // setup
+      custom::cow_set <int> s { 20, 30, 40, 50, 60, 70, 80 };
+      custom::cow_set <int> sCopy(s);
+      auto itBegin = sCopy.find(30);
+      auto itEnd = sCopy.end();
+      // exercise
+      auto itReturn = sCopy.erase(itBegin, itEnd);
+      // verify
+      assertUnit(itReturn == sCopy.end());
+      assertUnit(sCopy.size() == 1);
+      assertUnit(*sCopy.begin() == 20);
+      assertUnit(s.size() == 7);
+   }  // teardown
+
+   // an insert detached the copy before the erase: the iterator is still
+   // into the tree the other copy keeps, which must be left alone
+   void test_eraseIterator_fromBeforeInsert()
+   {  // setup
+      custom::cow_set <int> a { 1, 2, 3 };
+      custom::cow_set <int> b(a);
+      auto it = b.find(2);
+      b.insert(4);
+      // exercise
+      auto itNext = b.erase(it);
+      // verify
+      assertUnit(*itNext == 3);
+      assertUnit(a.size() == 3);
+      int expectedA[] = { 1, 2, 3 };
+      int i = 0;
+      for (auto itA = a.begin(); itA != a.end() && i < 4; ++itA, i++)
+         assertUnit(i < 3 && *itA == expectedA[i]);
+      assertUnit(i == 3);
+      assertUnit(b.size() == 3);
+      int expectedB[] = { 1, 3, 4 };
+      i = 0;
+      for (auto itB = b.begin(); itB != b.end() && i < 4; ++itB, i++)
+         assertUnit(i < 3 && *itB == expectedB[i]);
+      assertUnit(i == 3);
+      b.insert(5);
+      assertUnit(b.size() == 4);
+   }  // teardown
+
+   // clearing a shared copy leaves the tree to the others
+   void test_clear_shared()
+   {  // setup
+      custom::cow_set <int, std::greater<int>> s(std::greater<int>{});
+      s.insert({ 50, 30, 70 });
+      custom::cow_set <int, std::greater<int>> sCopy(s);
+      // exercise
+      sCopy.clear();
+      sCopy.insert(10);
+      sCopy.insert(20);
+      // verify
+      assertUnit(s.size() == 3);
+      assertUnit(sCopy.size() == 2);
+      assertUnit(*sCopy.begin() == 20);   // still ordered by greater
+   }  // teardown
+
+   // the last copy to go frees the tree
+   void test_release_last()
+   {  // setup
+      custom::cow_set <Spy> * pS = new custom::cow_set <Spy> { Spy(50), Spy(30), Spy(70) };
+      custom::cow_set <Spy> * pCopy = new custom::cow_set <Spy> (*pS);
+      Spy::reset();
+      // exercise
+      delete pS;
+      int numAfterFirst = Spy::numDestructor();
+      delete pCopy;
+      // verify
+      assertUnit(numAfterFirst == 0);
+      assertUnit(Spy::numDestructor() == 3);
+   }  // teardown
+};
+
+#endif // DEBUG
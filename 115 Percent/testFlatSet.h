@@ -0,0 +1,273 @@
+/***********************************************************************
+ * Header:
+ *    TEST FLAT SET
+ * Summary:
+ *    Unit tests for flat_set
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "flatSet.h"
+#include "unitTest.h"
+#include "spy.h"
+
+#include <iostream>
+#include <vector>
+#include <cassert>
+
+class TestFlatSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_initializerList();
+      test_construct_greater();
+
+      // Insert
+      test_insert_middle();
+      test_insert_endNoShift();
+      test_insert_duplicate();
+      test_insertRange_merge();
+      test_insertRange_duplicates();
+
+      // Access
+      test_find_standard();
+      test_bounds_standard();
+      test_bounds_empty();
+      test_iterate_backwards();
+
+      // Erase
+      test_erase_standard();
+      test_eraseRange_standard();
+
+      report("FlatSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, no allocations
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::flat_set <Spy> s;
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(s.data.empty());
+      assertUnit(s.capacity() == 0);
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // in order whatever order they came in, one array
+   void test_construct_initializerList()
+   {  // setup
+      // exercise
+      custom::flat_set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      // verify
+      assertUnit(s.size() == 7);
+      for (size_t i = 0; i < 7; i++)
+         assertUnit(s.data[i] == 20 + 10 * (int)i);
+   }  // teardown
+
+   // ordered by the comparison it is given
+   void test_construct_greater()
+   {  // setup
+      custom::flat_set <int, std::greater<int>> s(std::greater<int>{});
+      // exercise
+      s.insert({ 50, 30, 70 });
+      s.insert(60);
+      // verify
+      assertUnit(s.front() == 70);
+      assertUnit(s.back() == 30);
+      assertUnit(*s.lower_bound(65) == 60);
+      assertUnit(*s.upper_bound(60) == 50);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // one element goes in its place, shifting the larger ones
+   void test_insert_middle()
+   {  // setup
+      custom::flat_set <int> s { 20, 40, 60 };
+      // exercise
+      auto p = s.insert(50);
+      // verify
+      assertUnit(p.second);
+      assertUnit(*p.first == 50);
+      assertUnit(p.first - s.begin() == 2);
+      assertUnit(s.size() == 4);
+      assertUnit(s.data[3] == 60);
+   }  // teardown
+
+   // an element larger than the rest moves nothing
+   void test_insert_endNoShift()
+   {  // setup
+      custom::flat_set <Spy> s;
+      s.reserve(10);
+      s.insert({ Spy(20), Spy(40), Spy(60) });
+      Spy s80(80);
+      Spy::reset();
+      // exercise
+      auto p = s.insert(s80);
+      // verify
+      assertUnit(p.second);
+      assertUnit(Spy::numCopy() == 1);    // [80]
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(s.back() == Spy(80));
+   }  // teardown
+
+   // a duplicate changes nothing and copies nothing
+   void test_insert_duplicate()
+   {  // setup
+      custom::flat_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      Spy s30(30);
+      Spy::reset();
+      // exercise
+      auto p = s.insert(s30);
+      // verify
+      assertUnit(p.second == false);
+      assertUnit(*p.first == Spy(30));
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // a batch is sorted on its own and merged in
+   void test_insertRange_merge()
+   {  // setup
+      custom::flat_set <int> s { 10, 30, 50, 70 };
+      std::vector <int> v { 60, 20, 80, 40 };
+      // exercise
+      s.insert(v.begin(), v.end());
+      // verify
+      assertUnit(s.size() == 8);
+      for (size_t i = 0; i < 8; i++)
+         assertUnit(s.data[i] == 10 + 10 * (int)i);
+   }  // teardown
+
+   // duplicates within the batch and with the set are dropped
+   void test_insertRange_duplicates()
+   {  // setup
+      custom::flat_set <int> s { 10, 30, 50 };
+      std::vector <int> v { 30, 20, 20, 50, 60, 10 };
+      // exercise
+      s.insert(v.begin(), v.end());
+      // verify
+      assertUnit(s.size() == 5);
+      assertUnit(s.data[0] == 10);
+      assertUnit(s.data[1] == 20);
+      assertUnit(s.data[2] == 30);
+      assertUnit(s.data[3] == 50);
+      assertUnit(s.data[4] == 60);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // find what is there and not what is not, at either end and between
+   void test_find_standard()
+   {  // setup
+      custom::flat_set <int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i * 2);
+      // exercise and verify
+      for (int i = -1; i < 201; i++)
+      {
+         auto it = s.find(i);
+         if (i >= 0 && i < 200 && i % 2 == 0)
+            assertUnit(it != s.end() && *it == i);
+         else
+            assertUnit(it == s.end());
+      }
+   }  // teardown
+
+   // the first element not less than, and the first greater than
+   void test_bounds_standard()
+   {  // setup
+      custom::flat_set <int> s { 20, 30, 40, 50, 60, 70, 80 };
+      // exercise and verify
+      assertUnit(*s.lower_bound(45) == 50);
+      assertUnit(*s.lower_bound(50) == 50);
+      assertUnit(*s.upper_bound(50) == 60);
+      assertUnit(s.lower_bound(10) == s.begin());
+      assertUnit(s.lower_bound(85) == s.end());
+      assertUnit(s.upper_bound(80) == s.end());
+      auto range = s.equal_range(40);
+      assertUnit(*range.first == 40 && *range.second == 50);
+      range = s.equal_range(45);
+      assertUnit(range.first == range.second);
+   }  // teardown
+
+   // nothing to find in nothing
+   void test_bounds_empty()
+   {  // setup
+      custom::flat_set <int> s;
+      // exercise and verify
+      assertUnit(s.lower_bound(50) == s.end());
+      assertUnit(s.upper_bound(50) == s.end());
+      assertUnit(s.find(50) == s.end());
+   }  // teardown
+
+   // largest to smallest
+   void test_iterate_backwards()
+   {  // setup
+      custom::flat_set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      int expected = 80;
+      // exercise
+      for (auto it = s.rbegin(); it != s.rend(); ++it, expected -= 10)
+         // verify
+         assertUnit(*it == expected);
+      assertUnit(expected == 10);
+   }  // teardown
+
+   /***************************************
+    * ERASE
+    ***************************************/
+
+   // erase by element and by iterator, getting the one after
+   void test_erase_standard()
+   {  // setup
+      custom::flat_set <int> s { 20, 30, 40, 50 };
+      // exercise
+      auto it = s.erase(s.find(30));
+      size_t numMissing = s.erase(30);
+      size_t num = s.erase(50);
+      // verify
+      assertUnit(*it == 40);
+      assertUnit(numMissing == 0);
+      assertUnit(num == 1);
+      assertUnit(s.size() == 2);
+      assertUnit(s.data[0] == 20 && s.data[1] == 40);
+   }  // teardown
+
+   // erase a run in the middle
+   void test_eraseRange_standard()
+   {  // setup
+      custom::flat_set <int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      // exercise
+      auto it = s.erase(s.find(20), s.find(80));
+      // verify
+      assertUnit(*it == 80);
+      assertUnit(s.size() == 40);
+      assertUnit(*(s.find(80) - 1) == 19);
+   }  // teardown
+};
+
+#endif // DEBUG
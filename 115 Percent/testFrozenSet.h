@@ -0,0 +1,274 @@
+/***********************************************************************
+ * Header:
+ *    TEST FROZEN SET
+ * Summary:
+ *    Unit tests for frozen_set
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "frozenSet.h"
+#include "unitTest.h"
+#include "spy.h"
+
+#include <iostream>
+#include <vector>
+#include <cassert>
+
+class TestFrozenSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_seven();
+      test_construct_ten();
+
+      // Access
+      test_find_standard();
+      test_find_every();
+      test_bounds_standard();
+      test_bounds_greater();
+      test_find_wideElements();
+      test_prefetch_distance();
+
+      // Iterate
+      test_iterate_forward();
+      test_iterate_backwards();
+      test_iterate_one();
+
+      report("FrozenSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, no allocations
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::frozen_set <Spy> s;
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(s.data.empty());
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+      assertUnit(s.find(Spy(50)) == s.end());
+   }  // teardown
+
+   // a full tree goes in level by level
+   //                 50
+   //          +-------+-------+
+   //         30              70
+   //     +----+----+     +----+----+
+   //    20        40    60        80
+   void test_construct_seven()
+   {  // setup
+      std::vector <int> v { 20, 30, 40, 50, 60, 70, 80 };
+      // exercise
+      custom::frozen_set <int> s(v.begin(), v.end());
+      // verify
+      assertUnit(s.size() == 7);
+      assertUnit(s.data[0] == 50);
+      assertUnit(s.data[1] == 30);
+      assertUnit(s.data[2] == 70);
+      assertUnit(s.data[3] == 20);
+      assertUnit(s.data[4] == 40);
+      assertUnit(s.data[5] == 60);
+      assertUnit(s.data[6] == 80);
+   }  // teardown
+
+   // a tree with a partial bottom level fills it from the left
+   //                      6
+   //            +---------+---------+
+   //            3                   8
+   //       +----+----+         +----+----+
+   //       1         5         7         9
+   //     +-+-+     +-+
+   //     0   2     4
+   void test_construct_ten()
+   {  // setup
+      std::vector <int> v { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+      // exercise
+      custom::frozen_set <int> s(v.begin(), v.size());
+      // verify
+      int expected[] = { 6, 3, 8, 1, 5, 7, 9, 0, 2, 4 };
+      assertUnit(s.size() == 10);
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(s.data[i] == expected[i]);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // find what is there and not what is not
+   void test_find_standard()
+   {  // setup
+      std::vector <int> v { 20, 30, 40, 50, 60, 70, 80 };
+      custom::frozen_set <int> s(v.begin(), v.end());
+      // exercise and verify
+      assertUnit(*s.find(40) == 40);
+      assertUnit(s.find(45) == s.end());
+      assertUnit(s.find(10) == s.end());
+      assertUnit(s.find(90) == s.end());
+      assertUnit(s.contains(80));
+      assertUnit(s.count(60) == 1);
+   }  // teardown
+
+   // every size up to a few levels, every element and every gap
+   void test_find_every()
+   {  // setup
+      bool found = true;
+      for (int num = 0; num < 40; num++)
+      {
+         std::vector <int> v;
+         for (int i = 0; i < num; i++)
+            v.push_back(i * 2);
+         // exercise
+         custom::frozen_set <int> s(v.begin(), v.end());
+         for (int i = -1; i <= num * 2; i++)
+         {
+            auto it = s.find(i);
+            if (i >= 0 && i % 2 == 0 && i < num * 2)
+               found = found && it != s.end() && *it == i;
+            else
+               found = found && it == s.end();
+         }
+      }
+      // verify
+      assertUnit(found);
+   }  // teardown
+
+   // elements of a size that does not divide a cache line
+   struct Triple
+   {
+      int a, b, c;
+      bool operator <  (const Triple & rhs) const { return a < rhs.a; }
+      bool operator == (const Triple & rhs) const { return a == rhs.a; }
+   };
+   void test_find_wideElements()
+   {  // setup
+      std::vector <Triple> v;
+      for (int i = 0; i < 1000; i++)
+         v.push_back(Triple { i * 2, i, -i });
+      custom::frozen_set <Triple> s(v.begin(), v.end());
+      // exercise
+      bool found = true;
+      for (int i = -1; i <= 2000; i++)
+      {
+         auto it = s.find(Triple { i, 0, 0 });
+         if (i >= 0 && i % 2 == 0 && i < 2000)
+            found = found && it != s.end() && (*it).b == i / 2;
+         else
+            found = found && it == s.end();
+      }
+      // verify
+      assertUnit(found);
+   }  // teardown
+
+   // the prefetch only reaches descendants of k a power of two ahead,
+   // and there is none at all once that would be k itself
+   struct Wide
+   {
+      char bytes[40];
+      bool operator < (const Wide & rhs) const { return bytes[0] < rhs.bytes[0]; }
+   };
+   void test_prefetch_distance()
+   {  // setup, exercise, and verify
+      assertUnit(custom::frozen_set <int> ::numAhead == 16);
+      assertUnit(custom::frozen_set <double> ::numAhead == 8);
+      assertUnit(custom::frozen_set <Triple> ::numAhead == 4);
+      assertUnit(custom::frozen_set <Wide> ::numAhead == 1);
+   }  // teardown
+
+   // the first element not less than, and the first greater than
+   void test_bounds_standard()
+   {  // setup
+      std::vector <int> v { 20, 30, 40, 50, 60, 70, 80 };
+      custom::frozen_set <int> s(v.begin(), v.end());
+      // exercise and verify
+      assertUnit(*s.lower_bound(45) == 50);
+      assertUnit(*s.lower_bound(50) == 50);
+      assertUnit(*s.upper_bound(50) == 60);
+      assertUnit(*s.lower_bound(10) == 20);
+      assertUnit(s.lower_bound(10) == s.begin());
+      assertUnit(s.lower_bound(85) == s.end());
+      assertUnit(s.upper_bound(80) == s.end());
+      auto range = s.equal_range(40);
+      assertUnit(*range.first == 40 && *range.second == 50);
+   }  // teardown
+
+   // ordered by the comparison it is given
+   void test_bounds_greater()
+   {  // setup
+      std::vector <int> v { 80, 70, 60, 50, 40, 30, 20 };
+      custom::frozen_set <int, std::greater<int>> s(v.begin(), v.end(), std::greater<int>{});
+      // exercise and verify
+      assertUnit(s.front() == 80);
+      assertUnit(s.back() == 20);
+      assertUnit(*s.lower_bound(65) == 60);
+      assertUnit(*s.upper_bound(60) == 50);
+   }  // teardown
+
+   /***************************************
+    * ITERATE
+    ***************************************/
+
+   // smallest to largest, jumping about the array
+   void test_iterate_forward()
+   {  // setup
+      std::vector <int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i);
+      custom::frozen_set <int> s(v.begin(), v.end());
+      int expected = 0;
+      // exercise
+      for (auto it = s.begin(); it != s.end(); ++it, expected++)
+         // verify
+         assertUnit(*it == expected);
+      assertUnit(expected == 100);
+   }  // teardown
+
+   // largest to smallest
+   void test_iterate_backwards()
+   {  // setup
+      std::vector <int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i);
+      custom::frozen_set <int> s(v.begin(), v.end());
+      int expected = 99;
+      // exercise
+      for (auto it = s.rbegin(); it != s.rend(); --it, expected--)
+         // verify
+         assertUnit(*it == expected);
+      assertUnit(expected == -1);
+   }  // teardown
+
+   // one element is both ends
+   void test_iterate_one()
+   {  // setup
+      std::vector <int> v { 50 };
+      custom::frozen_set <int> s(v.begin(), v.end());
+      // exercise
+      auto it = s.begin();
+      auto itNext = it;
+      ++itNext;
+      // verify
+      assertUnit(*it == 50);
+      assertUnit(it == s.rbegin());
+      assertUnit(itNext == s.end());
+      assertUnit(s.front() == 50 && s.back() == 50);
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,494 @@
+/***********************************************************************
+ * Header:
+ *    TEST PERSISTENT SET
+ * Summary:
+ *    Unit tests for persistent_set
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "persistentSet.h"
+#include "unitTest.h"
+#include "spy.h"
+
+#include <iostream>
+#include <cassert>
+
+class TestPersistentSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_initializerList();
+      test_constructCopy_shares();
+
+      // Snapshot
+      test_snapshot_insertAfter();
+      test_snapshot_eraseAfter();
+      test_snapshot_pathCopied();
+      test_snapshot_release();
+
+      // Access
+      test_find_standard();
+      test_lowerBound_standard();
+      test_upperBound_standard();
+      test_equalRange_standard();
+
+      // Iterator
+      test_iterator_tall();
+
+      // Insert and erase
+      test_insert_duplicate();
+      test_insert_balanced();
+      test_insert_returnsIterator();
+      test_emplace_noCopy();
+      test_erase_missing();
+      test_erase_many();
+      test_erase_iterator();
+      test_erase_range();
+
+      // Compare
+      test_compare_snapshot();
+      test_compare_relative();
+
+      report("PersistentSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, no allocations
+   void test_construct_default()
+   {  // setup
+      Spy::reset();
+      // exercise
+      custom::persistent_set <Spy> s;
+      // verify
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(s.root.get() == nullptr);
+      assertUnit(s.size() == 0);
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // in order whatever order they came in
+   void test_construct_initializerList()
+   {  // setup
+      // exercise
+      custom::persistent_set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      // verify
+      int expected = 20;
+      for (auto it = s.begin(); it != s.end(); ++it, expected += 10)
+         assertUnit(*it == expected);
+      assertUnit(expected == 90);
+      assertUnit(s.size() == 7);
+      assertUnit(s.root->height == 3);
+   }  // teardown
+
+   // a copy shares the tree rather than copying a single element
+   void test_constructCopy_shares()
+   {  // setup
+      custom::persistent_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      Spy::reset();
+      // exercise
+      custom::persistent_set <Spy> sCopy(s);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(sCopy.root.get() == s.root.get());
+      assertUnit(s.root->numRefs == 2);
+      assertUnit(sCopy.size() == 3);
+   }  // teardown
+
+   /***************************************
+    * SNAPSHOT
+    ***************************************/
+
+   // an insert after the snapshot is not seen by it
+   void test_snapshot_insertAfter()
+   {  // setup
+      custom::persistent_set <int> s { 20, 30, 40 };
+      custom::persistent_set <int> sSnap = s.snapshot();
+      // exercise
+      s.insert(35);
+      // verify
+      assertUnit(s.size() == 4);
+      assertUnit(s.contains(35));
+      assertUnit(sSnap.size() == 3);
+      assertUnit(!sSnap.contains(35));
+   }  // teardown
+
+   // nor is an erase
+   void test_snapshot_eraseAfter()
+   {  // setup
+      custom::persistent_set <int> s { 20, 30, 40 };
+      custom::persistent_set <int> sSnap = s.snapshot();
+      // exercise
+      s.erase(30);
+      // verify
+      assertUnit(!s.contains(30));
+      assertUnit(sSnap.contains(30));
+      int expected = 20;
+      for (auto it = sSnap.begin(); it != sSnap.end(); ++it, expected += 10)
+         assertUnit(*it == expected);
+      assertUnit(expected == 50);
+   }  // teardown
+
+   // only the path down to the change is copied
+   //                 50
+   //          +-------+-------+
+   //         30              70
+   //     +----+----+     +----+----+
+   //    20        40    60        80
+   void test_snapshot_pathCopied()
+   {  // setup
+      custom::persistent_set <Spy> s { Spy(50), Spy(30), Spy(70), Spy(20), Spy(40), Spy(60), Spy(80) };
+      custom::persistent_set <Spy> sSnap = s.snapshot();
+      Spy::reset();
+      // exercise
+      s.insert(Spy(45));
+      // verify
+      assertUnit(Spy::numCopy() == 3);     // copies of [40][30][50]
+      assertUnit(Spy::numCopyMove() == 1); // [45] moved into its node
+      assertUnit(s.root.get() != sSnap.root.get());
+      assertUnit(s.root->pRight.get() == sSnap.root->pRight.get());             // [70] shared
+      assertUnit(s.root->pLeft->pLeft.get() == sSnap.root->pLeft->pLeft.get()); // [20] shared
+      assertUnit(sSnap.root->pRight->numRefs == 2);
+   }  // teardown
+
+   // the old version goes away when its last holder lets go
+   void test_snapshot_release()
+   {  // setup
+      custom::persistent_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      {
+         custom::persistent_set <Spy> sSnap = s.snapshot();
+         s.erase(Spy(50));
+         Spy::reset();
+      }  // exercise: sSnap goes out of scope
+      // verify
+      assertUnit(Spy::numDestructor() == 2);   // the old [50] and [70]: [30] is still used
+      assertUnit(s.size() == 2);
+      assertUnit(s.root->numRefs == 1);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // find what is there and not what is not
+   void test_find_standard()
+   {  // setup
+      custom::persistent_set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      // exercise and verify
+      assertUnit(*s.find(40) == 40);
+      assertUnit(s.find(45) == s.end());
+      assertUnit(s.count(80) == 1);
+      auto it = s.find(40);
+      ++it;
+      assertUnit(*it == 50);
+   }  // teardown
+
+   // the first element not less than a key
+   void test_lowerBound_standard()
+   {  // setup
+      custom::persistent_set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      // exercise and verify
+      assertUnit(*s.lower_bound(45) == 50);
+      assertUnit(*s.lower_bound(50) == 50);
+      assertUnit(s.lower_bound(10) == s.begin());
+      assertUnit(s.lower_bound(85) == s.end());
+      auto it = s.lower_bound(65);
+      assertUnit(*it++ == 70);
+      assertUnit(*it++ == 80);
+      assertUnit(it == s.end());
+   }  // teardown
+
+   // the first element greater than a key
+   void test_upperBound_standard()
+   {  // setup
+      custom::persistent_set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      // exercise and verify
+      assertUnit(*s.upper_bound(45) == 50);
+      assertUnit(*s.upper_bound(50) == 60);
+      assertUnit(s.upper_bound(10) == s.begin());
+      assertUnit(s.upper_bound(80) == s.end());
+      auto it = s.upper_bound(60);
+      assertUnit(*it++ == 70);
+      assertUnit(*it++ == 80);
+      assertUnit(it == s.end());
+   }  // teardown
+
+   // one element or none
+   void test_equalRange_standard()
+   {  // setup
+      custom::persistent_set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      auto range40 = s.equal_range(40);
+      auto range45 = s.equal_range(45);
+      auto range80 = s.equal_range(80);
+      // verify
+      assertUnit(*range40.first == 40);
+      assertUnit(*range40.second == 50);
+      assertUnit(range45.first == range45.second);
+      assertUnit(*range45.first == 50);
+      assertUnit(*range80.first == 80);
+      assertUnit(range80.second == s.end());
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // a tree too tall for the path kept in the iterator: copies made
+   // part way along carry on from the same place
+   void test_iterator_tall()
+   {  // setup
+      custom::persistent_set <int> s;
+      for (int i = 0; i < 5000; i++)
+         s.insert(i);
+      using Iterator = custom::persistent_set <int> :: iterator;
+      // exercise
+      Iterator it = s.begin();
+      for (int i = 0; i < 1234; i++)
+         ++it;
+      Iterator itCopy(it);
+      Iterator itAssign;
+      itAssign = it;
+      Iterator itMove(std::move(itCopy));
+      bool inOrder = true;
+      int expected = 1234;
+      for (; itMove != s.end(); ++itMove)
+         inOrder = inOrder && *itMove == expected++;
+      // verify
+      assertUnit(sizeof(Iterator) <= 128);
+      assertUnit(s.root->height > Iterator::numInline);
+      assertUnit(it.path != it.inlinePath);
+      assertUnit(*it == 1234);
+      assertUnit(*itAssign == 1234);
+      assertUnit(inOrder);
+      assertUnit(expected == 5000);
+   }  // teardown
+
+   /***************************************
+    * INSERT AND ERASE
+    ***************************************/
+
+   // a duplicate changes nothing and copies nothing
+   void test_insert_duplicate()
+   {  // setup
+      custom::persistent_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      const void * pRoot = s.root.get();
+      Spy::reset();
+      // exercise
+      bool inserted = s.insert(Spy(30)).second;
+      // verify
+      assertUnit(inserted == false);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(s.root.get() == pRoot);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // ascending inserts keep the tree short
+   void test_insert_balanced()
+   {  // setup
+      custom::persistent_set <int> s;
+      // exercise
+      for (int i = 0; i < 1023; i++)
+         s.insert(i);
+      // verify
+      assertUnit(s.size() == 1023);
+      assertUnit(s.root->height <= 14);   // 1.44 log2(1023 + 2)
+      assertUnit(verifyAVL(s.root.get()) == s.root->height);
+   }  // teardown
+
+   // the iterator is to the element in the new version, after any
+   // rotations copied its node
+   void test_insert_returnsIterator()
+   {  // setup
+      custom::persistent_set <int> s;
+      bool found = true;
+      // exercise
+      for (int i = 0; i < 200; i++)
+      {
+         auto result = s.insert(i);
+         found = found && result.second && *result.first == i;
+         ++result.first;
+         found = found && result.first == s.end();
+      }
+      auto duplicate = s.insert(100);
+      // verify
+      assertUnit(found);
+      assertUnit(!duplicate.second);
+      assertUnit(*duplicate.first == 100);
+      assertUnit(s.size() == 200);
+   }  // teardown
+
+   // an element built in place is moved into its node, never copied:
+   // the only copies are of the path above it
+   void test_emplace_noCopy()
+   {  // setup
+      custom::persistent_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      Spy spy40(40);
+      Spy::reset();
+      // exercise
+      auto result = s.emplace(20);
+      s.insert(std::move(spy40));
+      int numNondefault = Spy::numNondefault();
+      int numCopyMove = Spy::numCopyMove();
+      // verify
+      assertUnit(numNondefault == 1);  // [20]
+      assertUnit(numCopyMove == 2);    // [20] and [40] into their nodes
+      assertUnit(result.second);
+      assertUnit(s.size() == 5);
+      assertUnit(s.contains(Spy(40)));
+   }  // teardown
+
+   // erasing what is not there leaves the tree alone
+   void test_erase_missing()
+   {  // setup
+      custom::persistent_set <int> s { 50, 30, 70 };
+      const void * pRoot = s.root.get();
+      // exercise
+      size_t num = s.erase(45);
+      // verify
+      assertUnit(num == 0);
+      assertUnit(s.root.get() == pRoot);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // erase most of a tree, keeping a snapshot of every hundredth version
+   void test_erase_many()
+   {  // setup
+      custom::persistent_set <int> s;
+      for (int i = 0; i < 500; i++)
+         s.insert((i * 37) % 500);
+      custom::persistent_set <int> sSnaps[5];
+      // exercise
+      for (int i = 0; i < 500; i++)
+      {
+         if (i % 100 == 0)
+            sSnaps[i / 100] = s;
+         s.erase(i);
+      }
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.root.get() == nullptr);
+      for (int i = 0; i < 5; i++)
+      {
+         assertUnit(sSnaps[i].size() == (size_t)(500 - 100 * i));
+         assertUnit(*sSnaps[i].begin() == 100 * i);
+         assertUnit(verifyAVL(sSnaps[i].root.get()) == sSnaps[i].root->height);
+      }
+   }  // teardown
+
+   // erase through an iterator: the next one is in the new version,
+   // and the old version is untouched
+   void test_erase_iterator()
+   {  // setup
+      custom::persistent_set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      custom::persistent_set <int> sSnap = s.snapshot();
+      // exercise
+      auto it = s.erase(s.find(40));
+      auto itEnd = s.erase(s.find(80));
+      // verify
+      assertUnit(*it == 50);
+      assertUnit(itEnd == s.end());
+      assertUnit(s.size() == 5);
+      assertUnit(!s.contains(40));
+      assertUnit(sSnap.size() == 7);
+      assertUnit(sSnap.contains(40));
+      assertUnit(verifyAVL(s.root.get()) == s.root->height);
+   }  // teardown
+
+   // erase a range from the only version there is: the nodes the
+   // iterators are on must last until the end
+   void test_erase_range()
+   {  // setup
+      custom::persistent_set <Spy> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(Spy(i));
+      // exercise
+      auto it = s.erase(s.lower_bound(Spy(20)), s.lower_bound(Spy(80)));
+      bool onNext = *it == Spy(80);
+      auto itEnd = s.erase(s.lower_bound(Spy(90)), s.end());
+      // verify
+      assertUnit(onNext);
+      assertUnit(itEnd == s.end());
+      assertUnit(s.size() == 30);
+      assertUnit(!s.contains(Spy(20)) && !s.contains(Spy(79)) && !s.contains(Spy(95)));
+      assertUnit(s.contains(Spy(19)) && s.contains(Spy(80)) && s.contains(Spy(89)));
+      assertUnit(verifyAVL(s.root.get()) == s.root->height);
+   }  // teardown
+
+   /***************************************
+    * COMPARE
+    ***************************************/
+
+   // a snapshot is equal to its version without a look at an element
+   void test_compare_snapshot()
+   {  // setup
+      custom::persistent_set <Spy> s { Spy(50), Spy(30), Spy(70) };
+      custom::persistent_set <Spy> sSnap = s.snapshot();
+      custom::persistent_set <Spy> sSame { Spy(30), Spy(50), Spy(70) };
+      Spy::reset();
+      // exercise
+      bool equal = (s == sSnap);
+      bool less = (s < sSnap);
+      // verify
+      assertUnit(equal);
+      assertUnit(!less);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(Spy::numLessthan() == 0);
+      assertUnit(s == sSame);
+      s.erase(Spy(70));
+      assertUnit(s != sSnap);
+   }  // teardown
+
+   // lexicographic order, the shorter first when one is a prefix
+   void test_compare_relative()
+   {  // setup
+      custom::persistent_set <int> s1 { 10, 20, 30 };
+      custom::persistent_set <int> s2 { 10, 20, 40 };
+      custom::persistent_set <int> s3 { 10, 20 };
+      // exercise and verify
+      assertUnit(s1 < s2);
+      assertUnit(s2 > s1);
+      assertUnit(s3 < s1);
+      assertUnit(s1 <= s1);
+      assertUnit(s2 >= s3);
+      assertUnit(!(s2 < s1));
+   }  // teardown
+
+   /**************************************************************
+    * VERIFY AVL
+    * The height of a subtree whose heights are all right and balanced,
+    * and whose elements are in order. -1 if not
+    *************************************************************/
+   template <class PNode>
+   int verifyAVL(const PNode * pNode)
+   {
+      if (pNode == nullptr)
+         return 0;
+      int heightLeft  = verifyAVL(pNode->pLeft.get());
+      int heightRight = verifyAVL(pNode->pRight.get());
+      if (heightLeft < 0 || heightRight < 0 ||
+          heightLeft > heightRight + 1 || heightRight > heightLeft + 1)
+         return -1;
+      if ((pNode->pLeft  && !(pNode->pLeft->data  < pNode->data)) ||
+          (pNode->pRight && !(pNode->data < pNode->pRight->data)))
+         return -1;
+      int height = 1 + (heightLeft > heightRight ? heightLeft : heightRight);
+      return height == pNode->height ? height : -1;
+   }
+};
+
+#endif // DEBUG
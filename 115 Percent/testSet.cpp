@@ -15,6 +15,12 @@
 #include "testSet.h"        // for the set unit tests
 #include "testBST.h"        // for the BST unit tests
 #include "testSpy.h"        // for the spy unit tests
+#include "testPersistentSet.h" // for the persistent set unit tests
+#include "testCowSet.h"     // for the copy-on-write set unit tests
+#include "testBTreeSet.h"   // for the B-tree set unit tests
+#include "testFlatSet.h"    // for the flat set unit tests
+#include "testFrozenSet.h"  // for the frozen set unit tests
+#include "testBitmapSet.h"  // for the bitmap set unit tests
 int Spy::counters[] = {};
 
 /**********************************************************************
@@ -27,7 +33,13 @@ int main()
    // unit tests
    TestSpy().run();
    TestBST().run();
-   //TestSet().run();
+   TestPersistentSet().run();
+   TestCowSet().run();
+   TestBTreeSet().run();
+   TestFlatSet().run();
+   TestFrozenSet().run();
+   TestBitmapSet().run();
+   TestSet().run();
 #endif // DEBUG
    
    return 0;
@@ -17,11 +17,16 @@
 #include "spy.h"
 #include <set>
 #include <vector>
+#include <string>
+#include <string_view>
 
 
 #include <iostream>
 #include <cassert>
 #include <memory>
+#include <cctype>     // for std::tolower
+
+#define assertSetIs(s, expected, num) assertSetIsParameters(s, expected, num, __LINE__, __FUNCTION__)
 
 class TestSet : public UnitTest
 {
@@ -44,6 +49,9 @@ public:
       test_constructRange_empty();
       test_constructRange_one();
       test_constructRange_standard();
+      test_constructRange_sorted();
+      test_constructRange_sortedDuplicates();
+      test_constructSorted_standard();
       test_destructor_empty();
       test_destructor_standard();
 
@@ -88,6 +96,13 @@ public:
       test_find_standardBegin();
       test_find_standardLast();
       test_find_standardMissing();
+      test_find_transparent();
+      test_find_transparentString();
+      test_lowerBound_standard();
+      test_upperBound_standard();
+      test_equalRange_present();
+      test_equalRange_missing();
+      test_contains_const();
 
       // Insert
       test_insert_empty();
@@ -100,6 +115,11 @@ public:
       test_insertMove_standardFront();
       test_insertMove_standardMiddle();
       test_insertMove_standardDuplicate();
+      test_emplace_standardMiddle();
+      test_emplace_standardDuplicate();
+      test_emplaceHint_standardMiddle();
+      test_insertHint_standardMiddle();
+      test_insertHint_standardDuplicate();
       test_insertInit_emptyInsertNone();
       test_insertInit_emptyInsertMany();
       test_insertInit_standardInsertNone();
@@ -125,6 +145,9 @@ public:
       test_eraseRange_standardMany();
       test_eraseRange_oneChild();
       test_eraseRange_twoChildren();
+      test_eraseRange_long();
+      test_eraseRangeKey_standard();
+      test_eraseRangeKey_backwards();
 
       // Status
       test_empty_empty();
@@ -132,6 +155,66 @@ public:
       test_size_empty();
       test_size_standard();
 
+      // Compare
+      test_compare_greater();
+
+      // Relational
+      test_equal_same();
+      test_equal_differentSize();
+      test_equal_differentElement();
+      test_less_prefix();
+      test_less_firstDifference();
+      test_threeWay_standard();
+
+      // Set algebra
+      test_union_standard();
+      test_intersection_standard();
+      test_intersection_unbalanced();
+      test_difference_standard();
+      test_difference_unbalanced();
+      test_symmetricDifference_standard();
+      test_merge_standard();
+      test_retain_standard();
+
+      // Rank
+      test_nth_percentile();
+      test_rank_standard();
+      test_distance_standard();
+
+      // Ends
+      test_rbegin_standard();
+      test_popFront_deadlines();
+      test_popBack_standard();
+
+      // Threaded
+      test_threaded_rangeScan();
+
+      // Freeze
+      test_freeze_standard();
+
+      // Hashed
+      test_hashed_findNoCompares();
+      test_hashed_findAfterChurn();
+      test_hashed_eraseRange();
+      test_hashed_copy();
+
+      // Filter
+      test_filter_missNoCompares();
+      test_filter_stats();
+      test_filter_statsOff();
+      test_filter_rebuild();
+      test_filter_copy();
+      test_filter_defaultHash();
+      test_filter_caseBlind();
+
+      // Aggregate
+      test_aggregate_bytes();
+      test_aggregate_minMax();
+
+      // Allocator
+      test_allocator_resource();
+      test_allocator_monotonic();
+
       report("Set");
    }
    
@@ -185,6 +268,7 @@ public:
       sSrc.bst.root = new custom::BST<Spy>::BNode(Spy(50));
       sSrc.bst.root->isRed = false;
       sSrc.bst.numElements = 1;
+      sSrc.bst.resetEnds();
       Spy::reset();
       // exercise
       custom::set<Spy> sDest(sSrc);
@@ -307,6 +391,7 @@ public:
       sSrc.bst.root = new custom::BST<Spy>::BNode(Spy(50));
       sSrc.bst.root->isRed = false;
       sSrc.bst.numElements = 1;
+      sSrc.bst.resetEnds();
       Spy::reset();
       // exercise
       custom::set <Spy> sDest(std::move(sSrc));
@@ -394,8 +479,8 @@ public:
       // verify
       assertUnit(Spy::numCopy() == 7);     // copy-create [50][30][70][20][40][60][80]
       assertUnit(Spy::numAlloc() == 7);    // allocate    [50][30][70][20][40][60][80]
-      assertUnit(Spy::numLessthan() == 10);// compare 50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);  // compare 50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
+      assertUnit(Spy::numLessthan() == 15); // not sorted: [50][30], then compare 50: 30:[50] 70:[50] confirm [50] 20:[50][30] 40:[50][30] confirm [30] 60:[50][70] confirm [50] 80:[50][70] confirm [70]
+      assertUnit(Spy::numEquals() == 0);   // Compare only uses operator<
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numDefault() == 0);
       assertUnit(Spy::numNondefault() == 0);
@@ -463,9 +548,9 @@ public:
       // verify
       assertUnit(Spy::numCopy() == 7);      // copy-construct [50,30,70,20,40,60,80] 
       assertUnit(Spy::numAlloc() == 7);     // allocate [50,30,70,20,40,60,80]
-      assertUnit(Spy::numLessthan() == 10); // compare 50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);   // equal   50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);
+      assertUnit(Spy::numLessthan() == 15); // not sorted: [50][30], then compare 50: 30:[50] 70:[50] confirm [50] 20:[50][30] 40:[50][30] confirm [30] 60:[50][70] confirm [50] 80:[50][70] confirm [70]
+      assertUnit(Spy::numEquals() == 0);    // Compare only uses operator<
+      assertUnit(Spy::numEquals() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numDefault() == 0);
       assertUnit(Spy::numNondefault() == 0);
@@ -483,6 +568,103 @@ public:
       teardownStandardFixture(s);
    }
 
+   // a sorted range is built straight into a balanced tree
+   void test_constructRange_sorted()
+   {  // setup
+      std::initializer_list<Spy> il{ Spy(20), Spy(30), Spy(40), Spy(50), Spy(60), Spy(70), Spy(80) };
+      auto itBegin = il.begin();
+      auto itEnd = il.end();
+      Spy::reset();
+      // exercise
+      custom::set <Spy> s(itBegin, itEnd);
+      // verify
+      assertUnit(Spy::numCopy() == 7);      // copy-construct [20,30,40,50,60,70,80]
+      assertUnit(Spy::numAlloc() == 7);     // allocate [20,30,40,50,60,70,80]
+      assertUnit(Spy::numLessthan() == 6);  // check sorted [20][30] [30][40] [40][50] [50][60] [60][70] [70][80]
+      assertUnit(Spy::numEquals() == 0);    // Compare only uses operator<
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      // a full tree comes out all black
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20b)     (40b) (60b)     (80b)
+      assertUnit(s.bst.root != nullptr);
+      if (s.bst.root)
+      {
+         assertUnit(s.bst.root->verifyRedBlack(s.bst.root->findDepth()));
+         assertUnit(s.bst.root->findDepth() == 3);
+         s.bst.root->pLeft->pLeft->isRed = true;
+         s.bst.root->pLeft->pRight->isRed = true;
+         s.bst.root->pRight->pLeft->isRed = true;
+         s.bst.root->pRight->pRight->isRed = true;
+      }
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // a sorted range with a duplicate is inserted one at a time
+   void test_constructRange_sortedDuplicates()
+   {  // setup
+      std::initializer_list<Spy> il{ Spy(20), Spy(30), Spy(30), Spy(40) };
+      Spy::reset();
+      // exercise
+      custom::set <Spy> s(il.begin(), il.end());
+      // verify
+      assertUnit(Spy::numCopy() == 3);      // copy-construct [20,30,40]
+      assertUnit(Spy::numAlloc() == 3);     // allocate [20,30,40]
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(s.size() == 3);
+      auto it = s.begin();
+      assertUnit(it != s.end() && *it == Spy(20));
+      ++it;
+      assertUnit(it != s.end() && *it == Spy(30));
+      ++it;
+      assertUnit(it != s.end() && *it == Spy(40));
+      ++it;
+      assertUnit(it == s.end());
+   }  // teardown
+
+   // with the sorted_unique tag the range is not even checked
+   void test_constructSorted_standard()
+   {  // setup
+      std::initializer_list<Spy> il{ Spy(20), Spy(30), Spy(40), Spy(50), Spy(60), Spy(70), Spy(80) };
+      Spy::reset();
+      // exercise
+      custom::set <Spy> s(custom::sorted_unique, il.begin(), il.end());
+      // verify
+      assertUnit(Spy::numCopy() == 7);      // copy-construct [20,30,40,50,60,70,80]
+      assertUnit(Spy::numAlloc() == 7);     // allocate [20,30,40,50,60,70,80]
+      assertUnit(Spy::numLessthan() == 0);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20b)     (40b) (60b)     (80b)
+      assertUnit(s.bst.root != nullptr);
+      if (s.bst.root)
+      {
+         assertUnit(s.bst.root->verifyRedBlack(s.bst.root->findDepth()));
+         assertUnit(s.bst.root->findDepth() == 3);
+         s.bst.root->pLeft->pLeft->isRed = true;
+         s.bst.root->pLeft->pRight->isRed = true;
+         s.bst.root->pRight->pLeft->isRed = true;
+         s.bst.root->pRight->pRight->isRed = true;
+      }
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
    /***************************************
     * CONSTRUCTOR INITIALIZE LIST
     ***************************************/
@@ -553,9 +735,9 @@ public:
       // verify
       assertUnit(Spy::numCopy() == 7);      // copy-construct [50,30,70,20,40,60,80] 
       assertUnit(Spy::numAlloc() == 7);     // allocate [50,30,70,20,40,60,80]
-      assertUnit(Spy::numLessthan() == 10); // compare 50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);   // equal   50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);
+      assertUnit(Spy::numLessthan() == 15); // not sorted: [50][30], then compare 50: 30:[50] 70:[50] confirm [50] 20:[50][30] 40:[50][30] confirm [30] 60:[50][70] confirm [50] 80:[50][70] confirm [70]
+      assertUnit(Spy::numEquals() == 0);    // Compare only uses operator<
+      assertUnit(Spy::numEquals() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numDefault() == 0);
       assertUnit(Spy::numNondefault() == 0);
@@ -851,6 +1033,7 @@ public:
       p99->isRed = false;
       sDest.bst.root = p99;
       sDest.bst.numElements = 1;
+      sDest.bst.resetEnds();
       Spy::reset();
       // exercise
       sDest = sSrc;
@@ -893,6 +1076,7 @@ public:
       p99->isRed = false;
       sSrc.bst.root = p99;
       sSrc.bst.numElements = 1;
+      sSrc.bst.resetEnds();
       //                (50b) = sDest
       //          +-------+-------+
       //        (30b)           (70b)
@@ -1096,6 +1280,7 @@ public:
       p99->isRed = false;
       sDest.bst.root = p99;
       sDest.bst.numElements = 1;
+      sDest.bst.resetEnds();
       Spy::reset();
       // exercise
       sDest = std::move(sSrc);
@@ -1131,6 +1316,7 @@ public:
       p99->isRed = false;
       sSrc.bst.root = p99;
       sSrc.bst.numElements = 1;
+      sSrc.bst.resetEnds();
       //                (50b) = sDest
       //          +-------+-------+
       //        (30b)           (70b)
@@ -1249,8 +1435,8 @@ public:
       // verify
       assertUnit(Spy::numCopy() == 7);      // copy     [20][30][40][50][60][70][80]
       assertUnit(Spy::numAlloc() == 7);     // allocate [20][30][40][50][60][70][80]
-      assertUnit(Spy::numLessthan() == 10); // compare 50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);   // equal   50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
+      assertUnit(Spy::numLessthan() == 15); // not sorted: [50][30], then compare 50: 30:[50] 70:[50] confirm [50] 20:[50][30] 40:[50][30] confirm [30] 60:[50][70] confirm [50] 80:[50][70] confirm [70]
+      assertUnit(Spy::numEquals() == 0);    // Compare only uses operator<
       assertUnit(Spy::numDefault() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numNondefault() == 0);
@@ -1307,6 +1493,7 @@ public:
       p99->isRed = false;
       s.bst.root = p99;
       s.bst.numElements = 1;
+      s.bst.resetEnds();
       Spy::reset();
       // exercise
       s = il;
@@ -1315,8 +1502,8 @@ public:
       assertUnit(Spy::numDelete() == 1);      // delete [99]
       assertUnit(Spy::numCopy() == 7);        // copy     [20][30][40][50][60][70][80]
       assertUnit(Spy::numAlloc() == 7);       // allocate [20][30][40][50][60][70][80]
-      assertUnit(Spy::numLessthan() == 10);   // compare 50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);     // equal   50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
+      assertUnit(Spy::numLessthan() == 15);   // not sorted: [50][30], then compare 50: 30:[50] 70:[50] confirm [50] 20:[50][30] 40:[50][30] confirm [30] 60:[50][70] confirm [50] 80:[50][70] confirm [70]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numDefault() == 0);
       assertUnit(Spy::numNondefault() == 0);
       assertUnit(Spy::numCopyMove() == 0);
@@ -1385,8 +1572,8 @@ public:
       assertUnit(Spy::numDelete() == 7);      // delete   [20][30][40][50][60][70][80]
       assertUnit(Spy::numCopy() == 7);        // copy     [20][30][40][50][60][70][80]
       assertUnit(Spy::numAlloc() == 7);       // allocate [20][30][40][50][60][70][80]
-      assertUnit(Spy::numLessthan() == 10);   // compare 50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);     // equal   50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
+      assertUnit(Spy::numLessthan() == 15);   // not sorted: [50][30], then compare 50: 30:[50] 70:[50] confirm [50] 20:[50][30] 40:[50][30] confirm [30] 60:[50][70] confirm [50] 80:[50][70] confirm [70]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numAssign() == 0);
       assertUnit(Spy::numDefault() == 0);
       assertUnit(Spy::numNondefault() == 0);
@@ -2017,8 +2204,8 @@ public:
       // exercise
       it = s.find(spy);
       // verify
-      assertUnit(Spy::numEquals() == 3);      // check [50][30][20]
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][30]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][30][20], confirm [20]
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -2060,8 +2247,8 @@ public:
       // exercise
       it = s.find(spy);
       // verify
-      assertUnit(Spy::numEquals() == 3);      // check [50][70][80]
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][70][80], confirm [80]
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -2103,8 +2290,8 @@ public:
       // exercise
       it = s.find(spy);
       // verify
-      assertUnit(Spy::numEquals() == 3);      // check [50][30][40]
-      assertUnit(Spy::numLessthan() == 3);    // compare [50][30][40]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][30][40], confirm [40]
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -2121,6 +2308,155 @@ public:
    }
 
 
+   // a transparent comparator finds a Spy by its int value without making a Spy
+   void test_find_transparent()
+   {  // setup
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)    [(40r)] (60r)     (80r)
+      custom::set <Spy, SpyLess> s;
+      for (int i = 20; i <= 80; i += 10)
+         s.insert(Spy(i));
+      Spy::reset();
+      // exercise
+      auto it = s.find(40);
+      size_t num = s.count(65);
+      // verify
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit((*it).get() == 40);
+      assertUnit(num == 0);
+   }  // teardown
+
+   // look up a set of strings with a string_view
+   void test_find_transparentString()
+   {  // setup
+      custom::set <std::string, std::less<>> s { "alpha", "bravo", "charlie", "delta" };
+      std::string_view key("charlie, but only the first word", 7);
+      // exercise
+      auto it = s.find(key);
+      // verify
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == "charlie");
+      assertUnit(s.count(std::string_view("echo")) == 0);
+      assertUnit(s.count(std::string_view("alpha")) == 1);
+   }  // teardown
+
+   // lower bound of a missing element is the next one up
+   void test_lowerBound_standard()
+   {  // setup
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      // exercise
+      auto itMissing = s.lower_bound(Spy(45));
+      auto itPresent = s.lower_bound(Spy(60));
+      auto itPast    = s.lower_bound(Spy(85));
+      // verify
+      assertUnit(itMissing != s.end());
+      if (itMissing != s.end())
+         assertUnit(*itMissing == Spy(50));
+      assertUnit(itPresent != s.end());
+      if (itPresent != s.end())
+         assertUnit(*itPresent == Spy(60));
+      assertUnit(itPast == s.end());
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // upper_bound is the first element greater than the key
+   void test_upperBound_standard()
+   {  // setup
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      // exercise
+      auto itMissing = s.upper_bound(Spy(45));
+      auto itPresent = s.upper_bound(Spy(60));
+      auto itLast    = s.upper_bound(Spy(80));
+      // verify
+      assertUnit(itMissing != s.end());
+      if (itMissing != s.end())
+         assertUnit(*itMissing == Spy(50));
+      assertUnit(itPresent != s.end());
+      if (itPresent != s.end())
+         assertUnit(*itPresent == Spy(70));
+      assertUnit(itLast == s.end());
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // equal_range of a present key spans just that element
+   void test_equalRange_present()
+   {  // setup
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+     +----+----+
+      //    20        40    60        80  
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      Spy spy(60);
+      Spy::reset();
+      // exercise
+      auto range = s.equal_range(spy);
+      // verify
+      assertUnit(Spy::numLessthan() == 5);    // compare [50] [70]x2 [60]x2
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(range.first != s.end());
+      assertUnit(range.second != s.end());
+      if (range.first != s.end())
+         assertUnit(*range.first == Spy(60));
+      if (range.second != s.end())
+         assertUnit(*range.second == Spy(70));
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // equal_range of a missing key is empty
+   void test_equalRange_missing()
+   {  // setup
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      // exercise
+      auto range = s.equal_range(Spy(65));
+      // verify
+      assertUnit(range.first == range.second);
+      assertUnit(range.first != s.end());
+      if (range.first != s.end())
+         assertUnit(*range.first == Spy(70));
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // every lookup works through a const set
+   void test_contains_const()
+   {  // setup
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      const custom::set <Spy> & sConst = s;
+      // exercise and verify
+      assertUnit(sConst.contains(Spy(40)) == true);
+      assertUnit(sConst.contains(Spy(45)) == false);
+      assertUnit(sConst.count(Spy(80)) == 1);
+      assertUnit(sConst.find(Spy(20)) == sConst.begin());
+      assertUnit(sConst.lower_bound(Spy(85)) == sConst.end());
+      assertUnit(sConst.upper_bound(Spy(10)) == sConst.begin());
+      assertUnit(sConst.equal_range(Spy(30)).second == sConst.find(Spy(40)));
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
    /***************************************
     * INSERT
     *  set::insert(const T &)
@@ -2188,8 +2524,8 @@ public:
       // verify
       assertUnit(Spy::numCopy() == 1);        // copy-create [80]
       assertUnit(Spy::numAlloc() == 1);       // allocate [80]
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
-      assertUnit(Spy::numEquals() == 2);      // compare [50][70]
+      assertUnit(Spy::numLessthan() == 3);    // compare [50][70], confirm [70]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -2232,7 +2568,7 @@ public:
       assertUnit(Spy::numCopy() == 1);        // copy-create [20]
       assertUnit(Spy::numAlloc() == 1);       // allocate [20]
       assertUnit(Spy::numLessthan() == 2);    // compare [50][30]
-      assertUnit(Spy::numEquals() == 2);      // compare [50][30]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -2274,8 +2610,8 @@ public:
       // verify
       assertUnit(Spy::numCopy() == 1);        // copy-create [60]
       assertUnit(Spy::numAlloc() == 1);       // allocate [60]
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
-      assertUnit(Spy::numEquals() == 2);      // compare [50][70]
+      assertUnit(Spy::numLessthan() == 3);    // compare [50][70], confirm [50]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
       assertUnit(Spy::numAssign() == 0);
@@ -2312,8 +2648,8 @@ public:
       // exercise
       auto pairSet = s.insert(spy);
       // verify
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
-      assertUnit(Spy::numEquals() == 3);      // compare [50][70][60]
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][70][60], confirm [60]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numAlloc() == 0);
       assertUnit(Spy::numDestructor() == 0);
@@ -2404,8 +2740,8 @@ public:
       auto pairSet = s.insert(std::move(spy));
       // verify
       assertUnit(Spy::numCopyMove() == 1);    // copy-move [80]
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
-      assertUnit(Spy::numEquals() == 2);      // compare [50][70]
+      assertUnit(Spy::numLessthan() == 3);    // compare [50][70], confirm [70]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numAlloc() == 0);
       assertUnit(Spy::numDestructor() == 0);
@@ -2449,7 +2785,7 @@ public:
       // verify
       assertUnit(Spy::numCopyMove() == 1);    // copy-move [20]
       assertUnit(Spy::numLessthan() == 2);    // compare [50][30]
-      assertUnit(Spy::numEquals() == 2);      // compare [50][30]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numAlloc() == 0);
       assertUnit(Spy::numDestructor() == 0);
@@ -2492,8 +2828,8 @@ public:
       auto pairSet = s.insert(std::move(spy));
       // verify
       assertUnit(Spy::numCopyMove() == 1);  // copy-move [60]
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
-      assertUnit(Spy::numEquals() == 2);      // compare [50][70]
+      assertUnit(Spy::numLessthan() == 3);    // compare [50][70], confirm [50]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numAlloc() == 0);
       assertUnit(Spy::numDestructor() == 0);
@@ -2532,8 +2868,8 @@ public:
       // exercise
       auto pairSet = s.insert(std::move(spy));
       // verify
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
-      assertUnit(Spy::numEquals() == 3);      // compare [50][70][60]
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][70][60], confirm [60]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numAlloc() == 0);
       assertUnit(Spy::numDestructor() == 0);
@@ -2558,125 +2894,327 @@ public:
    }
 
    /***************************************
-    * Insert Initializer
-    *    set::insert(const std::initializer_list<T>& il)
+    * Emplace
+    *    set::emplace(Args&&...)
+    *    set::emplace_hint(iterator, Args&&...)
     ***************************************/
 
-   // insert: empty.insert({})
-   void test_insertInit_emptyInsertNone()
+   // build 60 right in its node
+   void test_emplace_standardMiddle()
    {  // setup
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+          +----+
+      //    20        40              80  
       custom::set <Spy> s;
-      std::initializer_list<Spy> il{ };
+      setupStandardFixture(s);
+      delete s.bst.root->pRight->pLeft;
+      s.bst.root->pRight->pLeft = nullptr;
+      s.bst.numElements = 6;
       Spy::reset();
       // exercise
-      s.insert(il);
+      auto pairSet = s.emplace(60);
       // verify
-      assertUnit(Spy::numDefault() == 0);
-      assertUnit(Spy::numAlloc() == 0);
-      assertUnit(Spy::numDelete() == 0);
-      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numNondefault() == 1);  // construct [60] in the node
+      assertUnit(Spy::numAlloc() == 1);       // allocate [60]
+      assertUnit(Spy::numLessthan() == 3);    // compare [50][70], confirm [50]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numCopyMove() == 0);
-      assertUnit(Spy::numAssign() == 0);
-      assertUnit(Spy::numAssignMove() == 0);
-      assertUnit(Spy::numEquals() == 0);
-      assertUnit(Spy::numLessthan() == 0);
-      assertEmptyFixture(s);
-   }  // teardown
-
-   // insert: empty.insert({50, 30, 70, 20, 40, 60, 80})
-   void test_insertInit_emptyInsertMany()
-   {  // setup
-      custom::set <Spy> s;
-      std::initializer_list<Spy> il{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40), Spy(60), Spy(80) };
-      Spy::reset();
-      // exercise
-      s.insert(il);
-      // verify
-      assertUnit(Spy::numCopy() == 7);      // copy     [20][30][40][50][60][70][80]
-      assertUnit(Spy::numAlloc() == 7);     // allocate [20][30][40][50][60][70][80]
-      assertUnit(Spy::numLessthan() == 10); // compare 50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numEquals() == 10);   // equal   50: 30:[50] 70:[50] 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
-      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numDestructor() == 0);
       assertUnit(Spy::numDelete() == 0);
-      assertUnit(Spy::numNondefault() == 0);
-      assertUnit(Spy::numCopyMove() == 0);
       assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numDefault() == 0);
       assertUnit(Spy::numAssignMove() == 0);
-      //                (50b)
+      assertUnit(pairSet.first != s.end());
+      assertUnit(pairSet.second == true);
+      if (pairSet.first != s.end())
+         assertUnit(*(pairSet.first) == Spy(60));
+      //                 50 
       //          +-------+-------+
-      //        (30b)           (70b)
+      //         30              70  
       //     +----+----+     +----+----+
-      //   (20r)     (40r) (60r)     (80r)
+      //    20        40    60        80  
       assertStandardFixture(s);
       // teardown
       teardownStandardFixture(s);
    }
 
-   // insert: standard.insert({})
-   void test_insertInit_standardInsertNone()
+   // emplace when the element is already there. The new one is thrown away
+   void test_emplace_standardDuplicate()
    {  // setup
-      //                (50b) = s
+      //                 50 
       //          +-------+-------+
-      //        (30b)           (70b)
+      //         30              70  
       //     +----+----+     +----+----+
-      //   (20r)     (40r) (60r)     (80r)
+      //    20        40    60        80  
       custom::set <Spy> s;
       setupStandardFixture(s);
-      std::initializer_list<Spy> il{ };
       Spy::reset();
       // exercise
-      s.insert(il);
+      auto pairSet = s.emplace(60);
       // verify
-      assertUnit(Spy::numDestructor() == 0);
-      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numNondefault() == 1);  // construct [60] in the node
+      assertUnit(Spy::numAlloc() == 1);       // allocate [60]
+      assertUnit(Spy::numDestructor() == 1);  // destroy the duplicate [60]
+      assertUnit(Spy::numDelete() == 1);      // free the duplicate [60]
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][70][60], confirm [60]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
-      assertUnit(Spy::numAlloc() == 0);
-      assertUnit(Spy::numDefault() == 0);
-      assertUnit(Spy::numNondefault() == 0);
       assertUnit(Spy::numCopyMove() == 0);
       assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numDefault() == 0);
       assertUnit(Spy::numAssignMove() == 0);
-      assertUnit(Spy::numEquals() == 0);
-      assertUnit(Spy::numLessthan() == 0);
+      assertUnit(pairSet.first != s.end());
+      assertUnit(pairSet.second == false);
+      if (pairSet.first != s.end())
+         assertUnit(*(pairSet.first) == Spy(60));
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+     +----+----+
+      //    20        40    60        80  
       assertStandardFixture(s);
       // teardown
       teardownStandardFixture(s);
-   }  
+   }
 
-   // insert : standard.insert({50, 30})
-   void test_insertInit_standardInsertDuplicates()
+   // emplace with a hint: the element is still built in place
+   void test_emplaceHint_standardMiddle()
    {  // setup
-      std::initializer_list<Spy> il{ Spy(50), Spy(40) };
-      //                (50b) = s
+      //                 50 
       //          +-------+-------+
-      //        (30b)           (70b)
-      //     +----+----+     +----+----+
-      //   (20r)     (40r) (60r)     (80r)
+      //         30              70  
+      //     +----+----+          +----+
+      //    20        40              80  
       custom::set <Spy> s;
       setupStandardFixture(s);
+      delete s.bst.root->pRight->pLeft;
+      s.bst.root->pRight->pLeft = nullptr;
+      s.bst.numElements = 6;
       Spy::reset();
       // exercise
-      s.insert(il);
+      auto it = s.emplace_hint(s.end(), 60);
       // verify
-      assertUnit(Spy::numLessthan() == 2);   // compare 50: 40:[50][30] 
-      assertUnit(Spy::numEquals() == 4);     // equal   50:[50] 40:[50][30][40]
+      assertUnit(Spy::numNondefault() == 1);  // construct [60] in the node
+      assertUnit(Spy::numAlloc() == 1);       // allocate [60]
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
       assertUnit(Spy::numDestructor() == 0);
-      assertUnit(Spy::numDelete() == 0);    
-      assertUnit(Spy::numCopy() == 0);      
-      assertUnit(Spy::numAlloc() == 0);     
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numAssign() == 0);
       assertUnit(Spy::numDefault() == 0);
-      assertUnit(Spy::numNondefault() == 0);
-      assertUnit(Spy::numCopyMove() == 0);
       assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == Spy(60));
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+     +----+----+
+      //    20        40    60        80  
       assertStandardFixture(s);
       // teardown
       teardownStandardFixture(s);
    }
 
-   // assignment operator : standard = {99}
-   void test_insertInit_manyInsertMany()
-   {  // setup
+   /***************************************
+    * Insert with a hint
+    *    set::insert(const_iterator, const T&)
+    ***************************************/
+
+   // hint at the element 60 goes right before
+   void test_insertHint_standardMiddle()
+   {  // setup
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+          +----+
+      //    20        40              80  
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      delete s.bst.root->pRight->pLeft;
+      s.bst.root->pRight->pLeft = nullptr;
+      s.bst.numElements = 6;
+      custom::set <Spy> ::const_iterator itHint = s.find(Spy(70));
+      Spy spy(60);
+      Spy::reset();
+      // exercise
+      auto it = s.insert(itHint, spy);
+      // verify
+      assertUnit(Spy::numCopy() == 1);        // copy [60]
+      assertUnit(Spy::numAlloc() == 1);       // allocate [60]
+      assertUnit(Spy::numLessthan() == 2);    // compare [70], then [50] before it
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == Spy(60));
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+     +----+----+
+      //    20        40    60        80  
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // hint at the element itself: nothing is added
+   void test_insertHint_standardDuplicate()
+   {  // setup
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+     +----+----+
+      //    20        40    60        80  
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      custom::set <Spy> ::const_iterator itHint = s.find(Spy(60));
+      Spy spy(60);
+      Spy::reset();
+      // exercise
+      auto it = s.insert(itHint, spy);
+      // verify
+      assertUnit(Spy::numLessthan() == 6);    // compare [60] both ways, then [50][70][60], confirm [60]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(it == itHint);
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   /***************************************
+    * Insert Initializer
+    *    set::insert(const std::initializer_list<T>& il)
+    ***************************************/
+
+   // insert: empty.insert({})
+   void test_insertInit_emptyInsertNone()
+   {  // setup
+      custom::set <Spy> s;
+      std::initializer_list<Spy> il{ };
+      Spy::reset();
+      // exercise
+      s.insert(il);
+      // verify
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(Spy::numLessthan() == 0);
+      assertEmptyFixture(s);
+   }  // teardown
+
+   // insert: empty.insert({50, 30, 70, 20, 40, 60, 80})
+   void test_insertInit_emptyInsertMany()
+   {  // setup
+      custom::set <Spy> s;
+      std::initializer_list<Spy> il{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40), Spy(60), Spy(80) };
+      Spy::reset();
+      // exercise
+      s.insert(il);
+      // verify
+      assertUnit(Spy::numCopy() == 7);      // copy     [20][30][40][50][60][70][80]
+      assertUnit(Spy::numAlloc() == 7);     // allocate [20][30][40][50][60][70][80]
+      assertUnit(Spy::numLessthan() == 15); // not sorted: [50][30], then compare 50: 30:[50] 70:[50] confirm [50] 20:[50][30] 40:[50][30] confirm [30] 60:[50][70] confirm [50] 80:[50][70] confirm [70]
+      assertUnit(Spy::numEquals() == 0);    // Compare only uses operator<
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // insert: standard.insert({})
+   void test_insertInit_standardInsertNone()
+   {  // setup
+      //                (50b) = s
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      std::initializer_list<Spy> il{ };
+      Spy::reset();
+      // exercise
+      s.insert(il);
+      // verify
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(Spy::numLessthan() == 0);
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }  
+
+   // insert : standard.insert({50, 30})
+   void test_insertInit_standardInsertDuplicates()
+   {  // setup
+      std::initializer_list<Spy> il{ Spy(50), Spy(40) };
+      //                (50b) = s
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      custom::set <Spy> s;
+      setupStandardFixture(s);
+      Spy::reset();
+      // exercise
+      s.insert(il);
+      // verify
+      assertUnit(Spy::numLessthan() == 8);   // compare 50:[50][70][60] confirm [50] 40:[50][30][40] confirm [40]
+      assertUnit(Spy::numEquals() == 0);     // Compare only uses operator<
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numDelete() == 0);    
+      assertUnit(Spy::numCopy() == 0);      
+      assertUnit(Spy::numAlloc() == 0);     
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(Spy::numNondefault() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // assignment operator : standard = {99}
+   void test_insertInit_manyInsertMany()
+   {  // setup
       //                (50b) = s
       //          +-------+-------+
       //        (30b)           (70b)
@@ -2690,13 +3228,14 @@ public:
       p50->pRight = p70;
       p50->pLeft  = p30;
       s.bst.numElements = 3;
+      s.bst.resetEnds();
       std::initializer_list<Spy> il{ Spy(20), Spy(40), Spy(60), Spy(80) };
       Spy::reset();
       // exercise
       s.insert(il);
       // verify
-      assertUnit(Spy::numLessthan() == 8);   // compare 20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]  
-      assertUnit(Spy::numEquals() == 8);     // equal   20:[50][30] 40:[50][30] 60:[50][70] 80:[50][70]
+      assertUnit(Spy::numLessthan() == 11);  // compare 20:[50][30] 40:[50][30] confirm [30] 60:[50][70] confirm [50] 80:[50][70] confirm [70]
+      assertUnit(Spy::numEquals() == 0);     // Compare only uses operator<
       assertUnit(Spy::numCopy() == 4);       // create   [20][40][60][80]
       assertUnit(Spy::numAlloc() == 4);      // allocate [20][40][60][80]
       assertUnit(Spy::numDestructor() == 0);
@@ -2897,6 +3436,7 @@ public:
       p30->pLeft = p20;
       p30->pRight = p40;
       s.bst.numElements = 6;
+      s.bst.resetEnds();
       auto itBST = custom::BST <int> ::iterator(p10);
       auto it = custom::set <int> ::iterator(itBST);
       // exercise
@@ -2964,6 +3504,7 @@ public:
       p50->pRight = p60;
       p30->pRight = p40;
       s.bst.numElements = 8;
+      s.bst.resetEnds();
       auto itBST = custom::BST <int> ::iterator(p20);
       auto it = custom::set <int> ::iterator(itBST);
       // exercise
@@ -3057,8 +3598,8 @@ public:
       // exercise
       size_t num = s.erase(spy);
       // verify
-      assertUnit(Spy::numLessthan() == 3);  // compare [50][70][60]
-      assertUnit(Spy::numEquals() == 3);    // check [50][70][60]
+      assertUnit(Spy::numLessthan() == 4);  // compare [50][70][60], confirm [60]
+      assertUnit(Spy::numEquals() == 0);    // Compare only uses operator<
       assertUnit(Spy::numCopy() == 0);
       assertUnit(Spy::numAlloc() == 0);
       assertUnit(Spy::numDestructor() == 0);
@@ -3089,8 +3630,8 @@ public:
       // exercise
       size_t num = s.erase(spy);
       // verify
-      assertUnit(Spy::numLessthan() == 2);    // compare [50][70]
-      assertUnit(Spy::numEquals() == 3);      // check [50][70][60]
+      assertUnit(Spy::numLessthan() == 4);    // compare [50][70][60], confirm [60]
+      assertUnit(Spy::numEquals() == 0);      // Compare only uses operator<
       assertUnit(Spy::numDestructor() == 1);  // destroy [60]
       assertUnit(Spy::numDelete() == 1);      // delete [60]
       assertUnit(Spy::numCopy() == 0);
@@ -3138,6 +3679,7 @@ public:
       p30->pLeft = p20;
       p30->pRight = p40;
       s.bst.numElements = 6;
+      s.bst.resetEnds();
       // exercise
       size_t num = s.erase(10);
       // verify
@@ -3201,6 +3743,7 @@ public:
       p50->pRight = p60;
       p30->pRight = p40;
       s.bst.numElements = 8;
+      s.bst.resetEnds();
       // exercise
       size_t num = s.erase(20);
       // verify
@@ -3428,6 +3971,856 @@ public:
 
    }
 
+   // a long range is cut out with split and join
+   void test_eraseRange_long()
+   {  // setup
+      custom::set <int> s;
+      for (int i = 0; i < 2000; i++)
+         s.insert(i);
+      auto itBegin = s.find(500);
+      auto itEnd = s.find(1700);
+      // exercise
+      auto itReturn = s.erase(itBegin, itEnd);
+      // verify
+      assertUnit(itReturn == s.find(1700));
+      assertUnit(*itReturn == 1700);
+      assertUnit(s.bst.numElements == 800);
+      assertUnit(s.bst.root->verifyRedBlack(s.bst.root->findDepth()));
+      int expected = 0;
+      for (auto it = s.begin(); it != s.end(); ++it, expected = (expected == 499 ? 1700 : expected + 1))
+         assertUnit(*it == expected);
+      assertUnit(expected == 2000);
+   }  // teardown
+
+   // erase everything from a key up to, but not including, another
+   void test_eraseRangeKey_standard()
+   {  // setup
+      custom::set <int> s { 20, 30, 40, 50, 60, 70, 80 };
+      // exercise
+      size_t num = s.erase_range(25, 70);
+      // verify
+      int expected[] = { 20, 70, 80 };
+      assertUnit(num == 4);
+      assertSetIs(s, expected, 3);
+   }  // teardown
+
+   // a backwards key range is empty
+   void test_eraseRangeKey_backwards()
+   {  // setup
+      custom::set <int> s { 20, 30, 40, 50, 60, 70, 80 };
+      // exercise
+      size_t num = s.erase_range(70, 25);
+      // verify
+      int expected[] = { 20, 30, 40, 50, 60, 70, 80 };
+      assertUnit(num == 0);
+      assertSetIs(s, expected, 7);
+   }  // teardown
+
+   /***************************************
+    * COMPARE
+    *    custom::set <T, Compare>
+    ***************************************/
+
+   // a set ordered by std::greater iterates from big to small
+   void test_compare_greater()
+   {  // setup
+      custom::set <int, std::greater<int>> s { 30, 10, 50, 20, 40 };
+      // exercise
+      s.insert(25);
+      // verify
+      assertUnit(s.size() == 6);
+      int expected[] = { 50, 40, 30, 25, 20, 10 };
+      int i = 0;
+      for (auto it = s.begin(); it != s.end(); ++it, ++i)
+         assertUnit(*it == expected[i]);
+      assertUnit(i == 6);
+      assertUnit(s.find(25) != s.end());
+      assertUnit(s.find(35) == s.end());
+   }  // teardown
+
+   /***************************************
+    * RELATIONAL
+    *    operator == (set, set)
+    *    operator <  (set, set)
+    *    operator <=> (set, set)
+    ***************************************/
+
+   // equal sets compare every pair once
+   void test_equal_same()
+   {  // setup
+      custom::set <Spy> lhs { Spy(10), Spy(20), Spy(30) };
+      custom::set <Spy> rhs { Spy(10), Spy(20), Spy(30) };
+      Spy::reset();
+      // exercise
+      bool equal = (lhs == rhs);
+      bool notEqual = (lhs != rhs);
+      // verify
+      assertUnit(equal == true);
+      assertUnit(notEqual == false);
+      assertUnit(Spy::numEquals() == 6);    // [10][20][30] for each
+      assertUnit(Spy::numLessthan() == 0);
+      assertUnit(Spy::numCopy() == 0);
+   }  // teardown
+
+   // sets of different sizes are told apart without a comparison
+   void test_equal_differentSize()
+   {  // setup
+      custom::set <Spy> lhs { Spy(10), Spy(20), Spy(30) };
+      custom::set <Spy> rhs { Spy(10), Spy(20) };
+      Spy::reset();
+      // exercise
+      bool equal = (lhs == rhs);
+      // verify
+      assertUnit(equal == false);
+      assertUnit(Spy::numEquals() == 0);
+      assertUnit(Spy::numLessthan() == 0);
+   }  // teardown
+
+   // the walk stops at the first difference
+   void test_equal_differentElement()
+   {  // setup
+      custom::set <Spy> lhs { Spy(10), Spy(20), Spy(30) };
+      custom::set <Spy> rhs { Spy(10), Spy(25), Spy(30) };
+      Spy::reset();
+      // exercise
+      bool equal = (lhs == rhs);
+      // verify
+      assertUnit(equal == false);
+      assertUnit(Spy::numEquals() == 2);    // [10] then [20] vs [25]
+   }  // teardown
+
+   // a prefix comes before the longer set
+   void test_less_prefix()
+   {  // setup
+      custom::set <int> lhs { 10, 20 };
+      custom::set <int> rhs { 10, 20, 30 };
+      custom::set <int> empty;
+      // exercise and verify
+      assertUnit(lhs < rhs);
+      assertUnit(!(rhs < lhs));
+      assertUnit(rhs > lhs);
+      assertUnit(lhs <= rhs);
+      assertUnit(rhs >= lhs);
+      assertUnit(empty < lhs);
+      assertUnit(!(empty < empty));
+      assertUnit(empty <= empty);
+      assertUnit(empty >= empty);
+   }  // teardown
+
+   // the first pair that differs decides, whatever the sizes
+   void test_less_firstDifference()
+   {  // setup
+      custom::set <Spy> lhs { Spy(10), Spy(20), Spy(30), Spy(40) };
+      custom::set <Spy> rhs { Spy(10), Spy(25) };
+      Spy::reset();
+      // exercise
+      bool less = (lhs < rhs);
+      // verify
+      assertUnit(less == true);
+      assertUnit(Spy::numLessthan() == 3);  // [10]<[10] [10]<[10] [20]<[25]
+      assertUnit(!(lhs > rhs));
+      assertUnit(!(lhs >= rhs));
+   }  // teardown
+
+   // <=> agrees with <
+   void test_threeWay_standard()
+   {
+#if __cpp_impl_three_way_comparison >= 201907L
+      // setup
+      custom::set <int> lhs { 10, 20, 30 };
+      custom::set <int> rhs { 10, 25 };
+      custom::set <Spy> spyLHS { Spy(10), Spy(20) };
+      custom::set <Spy> spyRHS { Spy(10), Spy(20) };
+      // exercise and verify
+      assertUnit((lhs <=> rhs) < 0);
+      assertUnit((rhs <=> lhs) > 0);
+      assertUnit((lhs <=> lhs) == 0);
+      assertUnit((spyLHS <=> spyRHS) == 0);
+      spyRHS.insert(Spy(5));
+      assertUnit((spyLHS <=> spyRHS) > 0);
+#endif
+   }  // teardown
+
+   /***************************************
+    * SET ALGEBRA
+    *    set_union(set, set)
+    *    set_intersection(set, set)
+    *    set_difference(set, set)
+    *    set_symmetric_difference(set, set)
+    *    set::merge(set)
+    *    set::retain(set)
+    ***************************************/
+
+   // union of two overlapping sets
+   void test_union_standard()
+   {  // setup
+      custom::set <int> lhs { 10, 20, 30, 40 };
+      custom::set <int> rhs { 5, 20, 40, 50 };
+      // exercise
+      custom::set <int> s = custom::set_union(lhs, rhs);
+      // verify
+      int expected[] = { 5, 10, 20, 30, 40, 50 };
+      assertSetIs(s, expected, 6);
+      assertUnit(lhs.size() == 4);
+      assertUnit(rhs.size() == 4);
+   }  // teardown
+
+   // intersection of two sets of about the same size: one merge walk
+   void test_intersection_standard()
+   {  // setup
+      custom::set <Spy> lhs { Spy(10), Spy(20), Spy(30), Spy(40) };
+      custom::set <Spy> rhs { Spy(5), Spy(20), Spy(40), Spy(50) };
+      Spy::reset();
+      // exercise
+      custom::set <Spy> s = custom::set_intersection(lhs, rhs);
+      // verify
+      assertUnit(Spy::numCopy() == 2);      // copy [20][40]
+      assertUnit(Spy::numLessthan() == 8);  // walk 10:5 5:10 10:20 20:20x2 30:40 40:40x2
+      assertUnit(s.size() == 2);
+      assertUnit(s.contains(Spy(20)));
+      assertUnit(s.contains(Spy(40)));
+   }  // teardown
+
+   // a small set against a large one is looked up, not walked
+   void test_intersection_unbalanced()
+   {  // setup
+      custom::set <Spy> lhs;
+      for (int i = 0; i < 1000; i++)
+         lhs.insert(Spy(i));
+      custom::set <Spy> rhs { Spy(-1), Spy(100), Spy(500), Spy(1000) };
+      Spy::reset();
+      // exercise
+      custom::set <Spy> s = custom::set_intersection(lhs, rhs);
+      // verify
+      assertUnit(Spy::numLessthan() < 100);  // far fewer than walking 1000 elements
+      assertUnit(s.size() == 2);
+      assertUnit(s.contains(Spy(100)));
+      assertUnit(s.contains(Spy(500)));
+   }  // teardown
+
+   // difference keeps what is only in the left set
+   void test_difference_standard()
+   {  // setup
+      custom::set <int> lhs { 10, 20, 30, 40 };
+      custom::set <int> rhs { 5, 20, 40, 50 };
+      // exercise
+      custom::set <int> s = custom::set_difference(lhs, rhs);
+      // verify
+      int expected[] = { 10, 30 };
+      assertSetIs(s, expected, 2);
+   }  // teardown
+
+   // a small left set is looked up in a large right set
+   void test_difference_unbalanced()
+   {  // setup
+      custom::set <int> lhs { -5, 10, 15, 2000 };
+      custom::set <int> rhs;
+      for (int i = 0; i < 1000; i += 2)
+         rhs.insert(i);
+      // exercise
+      custom::set <int> s = custom::set_difference(lhs, rhs);
+      // verify
+      int expected[] = { -5, 15, 2000 };
+      assertSetIs(s, expected, 3);
+   }  // teardown
+
+   // symmetric difference keeps what is in exactly one set
+   void test_symmetricDifference_standard()
+   {  // setup
+      custom::set <int> lhs { 10, 20, 30, 40 };
+      custom::set <int> rhs { 5, 20, 40, 50 };
+      // exercise
+      custom::set <int> s = custom::set_symmetric_difference(lhs, rhs);
+      // verify
+      int expected[] = { 5, 10, 30, 50 };
+      assertSetIs(s, expected, 4);
+   }  // teardown
+
+   // merge adds the missing elements in place
+   void test_merge_standard()
+   {  // setup
+      custom::set <Spy> lhs { Spy(10), Spy(20), Spy(30), Spy(40) };
+      custom::set <Spy> rhs { Spy(5), Spy(20), Spy(40), Spy(50) };
+      Spy::reset();
+      // exercise
+      lhs.merge(rhs);
+      // verify
+      assertUnit(Spy::numCopy() == 2);      // copy [5][50]
+      assertUnit(Spy::numAlloc() == 2);     // allocate [5][50]
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(lhs.size() == 6);
+      assertUnit(rhs.size() == 4);
+      int i = 0;
+      int expected[] = { 5, 10, 20, 30, 40, 50 };
+      for (auto it = lhs.begin(); it != lhs.end() && i < 6; ++it, i++)
+         assertUnit(*it == Spy(expected[i]));
+      assertUnit(i == 6);
+   }  // teardown
+
+   // retain drops what is not in the other set, in place
+   void test_retain_standard()
+   {  // setup
+      custom::set <int> lhs { 10, 20, 30, 40 };
+      custom::set <int> rhs { 5, 20, 40, 50 };
+      // exercise
+      lhs.retain(rhs);
+      // verify
+      int expected[] = { 20, 40 };
+      assertSetIs(lhs, expected, 2);
+      assertUnit(rhs.size() == 4);
+   }  // teardown
+
+   /***************************************
+    * RANK
+    *    set::nth()
+    *    set::rank()
+    *    set::distance()
+    ***************************************/
+
+   // the 99th percentile of a thousand latencies
+   void test_nth_percentile()
+   {  // setup
+      custom::ranked_set <int> s;
+      for (int i = 1000; i > 0; i--)
+         s.insert(i * 10);
+      // exercise
+      custom::ranked_set <int> ::iterator it = s.nth(s.size() * 99 / 100);
+      // verify
+      assertUnit(*it == 9910);
+      assertUnit(*s.nth(0) == 10);
+      assertUnit(s.nth(1000) == s.end());
+   }  // teardown
+
+   // elements less than a key, whether or not it is there
+   void test_rank_standard()
+   {  // setup
+      custom::ranked_set <int> s { 20, 30, 40, 50, 60, 70, 80 };
+      // exercise and verify
+      assertUnit(s.rank(10) == 0);
+      assertUnit(s.rank(20) == 0);
+      assertUnit(s.rank(45) == 3);
+      assertUnit(s.rank(50) == 3);
+      assertUnit(s.rank(80) == 6);
+      assertUnit(s.rank(99) == 7);
+   }  // teardown
+
+   // distance between iterators without walking from one to the other
+   void test_distance_standard()
+   {  // setup
+      custom::ranked_set <int> s { 20, 30, 40, 50, 60, 70, 80 };
+      s.erase(40);
+      // exercise and verify
+      assertUnit(s.distance(s.begin(), s.end()) == 6);
+      assertUnit(s.distance(s.find(30), s.find(70)) == 3);
+      assertUnit(s.distance(s.end(), s.end()) == 0);
+      assertUnit(s.distance(s.lower_bound(40), s.upper_bound(70)) == 3);
+   }  // teardown
+
+   /***************************************
+    * ENDS
+    *    set::rbegin()
+    *    set::front()
+    *    set::pop_front()
+    *    set::pop_back()
+    ***************************************/
+
+   // largest to smallest
+   void test_rbegin_standard()
+   {  // setup
+      custom::set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      int expected = 80;
+      // exercise
+      for (auto it = s.rbegin(); it != s.rend(); --it, expected -= 10)
+         // verify
+         assertUnit(*it == expected);
+      assertUnit(expected == 10);
+      assertUnit(custom::set <int> ().rbegin() == custom::set <int> ().rend());
+   }  // teardown
+
+   // always run the earliest deadline next, and add work as we go
+   void test_popFront_deadlines()
+   {  // setup
+      custom::set <int> s { 500, 100, 300 };
+      int order[6];
+      int num = 0;
+      // exercise
+      while (!s.empty())
+      {
+         int deadline = s.front();
+         s.pop_front();
+         order[num++] = deadline;
+         if (deadline == 100)
+            s.insert({ 200, 150 });
+         if (deadline == 200)
+            s.insert(400);
+      }
+      // verify
+      int expected[] = { 100, 150, 200, 300, 400, 500 };
+      assertUnit(num == 6);
+      for (int i = 0; i < 6; i++)
+         assertUnit(order[i] == expected[i]);
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // keep only the smallest few
+   void test_popBack_standard()
+   {  // setup
+      custom::set <int> s { 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      while (s.size() > 3)
+         s.pop_back();
+      // verify
+      int expected[] = { 20, 30, 40 };
+      assertSetIs(s, expected, 3);
+      assertUnit(s.back() == 40);
+      assertUnit(*s.rbegin() == 40);
+   }  // teardown
+
+   /***************************************
+    * THREADED
+    *    threaded_set::iterator
+    ***************************************/
+
+   // scan a range forwards and back after the tree has been reshaped
+   void test_threaded_rangeScan()
+   {  // setup
+      custom::threaded_set <int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert((i * 37) % 100);
+      for (int i = 0; i < 100; i += 3)
+         s.erase(i);
+      // exercise
+      int sum = 0;
+      auto itEnd = s.lower_bound(60);
+      for (auto it = s.lower_bound(40); it != itEnd; ++it)
+         sum += *it;
+      int sumBack = 0;
+      auto it = itEnd;
+      for (--it; *it >= 40; --it)
+         sumBack += *it;
+      // verify
+      assertUnit(sum == 40 + 41 + 43 + 44 + 46 + 47 + 49 + 50 + 52 + 53 + 55 + 56 + 58 + 59);
+      assertUnit(sumBack == sum);
+      assertUnit(*it == 38);
+   }  // teardown
+
+   /***************************************
+    * FREEZE
+    *    set::freeze()
+    ***************************************/
+
+   // a frozen copy finds what the set has and leaves the set alone
+   void test_freeze_standard()
+   {  // setup
+      custom::set <Spy> s { Spy(50), Spy(30), Spy(70), Spy(20), Spy(40) };
+      Spy::reset();
+      // exercise
+      custom::frozen_set <Spy> sFrozen = s.freeze();
+      s.erase(Spy(30));
+      // verify
+      assertUnit(Spy::numAssign() == 5);   // each element dropped into its slot
+      assertUnit(sFrozen.size() == 5);
+      assertUnit(sFrozen.contains(Spy(30)));
+      assertUnit(!sFrozen.contains(Spy(45)));
+      assertUnit(*sFrozen.lower_bound(Spy(45)) == Spy(50));
+      assertUnit(s.size() == 4);
+      int expected[] = { 20, 30, 40, 50, 70 };
+      int i = 0;
+      for (auto it = sFrozen.begin(); it != sFrozen.end(); ++it)
+         assertUnit(*it == Spy(expected[i++]));
+      assertUnit(i == 5);
+   }  // teardown
+
+   /***************************************
+    * HASHED
+    *    hashed_set::find()
+    ***************************************/
+
+   struct SpyHash
+   {
+      size_t operator () (const Spy & spy) const { return std::hash<int>()(spy.get()); }
+   };
+
+   // a lookup goes to the node without walking down the tree: one
+   // equivalence check, which takes two compares
+   void test_hashed_findNoCompares()
+   {  // setup
+      custom::hashed_set <Spy, SpyHash> s { Spy(50), Spy(30), Spy(70), Spy(20), Spy(40), Spy(60), Spy(80) };
+      Spy spy20(20);
+      Spy spy45(45);
+      Spy::reset();
+      // exercise
+      auto it = s.find(spy20);
+      bool missing = s.contains(spy45);
+      // verify
+      assertUnit(Spy::numLessthan() <= 2);
+      assertUnit(it != s.end());
+      assertUnit(*it == Spy(20));
+      assertUnit(!missing);
+      assertUnit(s.index.size() == 7);
+      ++it;
+      assertUnit(*it == Spy(30));   // still in order
+   }  // teardown
+
+   // inserts and erases of every kind keep the index in step with the tree
+   void test_hashed_findAfterChurn()
+   {  // setup
+      custom::hashed_set <int> s;
+      for (int i = 0; i < 200; i++)
+         s.insert((i * 37) % 200);
+      // exercise
+      for (int i = 0; i < 200; i += 3)
+         s.erase(i);
+      s.pop_front();
+      s.pop_back();
+      s.emplace(1000);
+      s.insert(s.end(), 2000);
+      // verify
+      bool found = true;
+      for (int i = 0; i < 200; i++)
+      {
+         bool expected = i % 3 != 0 && i != 1 && i != 199;
+         found = found && s.contains(i) == expected;
+         found = found && (s.find(i) != s.end()) == expected;
+      }
+      assertUnit(found);
+      assertUnit(s.contains(1000) && s.contains(2000));
+      assertUnit(s.index.size() == s.size());
+      assertUnit(s.index_bytes() > 0);
+   }  // teardown
+
+   // a range cut out whole is gone from the index too
+   void test_hashed_eraseRange()
+   {  // setup
+      custom::hashed_set <int> s;
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      // exercise
+      size_t num = s.erase_range(20, 80);
+      // verify
+      assertUnit(num == 60);
+      assertUnit(s.index.size() == 40);
+      assertUnit(s.find(50) == s.end());
+      assertUnit(!s.contains(20));
+      assertUnit(*s.find(80) == 80);
+      assertUnit(*s.find(19) == 19);
+   }  // teardown
+
+   // a copy gets its own index pointing into its own tree
+   void test_hashed_copy()
+   {  // setup
+      custom::hashed_set <int> sSrc { 50, 30, 70, 20, 40 };
+      custom::hashed_set <int> sDest { 10, 90 };
+      // exercise
+      sDest = sSrc;
+      sSrc.clear();
+      // verify
+      assertUnit(sDest.size() == 5);
+      assertUnit(sDest.index.size() == 5);
+      assertUnit(!sDest.contains(90));
+      assertUnit(*sDest.find(30) == 30);
+      assertUnit(*sDest.find(70) == 70);
+      assertUnit(sSrc.index.size() == 0);
+   }  // teardown
+
+   /***************************************
+    * FILTER
+    *    set::attach_filter()
+    ***************************************/
+
+   // a lookup the filter turns away never reaches the tree
+   void test_filter_missNoCompares()
+   {  // setup
+      custom::set <Spy, std::less<Spy>, std::allocator<Spy>, false, void, false, void, SpyHash> s
+         { Spy(50), Spy(30), Spy(70), Spy(20), Spy(40), Spy(60), Spy(80) };
+      s.attach_filter(7);
+      s.keep_filter_stats();
+      Spy spy45(45);
+      Spy spy40(40);
+      Spy::reset();
+      // exercise
+      auto itMissing = s.find(spy45);
+      auto itFound   = s.find(spy40);
+      // verify
+      assertUnit(itMissing == s.end());
+      assertUnit(itFound != s.end());
+      assertUnit(*itFound == Spy(40));
+      assertUnit(s.filter_stats().numQueries == 2);
+      assertUnit(s.filter_stats().numRejected == 1);
+      assertUnit(s.filter_stats().numBits == 512);
+      Spy::reset();
+      s.find(spy45);
+      assertUnit(Spy::numLessthan() == 0);
+   }  // teardown
+
+   // every miss is either turned away or counted as a false positive
+   void test_filter_stats()
+   {  // setup
+      custom::set <int> s;
+      for (int i = 0; i < 1000; i++)
+         s.insert(i * 2);
+      s.attach_filter(1000);
+      s.keep_filter_stats();
+      // exercise
+      bool found = true;
+      for (int i = 0; i < 1000; i++)
+      {
+         found = found && s.contains(i * 2);
+         found = found && !s.contains(i * 2 + 1);
+      }
+      // verify
+      auto stats = s.filter_stats();
+      assertUnit(found);
+      assertUnit(stats.numQueries == 2000);
+      assertUnit(stats.numRejected + stats.numFalsePositives == 1000);
+      assertUnit(stats.falsePositiveRate() < 0.05);
+      assertUnit(stats.numStale == 0);
+      assertUnit(stats.numBits >= 12000);
+   }  // teardown
+
+   // lookups are not counted unless asked for, so readers of a const
+   // set share nothing they write to
+   void test_filter_statsOff()
+   {  // setup
+      custom::set <int> s { 50, 30, 70, 20, 40 };
+      s.attach_filter(100);
+      const custom::set <int> & sConst = s;
+      // exercise
+      bool found = sConst.contains(30) && !sConst.contains(45) && sConst.find(99) == sConst.end();
+      auto statsOff = sConst.filter_stats();
+      s.keep_filter_stats();
+      sConst.contains(45);
+      auto statsOn = sConst.filter_stats();
+      // verify
+      assertUnit(found);
+      assertUnit(statsOff.numQueries == 0);
+      assertUnit(statsOff.numRejected == 0);
+      assertUnit(statsOff.numFalsePositives == 0);
+      assertUnit(statsOff.numBits >= 1200);
+      assertUnit(statsOn.numQueries == 1);
+   }  // teardown
+
+   // erased elements leave their bits until the filter is rebuilt
+   void test_filter_rebuild()
+   {  // setup
+      custom::set <int> s;
+      s.attach_filter(1000);
+      s.keep_filter_stats();
+      for (int i = 0; i < 1000; i++)
+         s.insert(i);
+      s.erase_range(0, 900);
+      size_t numStale = s.filter_stats().numStale;
+      for (int i = 0; i < 900; i++)
+         s.contains(i);
+      size_t numFalsePositives = s.filter_stats().numFalsePositives;
+      // exercise
+      s.rebuild_filter();
+      for (int i = 0; i < 900; i++)
+         s.contains(i);
+      // verify
+      assertUnit(numStale == 900);
+      assertUnit(numFalsePositives == 900);
+      assertUnit(s.filter_stats().numStale == 0);
+      assertUnit(s.filter_stats().numQueries == 900);
+      assertUnit(s.filter_stats().numFalsePositives < 90);
+      assertUnit(s.contains(950));
+      assertUnit(!s.contains(450));
+   }  // teardown
+
+   // a copy brings its own filter along
+   void test_filter_copy()
+   {  // setup
+      custom::set <int> sSrc { 50, 30, 70, 20, 40 };
+      sSrc.attach_filter(100);
+      sSrc.keep_filter_stats();
+      custom::set <int> sDest;
+      // exercise
+      sDest = sSrc;
+      sSrc.detach_filter();
+      sSrc.clear();
+      // verify
+      assertUnit(sDest.contains(30));
+      assertUnit(!sDest.contains(45));
+      assertUnit(sDest.filter_stats().numQueries == 2);
+      assertUnit(sSrc.filter_stats().numQueries == 0);
+      assertUnit(sSrc.pFilter == nullptr);
+   }  // teardown
+
+   // only the order of std::less is sure to agree with std::hash
+   void test_filter_defaultHash()
+   {  // setup, exercise, and verify
+      assertUnit((custom::set <int> ::Filter::enabled));
+      assertUnit((custom::set <int, std::less<>> ::Filter::enabled));
+      assertUnit((!custom::set <int, std::greater<int>> ::Filter::enabled));
+      assertUnit((!custom::set <std::string, CaseBlindLess> ::Filter::enabled));
+   }  // teardown
+
+   // a hash that agrees with the order never turns away what is there
+   void test_filter_caseBlind()
+   {  // setup
+      custom::set <std::string, CaseBlindLess, std::allocator<std::string>,
+                   false, void, false, void, CaseBlindHash> s { "abc", "Def", "GHI" };
+      s.attach_filter(10);
+      // exercise
+      auto it = s.find("ABC");
+      // verify
+      assertUnit(it != s.end());
+      assertUnit(*it == "abc");
+      assertUnit(s.contains("def"));
+      assertUnit(s.contains("ghi"));
+      assertUnit(!s.contains("jkl"));
+   }  // teardown
+
+   // order strings without regard to case
+   struct CaseBlindLess
+   {
+      bool operator () (const std::string & lhs, const std::string & rhs) const
+      {
+         return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+            [](char a, char b) { return std::tolower((unsigned char)a) < std::tolower((unsigned char)b); });
+      }
+   };
+   struct CaseBlindHash
+   {
+      size_t operator () (const std::string & str) const
+      {
+         std::string lower(str);
+         for (char & c : lower)
+            c = (char)std::tolower((unsigned char)c);
+         return std::hash<std::string>()(lower);
+      }
+   };
+
+   /***************************************
+    * AGGREGATE
+    *    set::aggregate()
+    ***************************************/
+
+   // objects ordered by ID, summarized by their size
+   struct Object
+   {
+      int id;
+      long long bytes;
+      bool operator < (const Object & rhs) const { return id < rhs.id; }
+   };
+   struct TotalBytes
+   {
+      using value_type = long long;
+      static long long identity()                { return 0;         }
+      static long long value(const Object & obj) { return obj.bytes; }
+      static long long combine(long long lhs, long long rhs) { return lhs + rhs; }
+   };
+
+   // total bytes of all objects with an ID in [a, b)
+   void test_aggregate_bytes()
+   {  // setup
+      custom::aggregate_set <Object, TotalBytes> s;
+      for (int id = 0; id < 100; id++)
+         s.insert(Object { id, 1000LL * id });
+      s.erase(Object { 50, 0 });
+      // exercise and verify
+      assertUnit(s.aggregate(Object { 10, 0 }, Object { 20, 0 }) == 145000);  // 10 + ... + 19
+      assertUnit(s.aggregate(Object { 49, 0 }, Object { 52, 0 }) == 100000);  // 49 + 51
+      assertUnit(s.aggregate(Object { 200, 0 }, Object { 300, 0 }) == 0);
+   }  // teardown
+
+   // the smallest and largest of a range
+   void test_aggregate_minMax()
+   {  // setup
+      custom::aggregate_set <int, custom::min_of<int>> sMin { 20, 30, 40, 50, 60, 70, 80 };
+      custom::aggregate_set <int, custom::max_of<int>> sMax { 20, 30, 40, 50, 60, 70, 80 };
+      // exercise and verify
+      assertUnit(sMin.aggregate(35, 75) == 40);
+      assertUnit(sMax.aggregate(35, 75) == 70);
+      assertUnit(sMin.aggregate(81, 99) == std::numeric_limits<int>::max());
+   }  // teardown
+
+   // the set holds exactly these elements, in this order
+   void assertSetIsParameters(const custom::set <int> & s, const int * expected, size_t num,
+                              int line, const char* function)
+   {
+      assertIndirect(s.size() == num);
+      size_t i = 0;
+      for (auto it = s.begin(); it != s.end() && i < num; ++it, i++)
+         assertIndirect(*it == expected[i]);
+      assertIndirect(i == num);
+   }
+
+   // order a Spy against a bare int without building a Spy
+   struct SpyLess
+   {
+      using is_transparent = void;
+      bool operator()(const Spy & lhs, const Spy & rhs) const { return lhs < rhs;       }
+      bool operator()(const Spy & lhs, int rhs)         const { return lhs.get() < rhs; }
+      bool operator()(int lhs, const Spy & rhs)         const { return lhs < rhs.get(); }
+   };
+
+   /***************************************
+    * ALLOCATOR
+    *    custom::pmr::set
+    ***************************************/
+
+   // a memory resource that counts what passes through it
+   class CountingResource : public std::pmr::memory_resource
+   {
+   public:
+      int numAllocate = 0;
+      int numDeallocate = 0;
+   private:
+      void * do_allocate(size_t bytes, size_t alignment) override
+      {
+         numAllocate++;
+         return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+      }
+      void do_deallocate(void * p, size_t bytes, size_t alignment) override
+      {
+         numDeallocate++;
+         std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+      }
+      bool do_is_equal(const std::pmr::memory_resource & rhs) const noexcept override
+      {
+         return this == &rhs;
+      }
+   };
+
+   // every node comes from and goes back to the set's resource
+   void test_allocator_resource()
+   {  // setup
+      CountingResource resource;
+      {
+         custom::pmr::set <int> s(&resource);
+         // exercise
+         for (int i = 0; i < 10; i++)
+            s.insert(i);
+         s.erase(5);
+         // verify
+         assertUnit(s.size() == 9);
+         assertUnit(s.get_allocator().resource() == &resource);
+         assertUnit(resource.numAllocate == 10);
+         assertUnit(resource.numDeallocate == 1);
+      }
+      assertUnit(resource.numAllocate == 10);
+      assertUnit(resource.numDeallocate == 10);
+   }  // teardown
+
+   // a set living entirely in a stack buffer
+   void test_allocator_monotonic()
+   {  // setup
+      char buffer[4096];
+      std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer),
+                                                   std::pmr::null_memory_resource());
+      custom::pmr::set <int> s(&resource);
+      // exercise
+      for (int i = 20; i > 0; i--)
+         s.insert(i);
+      // verify
+      assertUnit(s.size() == 20);
+      int expected = 1;
+      for (auto it = s.begin(); it != s.end(); ++it, ++expected)
+         assertUnit(*it == expected);
+      assertUnit(expected == 21);
+   }  // teardown
+
    /*************************************************************
     * SETUP STANDARD FIXTURE
     *                (50b)
@@ -3471,6 +4864,7 @@ public:
       // now assign everything to the bst
       s.bst.root = p50;
       s.bst.numElements = 7;
+      s.bst.resetEnds();
    }
 
    /*************************************************************